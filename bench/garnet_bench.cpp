@@ -0,0 +1,530 @@
+// Garnetのプログラムを決まった組で実行し、実行時間や資源の使用量を測る
+// 結果はJSONに書き出せ、前に書き出したJSONを基準として、閾値を超えて悪くなった指標があれば失敗する
+// 解析から実行までを同じプロセスの中で行うので、プロセスの起動にかかる分は含まない
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "driver.hpp"
+#include "interpreter/bytecode/compiler.hpp"
+#include "interpreter/bytecode/vm.hpp"
+#include "interpreter/exceptions.hpp"
+#include "interpreter/interpreter.hpp"
+#include "interpreter/optimizer.hpp"
+#include "libs/utils/format.hpp"  // NOLINT(clang-diagnostic-unused-header)
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#ifndef GARNET_SOURCE_DIR
+#define GARNET_SOURCE_DIR "."
+#endif
+
+namespace {
+// operator newを置き換えて、確保の回数と大きさを数える
+std::atomic<std::uint64_t> allocation_count = 0;
+std::atomic<std::uint64_t> allocated_bytes = 0;
+
+void* allocate(std::size_t size, std::size_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+    void* ptr = alignment <= alignof(std::max_align_t)
+                    ? std::malloc(size)
+                    : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+}  // namespace
+
+void* operator new(std::size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+namespace {
+namespace bpo = boost::program_options;
+
+// RUNは解析から実行まで、SCANは字句解析だけ、PARSEは構文解析までを行う
+enum class Mode { RUN, SCAN, PARSE };
+struct Program {
+    std::string_view name;
+    // ソースのディレクトリからの相対パス。空なら、生成した数MBのソースを使う
+    std::string_view path;
+    Mode mode = Mode::RUN;
+};
+constexpr Program PROGRAMS[] = {
+    {"tarai", "test/tarai.grn"},
+    {"fizzbuzz", "bench/programs/fizzbuzz.grn"},
+    {"loops", "bench/programs/loops.grn"},
+    {"string_concat", "bench/programs/string_concat.grn"},
+    {"deep_recursion", "bench/programs/deep_recursion.grn"},
+    {"lexer", "", Mode::SCAN},
+    {"parser", "", Mode::PARSE},
+};
+
+struct Result {
+    std::string name;
+    // 繰り返した中で最短と中央値
+    double wall_ms;
+    double wall_ms_median;
+    // 計数器を使えなければ無い
+    std::optional<std::uint64_t> instructions;
+    std::uint64_t peak_rss_kb;
+    std::uint64_t allocations;
+    std::uint64_t allocated_bytes;
+    // 生成したソースを読んだときの、最短の回のソースの処理速度
+    std::optional<double> mb_per_s;
+};
+
+// 利用者空間で実行した命令数の計数器。Linuxのperf_event_openが使えるときだけ数える
+class InstructionCounter {
+    int fd_ = -1;
+
+   public:
+    InstructionCounter() {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    InstructionCounter(const InstructionCounter&) = delete;
+    ~InstructionCounter() {
+#if defined(__unix__)
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+    bool is_available() const { return fd_ >= 0; }
+    void start() {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    std::optional<std::uint64_t> stop() {
+#if defined(__linux__)
+        std::uint64_t count = 0;
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &count, sizeof(count)) == sizeof(count)) {
+                return count;
+            }
+        }
+#endif
+        return std::nullopt;
+    }
+};
+
+// 最大の常駐メモリ量を今の量に戻す。Linuxでなければ何もせず、プロセス全体での最大になる
+void reset_peak_rss() {
+#if defined(__linux__)
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+std::uint64_t peak_rss_kb() {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.starts_with("VmHWM:")) {
+            return std::stoull(line.substr(6));
+        }
+    }
+#endif
+#if defined(__unix__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+// 実行中のプログラムの出力を捨てる
+class SilenceStdout {
+#if defined(__unix__)
+    int saved_ = -1;
+#endif
+
+   public:
+    SilenceStdout() {
+#if defined(__unix__)
+        std::fflush(stdout);
+        saved_ = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+#endif
+    }
+    SilenceStdout(const SilenceStdout&) = delete;
+    ~SilenceStdout() {
+#if defined(__unix__)
+        std::fflush(stdout);
+        dup2(saved_, STDOUT_FILENO);
+        close(saved_);
+#endif
+    }
+};
+
+// 字句解析と構文解析の速さを測るためのソースを、megabytesMBほど書く
+// 識別子、整数、小数、文字列、コメントを満遍なく含める
+std::uintmax_t generate_source(const std::filesystem::path& path, std::size_t megabytes) {
+    std::ofstream out(path);
+    std::size_t written = 0;
+    for (std::size_t i = 0; written < megabytes * 1000 * 1000; i++) {
+        auto function = fmt::format(
+            "# generated function {0}\n"
+            "func function_{0}(let count: i64, let ratio: f64) -> i64 {{\n"
+            "    var message: str = \"message number {0} with some text\";\n"
+            "    var total: i64 = count * {0} + 1234567;\n"
+            "    var scaled: f64 = ratio / 3.14159 + {0}.25;\n"
+            "    if (total > 100000 and scaled <= 2.5) {{\n"
+            "        return total - {0};\n"
+            "    }}\n"
+            "    return total;\n"
+            "}}\n",
+            i);
+        out << function;
+        written += function.size();
+    }
+    out << "func main(let argc: i64) -> void {\n}\n";
+    out.close();
+    return std::filesystem::file_size(path);
+}
+
+// 一度だけ実行する。解析に失敗したら投げる
+void run_once(const std::string& path, const std::string& engine, Mode mode) {
+    Garnet::Driver drv;
+    if (mode == Mode::SCAN) {
+        drv.scan(path);
+        return;
+    }
+    if (drv.parse(path) != 0) {
+        throw std::runtime_error(fmt::format("failed to parse {}", path));
+    }
+    if (mode == Mode::PARSE) {
+        return;
+    }
+    auto ast = Garnet::interpreter::Optimizer().optimize(drv.result());
+    if (engine == "vm") {
+        auto program = Garnet::interpreter::bytecode::Compiler().compile(*ast);
+        Garnet::interpreter::bytecode::VirtualMachine().run(program);
+    } else {
+        Garnet::interpreter::Interpreter interpreter;
+        ast->accept(interpreter);
+    }
+}
+
+Result measure(const Program& program, const std::string& path, const std::string& engine, std::size_t repeat,
+               InstructionCounter& counter) {
+    Result result;
+    result.name = program.name;
+    std::vector<double> times;
+    // 一度目は計測せず、ファイルや名前の表を温めるのに使う
+    {
+        SilenceStdout silence;
+        run_once(path, engine, program.mode);
+    }
+    reset_peak_rss();
+    for (std::size_t i = 0; i < repeat; i++) {
+        SilenceStdout silence;
+        auto allocations_before = allocation_count.load(std::memory_order_relaxed);
+        auto bytes_before = allocated_bytes.load(std::memory_order_relaxed);
+        counter.start();
+        auto begin = std::chrono::steady_clock::now();
+        run_once(path, engine, program.mode);
+        auto end = std::chrono::steady_clock::now();
+        auto instructions = counter.stop();
+        times.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+        // 確保の回数と命令数はほぼ変わらないので、最小の回を採る
+        auto allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+        auto bytes = allocated_bytes.load(std::memory_order_relaxed) - bytes_before;
+        if (i == 0 || allocations < result.allocations) {
+            result.allocations = allocations;
+            result.allocated_bytes = bytes;
+        }
+        if (instructions.has_value() && (not result.instructions.has_value() || instructions < result.instructions)) {
+            result.instructions = instructions;
+        }
+    }
+    result.peak_rss_kb = peak_rss_kb();
+    std::ranges::sort(times);
+    result.wall_ms = times.front();
+    result.wall_ms_median = times[times.size() / 2];
+    return result;
+}
+
+// 結果は一つのプログラムを一行に書く。基準の読み込みはこの形式だけを前提にしている
+void write_json(std::ostream& out, const std::vector<Result>& results, const std::string& engine) {
+    fmt::println(out, "{{");
+    fmt::println(out, "  \"engine\": \"{}\",", engine);
+    fmt::println(out, "  \"programs\": [");
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        fmt::println(out,
+                     "    {{\"name\": \"{}\", \"wall_ms\": {:.3f}, \"wall_ms_median\": {:.3f}, \"instructions\": {}, "
+                     "\"peak_rss_kb\": {}, \"allocations\": {}, \"allocated_bytes\": {}, \"mb_per_s\": {}}}{}",
+                     result.name, result.wall_ms, result.wall_ms_median,
+                     result.instructions.has_value() ? std::to_string(*result.instructions) : "null",
+                     result.peak_rss_kb, result.allocations, result.allocated_bytes,
+                     result.mb_per_s.has_value() ? fmt::format("{:.3f}", *result.mb_per_s) : "null",
+                     i + 1 == results.size() ? "" : ",");
+    }
+    fmt::println(out, "  ]");
+    fmt::println(out, "}}");
+}
+
+// 一行から`"key": 数値`の値を読む。無いかnullなら無い
+std::optional<double> find_number(std::string_view line, std::string_view key) {
+    auto pattern = fmt::format("\"{}\": ", key);
+    auto pos = line.find(pattern);
+    if (pos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    auto value = line.substr(pos + pattern.size());
+    if (value.starts_with("null")) {
+        return std::nullopt;
+    }
+    return std::strtod(std::string(value.substr(0, value.find_first_of(",}"))).c_str(), nullptr);
+}
+std::optional<std::string> find_string(std::string_view line, std::string_view key) {
+    auto pattern = fmt::format("\"{}\": \"", key);
+    auto pos = line.find(pattern);
+    if (pos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    auto value = line.substr(pos + pattern.size());
+    return std::string(value.substr(0, value.find('"')));
+}
+
+// プログラムの名前から、指標の名前と値の組を引く
+using Baseline = std::unordered_map<std::string, std::unordered_map<std::string, double>>;
+Baseline read_baseline(const std::string& filename) {
+    std::ifstream file(filename);
+    if (not file) {
+        throw std::runtime_error(fmt::format("cannot open baseline {}", filename));
+    }
+    Baseline baseline;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto name = find_string(line, "name");
+        if (not name.has_value()) {
+            continue;
+        }
+        for (auto key : {"wall_ms", "instructions", "peak_rss_kb", "allocations"}) {
+            if (auto value = find_number(line, key); value.has_value()) {
+                baseline[*name][key] = *value;
+            }
+        }
+    }
+    return baseline;
+}
+
+// 基準より閾値(%)を超えて大きくなった指標を報告し、その数を返す
+std::size_t compare(const std::vector<Result>& results, const Baseline& baseline,
+                    const std::unordered_map<std::string, double>& thresholds) {
+    std::size_t regressions = 0;
+    fmt::println("{:<16} {:<14} {:>14} {:>14} {:>9}", "program", "metric", "baseline", "current", "change");
+    for (const auto& result : results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end()) {
+            fmt::println("{:<16} (not in baseline)", result.name);
+            continue;
+        }
+        std::unordered_map<std::string, std::optional<double>> current = {
+            {"wall_ms", result.wall_ms},
+            {"instructions", result.instructions.transform([](auto value) { return static_cast<double>(value); })},
+            {"peak_rss_kb", static_cast<double>(result.peak_rss_kb)},
+            {"allocations", static_cast<double>(result.allocations)},
+        };
+        for (auto key : {"wall_ms", "instructions", "peak_rss_kb", "allocations"}) {
+            auto base = it->second.find(key);
+            auto value = current[key];
+            if (base == it->second.end() || not value.has_value() || base->second <= 0) {
+                continue;
+            }
+            auto change = (*value / base->second - 1) * 100;
+            bool is_regression = change > thresholds.at(key);
+            regressions += is_regression;
+            fmt::println("{:<16} {:<14} {:>14.3f} {:>14.3f} {:>+8.1f}%{}", result.name, key, base->second, *value,
+                         change, is_regression ? "  REGRESSION" : "");
+        }
+    }
+    return regressions;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bpo::positional_options_description pos;
+    pos.add("program", -1);
+    bpo::options_description opt;
+    opt.add_options()("help,h", "show this help")(
+        "engine", bpo::value<std::string>()->default_value("tree"), "execution engine (tree or vm)")(
+        "repeat", bpo::value<std::size_t>()->default_value(5), "number of measured runs of each program")(
+        "source-dir", bpo::value<std::string>()->default_value(GARNET_SOURCE_DIR),
+        "root of the Garnet source tree containing the programs")(
+        "json", bpo::value<std::string>(), "write the results as JSON to the given file")(
+        "baseline", bpo::value<std::string>(), "compare the results with JSON written by an earlier run")(
+        "time-threshold", bpo::value<double>()->default_value(10), "allowed increase of wall time in percent")(
+        "instructions-threshold", bpo::value<double>()->default_value(5),
+        "allowed increase of instructions retired in percent")(
+        "rss-threshold", bpo::value<double>()->default_value(10), "allowed increase of peak RSS in percent")(
+        "allocations-threshold", bpo::value<double>()->default_value(5),
+        "allowed increase of allocation count in percent")(
+        "source-mb", bpo::value<std::size_t>()->default_value(8),
+        "size in megabytes of the source generated for the lexer and parser")(
+        "program", bpo::value<std::vector<std::string>>(), "names of programs to run (all if omitted)");
+    bpo::variables_map varmap;
+    bpo::store(bpo::command_line_parser(argc, argv).options(opt).positional(pos).run(), varmap);
+    if (varmap.contains("help")) {
+        std::cout << opt;
+        fmt::print("programs:");
+        for (const auto& program : PROGRAMS) {
+            fmt::print(" {}", program.name);
+        }
+        fmt::println("");
+        return 0;
+    }
+    bpo::notify(varmap);
+    const auto& engine = varmap["engine"].as<std::string>();
+    if (engine != "tree" and engine != "vm") {
+        fmt::println(std::cerr, "unknown engine: {}", engine);
+        return 1;
+    }
+    auto repeat = std::max<std::size_t>(varmap["repeat"].as<std::size_t>(), 1);
+
+    std::vector<Program> selected;
+    if (varmap.contains("program")) {
+        for (const auto& name : varmap["program"].as<std::vector<std::string>>()) {
+            auto it = std::ranges::find(PROGRAMS, name, &Program::name);
+            if (it == std::ranges::end(PROGRAMS)) {
+                fmt::println(std::cerr, "unknown program: {}", name);
+                return 1;
+            }
+            selected.push_back(*it);
+        }
+    } else {
+        selected.assign(std::ranges::begin(PROGRAMS), std::ranges::end(PROGRAMS));
+    }
+
+    InstructionCounter counter;
+    if (not counter.is_available()) {
+        fmt::println(std::cerr, "instructions retired are not available on this system");
+    }
+    // 字句解析と構文解析には、生成したソースを一時ファイルに書いて使う
+    std::filesystem::path generated = std::filesystem::temp_directory_path() / "garnet_bench_source.grn";
+    std::uintmax_t generated_size = 0;
+    if (std::ranges::any_of(selected, [](const auto& program) { return program.path.empty(); })) {
+        generated_size = generate_source(generated, varmap["source-mb"].as<std::size_t>());
+    }
+    std::vector<Result> results;
+    fmt::println("{:<16} {:>10} {:>10} {:>14} {:>10} {:>12} {:>14}", "program", "min ms", "median ms", "instructions",
+                 "peak KiB", "allocations", "bytes");
+    for (const auto& program : selected) {
+        auto path = program.path.empty()
+                        ? generated.string()
+                        : (std::filesystem::path(varmap["source-dir"].as<std::string>()) / program.path).string();
+        try {
+            results.push_back(measure(program, path, engine, repeat, counter));
+            if (program.path.empty()) {
+                results.back().mb_per_s = static_cast<double>(generated_size) / 1e3 / results.back().wall_ms;
+            }
+        } catch (Garnet::interpreter::InterpreterError& e) {
+            auto loc = e.location();
+            fmt::println(std::cerr, "{}: interpreter error at {}:{}:{}: {}", program.name, loc.begin.source_file(),
+                         loc.begin.line, loc.begin.column, e.what());
+            return 1;
+        } catch (std::exception& e) {
+            fmt::println(std::cerr, "{}: {}", program.name, e.what());
+            return 1;
+        }
+        const auto& result = results.back();
+        fmt::println("{:<16} {:>10.3f} {:>10.3f} {:>14} {:>10} {:>12} {:>14}", result.name, result.wall_ms,
+                     result.wall_ms_median,
+                     result.instructions.has_value() ? std::to_string(*result.instructions) : "-",
+                     result.peak_rss_kb, result.allocations, result.allocated_bytes);
+        if (result.mb_per_s.has_value()) {
+            fmt::println("{:<16} {:>10.1f} MB/s", "", *result.mb_per_s);
+        }
+    }
+    if (generated_size > 0) {
+        std::filesystem::remove(generated);
+    }
+
+    if (varmap.contains("json")) {
+        std::ofstream out(varmap["json"].as<std::string>());
+        write_json(out, results, engine);
+    }
+    if (varmap.contains("baseline")) {
+        Baseline baseline;
+        try {
+            baseline = read_baseline(varmap["baseline"].as<std::string>());
+        } catch (std::exception& e) {
+            fmt::println(std::cerr, "{}", e.what());
+            return 1;
+        }
+        auto regressions = compare(results, baseline,
+                                   {
+                                       {"wall_ms", varmap["time-threshold"].as<double>()},
+                                       {"instructions", varmap["instructions-threshold"].as<double>()},
+                                       {"peak_rss_kb", varmap["rss-threshold"].as<double>()},
+                                       {"allocations", varmap["allocations-threshold"].as<double>()},
+                                   });
+        if (regressions > 0) {
+            fmt::println(std::cerr, "{} regressions against the baseline", regressions);
+            return 1;
+        }
+    }
+    return 0;
+}
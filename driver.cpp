@@ -25,12 +25,19 @@
 #include <fmt/core.h>
 #include <fmt/ostream.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
+#include "mapped_file.hpp"
 #include "parser.hpp"
 #include "scanner.hpp"
 
@@ -50,10 +57,82 @@ int Driver::parse(const std::string& f) {
     scan_end();
     return res;
 }
+std::size_t Driver::scan(const std::string& f) {
+    file_ = f;
+    location_.initialize(&file_);
+    scan_begin();
+    std::size_t count = 0;
+    try {
+        while (lexer_->yylex(*this).kind() != yy::Parser::symbol_kind::S_YYEOF) {
+            count++;
+        }
+    } catch (...) {
+        scan_end();
+        throw;
+    }
+    scan_end();
+    return count;
+}
+int Driver::parse(const std::vector<std::string>& files) {
+    if (files.size() <= 1) {
+        return files.empty() ? 0 : parse(files.front());
+    }
+    // ファイルごとに別のDriver(とLexer、Parser)で解析する。識別子の登録はスレッドをまたいで安全
+    // エラーは各Driverに溜めておき、全て終わってから書く
+    std::vector<std::unique_ptr<Driver>> drivers;
+    std::vector<int> results(files.size());
+    // 開けなかったファイル。一つずつ解析したときと同じく、そのファイルまでのエラーを書いて終了する
+    std::vector<char> cannot_open(files.size(), false);
+    for (std::size_t i = 0; i < files.size(); i++) {
+        drivers.push_back(std::make_unique<Driver>());
+        drivers.back()->trace_parsing = trace_parsing;
+        drivers.back()->trace_scanning = trace_scanning;
+        drivers.back()->is_buffering_ = true;
+    }
+    std::atomic<std::size_t> next = 0;
+    {
+        auto thread_count = std::min<std::size_t>(files.size(), std::max(std::thread::hardware_concurrency(), 1u));
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < thread_count; t++) {
+            workers.emplace_back([&] {
+                for (auto i = next.fetch_add(1); i < files.size(); i = next.fetch_add(1)) {
+                    try {
+                        results[i] = drivers[i]->parse(files[i]);
+                    } catch (const std::system_error&) {
+                        cannot_open[i] = true;
+                    }
+                }
+            });
+        }
+    }
+    // どのスレッドが先に終わっても、エラーと宣言はコマンドラインの順に並べる
+    int res = 0;
+    for (std::size_t i = 0; i < files.size(); i++) {
+        report_(drivers[i]->diagnostics_);
+        if (cannot_open[i]) {
+            exit(EXIT_FAILURE);
+        }
+        for (const auto& decl : drivers[i]->result()->children()) {
+            result_->add_child(decl);
+        }
+        if (res == 0) {
+            res = results[i];
+        }
+    }
+    return res;
+}
+void Driver::report_(const std::string& text) {
+    if (is_buffering_) {
+        diagnostics_ += text;
+    } else {
+        fmt::print(stderr, "{}", text);
+    }
+}
 void Driver::print_error(const yy::location& loc, const std::string& msg) {
     std::ifstream file(file_);
     std::string line;
-    fmt::println(stderr, "{}: {}", fmt::streamed(loc), msg);
+    // 一つのエラーは、まとめて一度に書く
+    auto text = fmt::format("{}: {}\n", fmt::streamed(loc), msg);
     for (auto i = 1; i <= loc.begin.line - 1; i++) {
         std::getline(file, line);
     }
@@ -72,7 +151,8 @@ void Driver::print_error(const yy::location& loc, const std::string& msg) {
             }
         }
         colored = {colored_begin, colored_end};
-        fmt::println(stderr, "{}{}{}", pre_colored, fmt::styled(colored, fmt::fg(fmt::color::red)), post_colored);
+        text += fmt::format("{}{}{}\n", pre_colored, fmt::styled(colored, fmt::fg(fmt::color::red)), post_colored);
     }
+    report_(text);
 }
 }  // namespace Garnet
@@ -20,9 +20,11 @@
 
 #ifndef DRIVER_HH
 #define DRIVER_HH
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "compilation_unit.hpp"
 #include "parser.hpp"
@@ -32,6 +34,7 @@ class Lexer;
 }
 
 namespace Garnet {
+class MappedFile;
 // Conducting the whole scanning and parsing of Calc++.
 class Driver {
     friend Garnet::yy::Parser;
@@ -41,6 +44,8 @@ class Driver {
 
     // The name of the file being parsed.
     std::string file_;
+    // The contents of the file being parsed, mapped into memory.
+    std::unique_ptr<MappedFile> source_;
 
     // Handling the scanner.
     void scan_begin();
@@ -49,6 +54,12 @@ class Driver {
     // The token's location used by the scanner.
     yy::location location_;
 
+    // Whether to keep diagnostics in diagnostics_ instead of writing them to
+    // stderr, so that files parsed in parallel can report in a fixed order.
+    bool is_buffering_ = false;
+    std::string diagnostics_;
+    void report_(const std::string& text);
+
    public:
     Driver();
     ~Driver();
@@ -57,6 +68,11 @@ class Driver {
 
     // Run the parser on file F.  Return 0 on success.
     int parse(const std::string& f);
+    // Run the parser on each of FILES on its own thread, then add their
+    // top-level declarations in the order of FILES.  Return 0 if all succeeded.
+    int parse(const std::vector<std::string>& files);
+    // Run only the scanner on file F.  Return the number of tokens.
+    std::size_t scan(const std::string& f);
     // Whether to generate parser debug traces.
     bool trace_parsing;
 
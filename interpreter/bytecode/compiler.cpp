@@ -0,0 +1,514 @@
+#include "compiler.hpp"
+
+#include <fmt/core.h>
+
+#include <ranges>
+#include <typeinfo>
+
+#include "../interpreter.hpp"
+#include "compilation_unit.hpp"
+#include "concrete_decls.hpp"
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_statements.hpp"
+#include "error_nodes.hpp"
+namespace Garnet::interpreter::bytecode {
+namespace {
+// tree-walking interpreterが値を後で読む変数。被演算子そのものか、右辺が変数の代入式ならその変数
+const ast::VariableReference* late_variable(const ast::Expression* expr) {
+    if (const auto* variable = dynamic_cast<const ast::VariableReference*>(expr); variable != nullptr) {
+        return variable;
+    }
+    if (const auto* binary = dynamic_cast<const ast::BinaryOperator*>(expr);
+        binary != nullptr && binary->op() == ast::BinaryOperator::OperatorType::ASSIGN) {
+        return late_variable(binary->right().get());
+    }
+    return nullptr;
+}
+// 評価すると変数の値が変わりうる(代入か呼び出しを含む)
+bool may_assign(const ast::Expression* expr) {
+    if (dynamic_cast<const ast::FunctionCall*>(expr) != nullptr ||
+        dynamic_cast<const ast::CompoundAssign*>(expr) != nullptr) {
+        return true;
+    }
+    if (const auto* binary = dynamic_cast<const ast::BinaryOperator*>(expr); binary != nullptr) {
+        return binary->op() == ast::BinaryOperator::OperatorType::ASSIGN || may_assign(binary->left().get()) ||
+               may_assign(binary->right().get());
+    }
+    if (const auto* logical = dynamic_cast<const ast::LogicalOperator*>(expr); logical != nullptr) {
+        return may_assign(logical->left().get()) || may_assign(logical->right().get());
+    }
+    if (const auto* unary = dynamic_cast<const ast::UnaryOperator*>(expr); unary != nullptr) {
+        return may_assign(unary->operand().get());
+    }
+    return false;
+}
+}  // namespace
+Compiler::Compiler() {
+    auto& pool = SimpleFlyWeight::instance();
+    types_[pool.id("u8")] = type_tag_of<std::uint8_t>();
+    types_[pool.id("i8")] = type_tag_of<std::int8_t>();
+    types_[pool.id("u16")] = type_tag_of<std::uint16_t>();
+    types_[pool.id("i16")] = type_tag_of<std::int16_t>();
+    types_[pool.id("u32")] = type_tag_of<std::uint32_t>();
+    types_[pool.id("i32")] = type_tag_of<std::int32_t>();
+    types_[pool.id("u64")] = type_tag_of<std::uint64_t>();
+    types_[pool.id("i64")] = type_tag_of<std::int64_t>();
+    types_[pool.id("f32")] = type_tag_of<float>();
+    types_[pool.id("f64")] = type_tag_of<double>();
+    types_[pool.id("str")] = type_tag_of<SharedString>();
+    types_[pool.id("NilType")] = type_tag_of<NilType>();
+    types_[pool.id("void")] = type_tag_of<NilType>();
+}
+Program Compiler::compile(const ast::CompilationUnit& unit) {
+    Interpreter().check(unit);
+    unit.accept(*this);
+    return std::move(program_);
+}
+std::size_t Compiler::emit_(OpCode op, std::int32_t operand, location::SourceRegion location) {
+    auto& function = current_function_();
+    function.code.push_back({op, operand});
+    function.locations.push_back(location);
+    return function.code.size() - 1;
+}
+void Compiler::patch_(std::size_t index, std::size_t target) {
+    current_function_().code[index].operand = static_cast<std::int32_t>(target);
+}
+std::size_t Compiler::here_() const { return program_.functions[current_].code.size(); }
+std::int32_t Compiler::add_constant_(Value value) {
+    program_.constants.push_back(std::move(value));
+    return static_cast<std::int32_t>(program_.constants.size() - 1);
+}
+std::int32_t Compiler::add_error_(DeferredError::Kind kind, std::string message) {
+    program_.errors.push_back({kind, std::move(message)});
+    return static_cast<std::int32_t>(program_.errors.size() - 1);
+}
+std::optional<TypeTag> Compiler::lookup_type_(ast::SourceTypeIdentifier name) const {
+    auto pos = types_.find(name.source_id());
+    if (pos == types_.end()) {
+        return std::nullopt;
+    }
+    return pos->second;
+}
+Compiler::Slot Compiler::declare_global_(NameType name, Value initial) {
+    // 関数の再定義は新しい変数として名前を上書きする(既存のスロットはそのまま残る)
+    Slot slot = program_.globals.size();
+    program_.globals.push_back(std::move(initial));
+    globals_[name] = slot;
+    return slot;
+}
+std::optional<Compiler::Slot> Compiler::declare_local_(ast::SourceVariableIdentifier name,
+                                                       location::SourceRegion location) {
+    auto& scope = scopes_.back();
+    if (scope.names.contains(name.source_id())) {
+        emit_(OpCode::RAISE,
+              add_error_(DeferredError::Kind::REDECLARATION,
+                         fmt::format("variable {} is already declared in this scope.", name.source_name())),
+              location);
+        return std::nullopt;
+    }
+    Slot slot = next_slot_++;
+    scope.names[name.source_id()] = slot;
+    auto& function = current_function_();
+    function.local_count = std::max(function.local_count, next_slot_);
+    return slot;
+}
+void Compiler::push_scope_() { scopes_.push_back({.names = {}, .first_slot = next_slot_}); }
+void Compiler::pop_scope_() {
+    // ブロックを抜けたスロットは後続のブロックで再利用する
+    next_slot_ = scopes_.back().first_slot;
+    scopes_.pop_back();
+}
+void Compiler::reload_(const ast::VariableReference* variable, std::int32_t depth) {
+    variable->accept(*this);
+    emit_(OpCode::REPLACE, depth, variable->location());
+}
+void Compiler::emit_discarding_(const ast::Base* sentence) {
+    sentence->accept(*this);
+    if (dynamic_cast<const ast::Expression*>(sentence) != nullptr) {
+        emit_(OpCode::POP, 0, sentence->location());
+    }
+}
+void Compiler::register_builtin_(const std::string& name, Builtin builtin) {
+    auto name_id = SimpleFlyWeight::instance().id(name);
+    FunctionIndex index = program_.functions.size();
+    program_.functions.push_back({});
+    program_.functions.back().name_id = name_id;
+    program_.functions.back().builtin = builtin;
+    declare_global_(name_id, FunctionReference{.index = index, .key = static_cast<std::uint32_t>(name_id)});
+}
+
+void Compiler::visit(const ast::CompilationUnit* node) {
+    program_.entry = program_.functions.size();
+    program_.functions.push_back({});
+    current_ = program_.entry;
+    current_function_().name_id = SimpleFlyWeight::instance().id("<entry>");
+    current_function_().location = node->location();
+    register_builtin_("print", Builtin::PRINT);
+    register_builtin_("println", Builtin::PRINTLN);
+    for (const auto& child : node->children()) {
+        const auto& raw = *child;
+        if (typeid(raw) == typeid(ast::FunctionDef)) {
+            child->accept(*this);
+        } else if (typeid(raw) == typeid(ast::VariableDecl)) {
+            child->accept(*this);
+        }
+    }
+    auto location = node->location();
+    if (auto main = globals_.find(SimpleFlyWeight::instance().id("main")); main != globals_.end()) {
+        emit_(OpCode::LOAD_GLOBAL, main->second, location);
+        emit_(OpCode::PUSH_CONST, add_constant_(static_cast<std::int32_t>(0)), location);
+        emit_(OpCode::CALL, 1, location);
+        emit_(OpCode::POP, 0, location);
+    } else {
+        emit_(OpCode::RAISE, add_error_(DeferredError::Kind::NAME, "function 'main' is not defined"), location);
+    }
+    emit_(OpCode::HALT, 0, location);
+    for (auto [index, def] : pending_functions_) {
+        compile_function_(index, def);
+    }
+}
+void Compiler::visit(const ast::FunctionDef* node) {
+    auto name_id = node->info().name().source_id();
+    FunctionIndex index = program_.functions.size();
+    program_.functions.push_back({});
+    program_.functions.back().name_id = name_id;
+    program_.functions.back().location = node->location();
+    declare_global_(name_id, FunctionReference{.index = index, .key = static_cast<std::uint32_t>(name_id)});
+    // 本体は全てのグローバルな名前が揃ってからコンパイルする
+    pending_functions_.emplace_back(index, node);
+}
+void Compiler::compile_function_(FunctionIndex index, const ast::FunctionDef* node) {
+    current_ = index;
+    next_slot_ = 0;
+    push_scope_();
+    const auto& info = node->info();
+    for (const auto& arginfo : info.args()) {
+        auto type = lookup_type_(arginfo.type().name());
+        if (not type.has_value()) {
+            emit_(OpCode::RAISE,
+                  add_error_(DeferredError::Kind::NAME,
+                             fmt::format("type '{}' is not defined", arginfo.type().name().source_name())),
+                  arginfo.location());
+        }
+        current_function_().params.push_back(type.value_or(type_tag_of<NilType>()));
+        declare_local_(arginfo.name(), arginfo.location());
+    }
+    result_type_ = lookup_type_(info.result()->type().name());
+    current_function_().result = result_type_.value_or(type_tag_of<NilType>());
+    if (not result_type_.has_value()) {
+        emit_(OpCode::RAISE,
+              add_error_(DeferredError::Kind::NAME,
+                         fmt::format("type '{}' is not defined", info.result()->type().name().source_name())),
+              info.result()->location());
+    }
+    node->block()->accept(*this);
+    auto end = node->block()->location();
+    emit_(OpCode::PUSH_CONST, add_constant_(zero_value(result_type_.value_or(type_tag_of<NilType>()))), end);
+    emit_(OpCode::RETURN, 0, end);
+    pop_scope_();
+    result_type_ = std::nullopt;
+}
+void Compiler::visit(const ast::VariableDecl* node) {
+    auto location = node->location();
+    bool has_init = node->init().has_value();
+    if (has_init) {
+        node->init().value()->accept(*this);
+    }
+    auto type = lookup_type_(node->type());
+    if (not type.has_value()) {
+        emit_(OpCode::RAISE,
+              add_error_(DeferredError::Kind::NAME,
+                         fmt::format("type '{}' is not defined", node->type().source_name())),
+              location);
+        return;
+    }
+    // 初期化式の値は、tree-walking interpreterと同じく宣言した型に変換する
+    // 解釈器は変数宣言の位置を持たないので、再宣言や変換できないときのエラーも位置なしで報告する
+    auto push_initial_value = [&] {
+        if (has_init) {
+            emit_(OpCode::CONVERT, *type, {});
+        } else {
+            emit_(OpCode::PUSH_CONST, add_constant_(zero_value(*type)), location);
+        }
+    };
+    auto name = node->name();
+    if (scopes_.empty()) {
+        if (globals_.contains(name.source_id())) {
+            emit_(OpCode::RAISE,
+                  add_error_(DeferredError::Kind::REDECLARATION,
+                             fmt::format("variable {} is already declared in this scope.", name.source_name())),
+                  {});
+            return;
+        }
+        auto slot = declare_global_(name.source_id(), NilType{});
+        push_initial_value();
+        emit_(OpCode::STORE_GLOBAL, slot, location);
+    } else {
+        auto slot = declare_local_(name, {});
+        if (not slot.has_value()) {
+            return;
+        }
+        push_initial_value();
+        emit_(OpCode::STORE_LOCAL, *slot, location);
+    }
+}
+void Compiler::visit(const ast::TypeDecl*) {}
+void Compiler::visit(const ast::ErrorNode* node) {
+    emit_(OpCode::RAISE, add_error_(DeferredError::Kind::SYNTAX, "invalid node"), node->location());
+}
+void Compiler::visit(const ast::ErrorSentence* node) {
+    emit_(OpCode::RAISE, add_error_(DeferredError::Kind::SYNTAX, "invalid sentence"), node->location());
+}
+void Compiler::visit(const ast::ErrorExpression* node) {
+    emit_(OpCode::RAISE, add_error_(DeferredError::Kind::SYNTAX, "invalid expresssion"), node->location());
+}
+void Compiler::visit(const ast::ErrorStatement* node) {
+    emit_(OpCode::RAISE, add_error_(DeferredError::Kind::SYNTAX, "invalid statement"), node->location());
+}
+void Compiler::visit(const ast::BinaryOperator* node) {
+    auto location = node->location();
+    if (node->op() != ast::BinaryOperator::OperatorType::ASSIGN) {
+        node->left()->accept(*this);
+        node->right()->accept(*this);
+        if (const auto* variable = late_variable(node->left().get());
+            variable != nullptr && may_assign(node->right().get())) {
+            reload_(variable, 2);
+        }
+        emit_(OpCode::BINARY, static_cast<std::int32_t>(node->op()), location);
+        return;
+    }
+    auto target = std::dynamic_pointer_cast<ast::VariableReference>(node->left());
+    if (target == nullptr) {
+        node->left()->accept(*this);
+        node->right()->accept(*this);
+        emit_(OpCode::RAISE, add_error_(DeferredError::Kind::TYPE, "cannot assign to rvalue"), location);
+        return;
+    }
+    auto name = target->name().source_id();
+    for (const auto& scope : scopes_ | std::views::reverse) {
+        if (auto pos = scope.names.find(name); pos != scope.names.end()) {
+            node->right()->accept(*this);
+            emit_(OpCode::ASSIGN_LOCAL, pos->second, location);
+            return;
+        }
+    }
+    if (auto pos = globals_.find(name); pos != globals_.end()) {
+        node->right()->accept(*this);
+        emit_(OpCode::ASSIGN_GLOBAL, pos->second, location);
+        return;
+    }
+    // 未定義の名前はここで参照エラーになる
+    target->accept(*this);
+}
+void Compiler::visit(const ast::CompoundAssign* node) {
+    auto location = node->location();
+    node->target()->accept(*this);
+    node->value()->accept(*this);
+    if (const auto* variable = late_variable(node->target().get());
+        variable != nullptr && may_assign(node->value().get())) {
+        reload_(variable, 2);
+    }
+    emit_(OpCode::BINARY, static_cast<std::int32_t>(node->op()), location);
+    auto target = std::dynamic_pointer_cast<ast::VariableReference>(node->target());
+    if (target == nullptr) {
+        emit_(OpCode::RAISE, add_error_(DeferredError::Kind::TYPE, "cannot assign to rvalue"), location);
+        return;
+    }
+    // 名前が未定義ならtargetの読み込みで参照エラーになっている
+    auto name = target->name().source_id();
+    for (const auto& scope : scopes_ | std::views::reverse) {
+        if (auto pos = scope.names.find(name); pos != scope.names.end()) {
+            emit_(OpCode::ASSIGN_LOCAL, pos->second, location);
+            return;
+        }
+    }
+    if (auto pos = globals_.find(name); pos != globals_.end()) {
+        emit_(OpCode::ASSIGN_GLOBAL, pos->second, location);
+    }
+}
+void Compiler::visit(const ast::LogicalOperator* node) {
+    // 左辺で結果が決まれば、左辺の値を残して右辺を飛ばす
+    node->left()->accept(*this);
+    auto op = node->op() == ast::LogicalOperator::OperatorType::AND ? OpCode::SKIP_IF_FALSE : OpCode::SKIP_IF_TRUE;
+    auto end = emit_(op, 0, node->left()->location());
+    node->right()->accept(*this);
+    emit_(OpCode::CHECK_BOOL, 0, node->right()->location());
+    patch_(end, here_());
+}
+void Compiler::visit(const ast::UnaryOperator* node) {
+    node->operand()->accept(*this);
+    emit_(OpCode::UNARY, static_cast<std::int32_t>(node->op()), node->location());
+}
+void Compiler::visit(const ast::VariableReference* node) {
+    auto name = node->name().source_id();
+    for (const auto& scope : scopes_ | std::views::reverse) {
+        if (auto pos = scope.names.find(name); pos != scope.names.end()) {
+            emit_(OpCode::LOAD_LOCAL, pos->second, node->location());
+            return;
+        }
+    }
+    if (auto pos = globals_.find(name); pos != globals_.end()) {
+        emit_(OpCode::LOAD_GLOBAL, pos->second, node->location());
+        return;
+    }
+    emit_(OpCode::RAISE,
+          add_error_(DeferredError::Kind::NAME,
+                     fmt::format("variable '{}' is not defined", SimpleFlyWeight::instance().value(name))),
+          node->location());
+}
+void Compiler::visit(const ast::SignedIntegerLiteral* node) {
+    emit_(OpCode::PUSH_CONST, add_constant_(node->value()), node->location());
+}
+void Compiler::visit(const ast::UnsignedIntegerLiteral* node) {
+    emit_(OpCode::PUSH_CONST, add_constant_(node->value()), node->location());
+}
+void Compiler::visit(const ast::FloatingPointLiteral* node) {
+    emit_(OpCode::PUSH_CONST, add_constant_(node->value()), node->location());
+}
+void Compiler::visit(const ast::StringLiteral* node) {
+    emit_(OpCode::PUSH_CONST, add_constant_(SharedString(node->value())), node->location());
+}
+void Compiler::visit(const ast::BooleanLiteral* node) {
+    emit_(OpCode::PUSH_CONST, add_constant_(node->value()), node->location());
+}
+void Compiler::visit(const ast::NilLiteral* node) {
+    emit_(OpCode::PUSH_CONST, add_constant_(NilType{}), node->location());
+}
+void Compiler::visit(const ast::FunctionCall* node) { emit_call_(node, OpCode::CALL); }
+void Compiler::emit_call_(const ast::FunctionCall* node, OpCode op) {
+    node->callee()->accept(*this);
+    const auto& args = node->args();
+    for (const auto& arg : args) {
+        arg->accept(*this);
+    }
+    // 変数の実引数は、それより後の実引数が変数の値を変えうるなら、全て評価した後で読み直す
+    bool is_assigned_later = false;
+    for (auto i = args.size(); i-- > 0;) {
+        if (const auto* variable = late_variable(args[i].get()); variable != nullptr && is_assigned_later) {
+            reload_(variable, static_cast<std::int32_t>(args.size() - i));
+        }
+        is_assigned_later = is_assigned_later || may_assign(args[i].get());
+    }
+    emit_(op, static_cast<std::int32_t>(args.size()), node->location());
+}
+void Compiler::visit(const ast::VariableDeclStatement* node) {
+    for (const auto& child : node->children()) {
+        child->accept(*this);
+    }
+}
+void Compiler::visit(const ast::ReturnStatement* node) {
+    // TAIL_CALLがフレームを使い回さなかった場合は、続く命令で通常どおり返す
+    if (const auto* call = node->tail_call(); call != nullptr) {
+        emit_call_(call, OpCode::TAIL_CALL);
+    } else {
+        node->retval()->accept(*this);
+    }
+    emit_(OpCode::CONVERT, result_type_.value_or(type_tag_of<NilType>()), node->location());
+    emit_(OpCode::RETURN, 0, node->location());
+}
+void Compiler::visit(const ast::Block* node) {
+    push_scope_();
+    for (const auto& sentence : node->sentences()) {
+        emit_discarding_(sentence.get());
+    }
+    pop_scope_();
+}
+void Compiler::visit(const ast::LoopStatement* node) {
+    auto start = here_();
+    break_patches_.emplace_back();
+    node->block()->accept(*this);
+    emit_(OpCode::JUMP, static_cast<std::int32_t>(start), node->location());
+    for (auto index : break_patches_.back()) {
+        patch_(index, here_());
+    }
+    break_patches_.pop_back();
+}
+// 条件式はループの末尾に置き、一周あたりの分岐を一つにする
+// 条件がboolでないときはASSERTがTypeErrorを投げ、真ならループの先頭へ戻る
+void Compiler::visit(const ast::WhileStatement* node) {
+    auto check = emit_(OpCode::JUMP, 0, node->location());
+    auto start = here_();
+    break_patches_.emplace_back();
+    node->block()->accept(*this);
+    patch_(check, here_());
+    node->cond()->accept(*this);
+    emit_(OpCode::ASSERT, static_cast<std::int32_t>(start), node->cond()->location());
+    for (auto index : break_patches_.back()) {
+        patch_(index, here_());
+    }
+    break_patches_.pop_back();
+}
+void Compiler::visit(const ast::DoWhileStatement* node) {
+    auto start = here_();
+    break_patches_.emplace_back();
+    node->block()->accept(*this);
+    node->cond()->accept(*this);
+    emit_(OpCode::ASSERT, static_cast<std::int32_t>(start), node->cond()->location());
+    for (auto index : break_patches_.back()) {
+        patch_(index, here_());
+    }
+    break_patches_.pop_back();
+}
+void Compiler::visit(const ast::ForStatement* node) {
+    push_scope_();
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+    }
+    auto check = emit_(OpCode::JUMP, 0, node->location());
+    auto start = here_();
+    break_patches_.emplace_back();
+    node->block()->accept(*this);
+    if (node->update().has_value()) {
+        emit_discarding_(node->update().value().get());
+    }
+    patch_(check, here_());
+    if (node->cond().has_value()) {
+        node->cond().value()->accept(*this);
+        emit_(OpCode::ASSERT, static_cast<std::int32_t>(start), node->cond().value()->location());
+    } else {
+        emit_(OpCode::JUMP, static_cast<std::int32_t>(start), node->location());
+    }
+    for (auto index : break_patches_.back()) {
+        patch_(index, here_());
+    }
+    break_patches_.pop_back();
+    pop_scope_();
+}
+void Compiler::visit(const ast::BreakStatement* node) {
+    if (break_patches_.empty()) {
+        emit_(OpCode::RAISE, add_error_(DeferredError::Kind::SYNTAX, "break outside of loop"), node->location());
+        return;
+    }
+    break_patches_.back().push_back(emit_(OpCode::JUMP, 0, node->location()));
+}
+void Compiler::visit(const ast::IfStatement* node) {
+    std::vector<std::size_t> end_patches;
+    for (auto [cond, block] : node->cond_blocks()) {
+        if (cond == nullptr) {
+            block->accept(*this);
+            break;
+        }
+        cond->accept(*this);
+        auto next = emit_(OpCode::JUMP_IF_FALSE, 0, cond->location());
+        block->accept(*this);
+        end_patches.push_back(emit_(OpCode::JUMP, 0, node->location()));
+        patch_(next, here_());
+    }
+    for (auto index : end_patches) {
+        patch_(index, here_());
+    }
+}
+void Compiler::visit(const ast::AssertStatement* node) {
+    auto cond_loc = node->cond()->location();
+    node->cond()->accept(*this);
+    auto ok = emit_(OpCode::ASSERT, 0, cond_loc);
+    if (node->msg().has_value()) {
+        node->msg().value()->accept(*this);
+        emit_(OpCode::ASSERT_FAIL, 1, cond_loc);
+    } else {
+        emit_(OpCode::ASSERT_FAIL, 0, cond_loc);
+    }
+    patch_(ok, here_());
+}
+}  // namespace Garnet::interpreter::bytecode
@@ -0,0 +1,97 @@
+#ifndef GARNET_INTERPRETER_BYTECODE_COMPILER
+#define GARNET_INTERPRETER_BYTECODE_COMPILER
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+#include "concrete_source_identifiers.hpp"
+#include "flyweight.hpp"
+#include "location.hpp"
+#include "program.hpp"
+#include "visitor/visitor.hpp"
+namespace Garnet::interpreter::bytecode {
+// ast::CompilationUnitをVM用の命令列に変換する
+// 名前解決はコンパイル時に済ませ、変数はフレーム内のスロット番号で参照する
+// tree-walking interpreterと同じく、変数の被演算子や実引数は、後の被演算子や実引数を評価した後の値を使う
+class Compiler : public ast::Visitor {
+    using NameType = SimpleFlyWeight::id_type;
+    using Slot = std::uint32_t;
+
+    Program program_;
+    FunctionIndex current_ = 0;
+    Function& current_function_() { return program_.functions[current_]; }
+
+    std::unordered_map<NameType, TypeTag> types_;
+    std::unordered_map<NameType, Slot> globals_;
+
+    struct Scope {
+        std::unordered_map<NameType, Slot> names;
+        Slot first_slot;
+    };
+    std::vector<Scope> scopes_;
+    Slot next_slot_ = 0;
+    std::optional<TypeTag> result_type_;
+
+    std::vector<std::vector<std::size_t>> break_patches_;
+    std::vector<std::pair<FunctionIndex, const ast::FunctionDef*>> pending_functions_;
+
+    std::size_t emit_(OpCode op, std::int32_t operand, location::SourceRegion location);
+    void patch_(std::size_t index, std::size_t target);
+    std::size_t here_() const;
+    std::int32_t add_constant_(Value value);
+    std::int32_t add_error_(DeferredError::Kind kind, std::string message);
+
+    std::optional<TypeTag> lookup_type_(ast::SourceTypeIdentifier name) const;
+    Slot declare_global_(NameType name, Value initial);
+    std::optional<Slot> declare_local_(ast::SourceVariableIdentifier name, location::SourceRegion location);
+    void push_scope_();
+    void pop_scope_();
+    void emit_discarding_(const ast::Base* sentence);
+    void emit_call_(const ast::FunctionCall* node, OpCode op);
+    // 先に積んだ変数の値を、その変数を読み直した値で置き換える(depthはREPLACEのoperand)
+    void reload_(const ast::VariableReference* variable, std::int32_t depth);
+
+    void register_builtin_(const std::string& name, Builtin builtin);
+    void compile_function_(FunctionIndex index, const ast::FunctionDef* node);
+
+   public:
+    Compiler();
+    Program compile(const ast::CompilationUnit& unit);
+
+    virtual void visit(const ast::VariableDecl*) override;
+    virtual void visit(const ast::TypeDecl*) override;
+    virtual void visit(const ast::ErrorNode*) override;
+    virtual void visit(const ast::ErrorSentence*) override;
+    virtual void visit(const ast::ErrorExpression*) override;
+    virtual void visit(const ast::ErrorStatement*) override;
+    virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
+    virtual void visit(const ast::UnaryOperator*) override;
+    virtual void visit(const ast::VariableReference*) override;
+    virtual void visit(const ast::SignedIntegerLiteral*) override;
+    virtual void visit(const ast::UnsignedIntegerLiteral*) override;
+    virtual void visit(const ast::FloatingPointLiteral*) override;
+    virtual void visit(const ast::StringLiteral*) override;
+    virtual void visit(const ast::FunctionCall*) override;
+    virtual void visit(const ast::CompilationUnit*) override;
+    virtual void visit(const ast::FunctionDef*) override;
+    virtual void visit(const ast::VariableDeclStatement*) override;
+    virtual void visit(const ast::ReturnStatement*) override;
+    virtual void visit(const ast::Block*) override;
+    virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
+    virtual void visit(const ast::BreakStatement*) override;
+    virtual void visit(const ast::IfStatement*) override;
+    virtual void visit(const ast::AssertStatement*) override;
+    virtual void visit(const ast::BooleanLiteral*) override;
+    virtual void visit(const ast::NilLiteral*) override;
+};
+}  // namespace Garnet::interpreter::bytecode
+#endif
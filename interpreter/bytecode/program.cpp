@@ -0,0 +1,47 @@
+#include "program.hpp"
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <fmt/std.h>
+
+#include <magic_enum_format.hpp>
+
+#include "concrete_expressions.hpp"
+#include "format.hpp"  // NOLINT
+namespace Garnet::interpreter::bytecode {
+std::string Function::to_string() const {
+    std::string result = fmt::format("function {} (params: {}, locals: {})\n", SimpleFlyWeight::instance().value(name_id),
+                                     params, local_count);
+    auto out = std::back_inserter(result);
+    for (std::size_t i = 0; i < code.size(); i++) {
+        auto [op, operand] = code[i];
+        switch (op) {
+            case OpCode::BINARY:
+                fmt::format_to(out, "{:>6} {:<14}{}\n", i, op, static_cast<ast::BinaryOperator::OperatorType>(operand));
+                break;
+            case OpCode::UNARY:
+                fmt::format_to(out, "{:>6} {:<14}{}\n", i, op, static_cast<ast::UnaryOperator::OperatorType>(operand));
+                break;
+            default:
+                fmt::format_to(out, "{:>6} {:<14}{}\n", i, op, operand);
+                break;
+        }
+    }
+    return result;
+}
+std::string Program::to_string() const {
+    std::string result;
+    auto out = std::back_inserter(result);
+    fmt::format_to(out, "constants:\n");
+    for (std::size_t i = 0; i < constants.size(); i++) {
+        std::visit([&](const auto& value) { fmt::format_to(out, "{:>6} {}\n", i, value); }, constants[i]);
+    }
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        if (functions[i].builtin != Builtin::NONE) {
+            continue;
+        }
+        fmt::format_to(out, "[{}] {}", i, functions[i]);
+    }
+    return result;
+}
+}  // namespace Garnet::interpreter::bytecode
@@ -0,0 +1,78 @@
+#ifndef GARNET_INTERPRETER_BYTECODE_PROGRAM
+#define GARNET_INTERPRETER_BYTECODE_PROGRAM
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "flyweight.hpp"
+#include "format_support.hpp"
+#include "location.hpp"
+#include "value.hpp"
+namespace Garnet::interpreter::bytecode {
+enum class OpCode : std::uint8_t {
+    PUSH_CONST,     // constants[operand]を積む
+    POP,            // 捨てる
+    REPLACE,        // 取り出して、その下のoperand番目(すぐ下が1)の値と置き換える
+    LOAD_LOCAL,     // locals[operand]を積む
+    STORE_LOCAL,    // 取り出してlocals[operand]にそのまま置く(宣言用)
+    ASSIGN_LOCAL,   // locals[operand]の型に変換して代入する。右辺値はスタックに残す
+    LOAD_GLOBAL,    // globals[operand]を積む
+    STORE_GLOBAL,   // 取り出してglobals[operand]にそのまま置く(宣言用)
+    ASSIGN_GLOBAL,  // globals[operand]の型に変換して代入する。右辺値はスタックに残す
+    CONVERT,        // TypeTag operandへ変換する
+    BINARY,         // 二項演算。operandはast::BinaryOperator::OperatorType
+    UNARY,          // 単項演算。operandはast::UnaryOperator::OperatorType
+    JUMP,           // operandへ飛ぶ
+    JUMP_IF_FALSE,  // 取り出してboolに変換し、falseならoperandへ飛ぶ
+    SKIP_IF_FALSE,  // boolか検査し、falseなら残してoperandへ飛ぶ。trueなら取り出す(andの左辺)
+    SKIP_IF_TRUE,   // boolか検査し、trueなら残してoperandへ飛ぶ。falseなら取り出す(orの左辺)
+    CHECK_BOOL,     // 一番上の値がboolか検査する(and/orの右辺)
+    ASSERT,         // 取り出してboolか検査し、trueならoperandへ飛ぶ
+    ASSERT_FAIL,    // AssertionErrorを投げる。operandが1ならメッセージを取り出して使う
+    CALL,           // operand個の引数とその下の呼び出し先を取り出して呼ぶ
+    TAIL_CALL,      // CALLと同じ。戻り値の型が同じユーザ定義関数なら、今のフレームを使い回す
+    RETURN,         // 取り出した値を呼び出し元へ返す
+    RAISE,          // errors[operand]を投げる
+    HALT,
+};
+struct Instruction {
+    OpCode op;
+    std::int32_t operand = 0;
+};
+static_assert(sizeof(Instruction) == 8);
+
+enum class Builtin : std::uint8_t { NONE, PRINT, PRINTLN };
+
+struct Function : public IFormattable {
+    SimpleFlyWeight::id_type name_id = 0;
+    Builtin builtin = Builtin::NONE;
+    std::vector<TypeTag> params;
+    TypeTag result = type_tag_of<NilType>();
+    std::uint32_t local_count = 0;
+    std::vector<Instruction> code;
+    // codeと同じ長さで、各命令のソース上の位置を持つ
+    std::vector<location::SourceRegion> locations;
+    location::SourceRegion location;
+
+    virtual std::string to_string() const override;
+};
+
+// コンパイル時に見つかったが、実行時に到達したときに報告すべきエラー
+struct DeferredError {
+    enum class Kind : std::uint8_t { SYNTAX, NAME, TYPE, REDECLARATION };
+    Kind kind;
+    std::string message;
+};
+
+struct Program : public IFormattable {
+    std::vector<Function> functions;
+    std::vector<Value> constants;
+    std::vector<DeferredError> errors;
+    // 組み込み関数とユーザ定義関数は、プログラム開始時点でglobalsに置かれる
+    std::vector<Value> globals;
+    FunctionIndex entry = 0;
+
+    virtual std::string to_string() const override;
+};
+}  // namespace Garnet::interpreter::bytecode
+#endif
@@ -0,0 +1,59 @@
+#ifndef GARNET_INTERPRETER_BYTECODE_VALUE
+#define GARNET_INTERPRETER_BYTECODE_VALUE
+#include <fmt/base.h>
+#include <fmt/format.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include "flyweight.hpp"
+#include "shared_string.hpp"
+namespace Garnet::interpreter::bytecode {
+struct NilType : public std::monostate {
+    using std::monostate::monostate;
+};
+using FunctionIndex = std::uint32_t;
+struct FunctionReference {
+    FunctionIndex index = 0;
+    // 表示はtree-walking interpreterと揃えるため、関数名のidを使う
+    // Valueを16バイトに収めるため32bitに詰める
+    std::uint32_t key = 0;
+
+    std::string to_string() const { return fmt::format("FunctionReference(key: {})", key); }
+};
+// 並びはInterpreter::Valueと揃えてある(VariableReferenceはVMでは不要)
+using Value = std::variant<NilType, std::uint8_t, std::int8_t, std::uint16_t, std::int16_t, std::uint32_t, std::int32_t,
+                           std::int64_t, std::uint64_t, float, double, bool, SharedString, FunctionReference>;
+static_assert(sizeof(Value) == 16);
+
+// 型はValueのalternativeのindexで表す
+using TypeTag = std::uint8_t;
+constexpr std::size_t TYPE_TAG_COUNT = std::variant_size_v<Value>;
+template <typename T>
+constexpr TypeTag type_tag_of() {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        TypeTag result = 0;
+        ((std::is_same_v<T, std::variant_alternative_t<I, Value>> ? (result = I, true) : false) || ...);
+        return result;
+    }(std::make_index_sequence<TYPE_TAG_COUNT>());
+}
+
+// 各型のゼロ値(変数宣言時の初期値)
+inline const Value& zero_value(TypeTag tag) {
+    static const auto zeros = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<Value, TYPE_TAG_COUNT>{Value(std::in_place_index<I>)...};
+    }(std::make_index_sequence<TYPE_TAG_COUNT>());
+    return zeros[tag];
+}
+}  // namespace Garnet::interpreter::bytecode
+template <>
+struct fmt::formatter<Garnet::interpreter::bytecode::NilType> : public fmt::formatter<std::string_view> {
+    auto format(const Garnet::interpreter::bytecode::NilType&, fmt::format_context& ctx) const {
+        return fmt::formatter<std::string_view>::format("nil", ctx);
+    }
+};
+#endif
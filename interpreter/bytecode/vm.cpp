@@ -0,0 +1,295 @@
+#include "vm.hpp"
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <fmt/std.h>
+
+#include <magic_enum_format.hpp>
+#include <type_traits>
+#include <typeinfo>
+
+#include "../exceptions.hpp"
+#include "../interpreter.hpp"
+#include "../semantics.hpp"
+#include "format.hpp"  // NOLINT
+namespace Garnet::interpreter::bytecode {
+using semantics::StaticConvertible;
+namespace {
+// エラーの文言をtree-walking interpreterと揃えるため、型の名前はInterpreter::Valueの同じ型から取る
+// 並びはInterpreter::Valueと揃えてあり、VMに無いVariableReferenceの分だけFunctionReferenceが一つずれる
+const std::type_info& type_info_of(std::size_t tag) {
+    return Interpreter::type_info(tag == type_tag_of<FunctionReference>() ? tag + 1 : tag);
+}
+const std::type_info& type_info_of(const Value& value) { return type_info_of(value.index()); }
+}  // namespace
+
+void VirtualMachine::run(const Program& program) {
+    program_ = &program;
+    globals_ = program.globals;
+    stack_.clear();
+    frames_.clear();
+    frames_.push_back({.function = &program.functions[program.entry], .ip = 0, .base = 0});
+
+    Frame* frame = &frames_.back();
+    const Instruction* code = frame->function->code.data();
+    std::size_t ip = 0;
+    for (;;) {
+        // 例外の位置を特定するため、実行中の命令を記録しておく
+        frame->ip = ip;
+        auto [op, operand] = code[ip++];
+        switch (op) {
+            case OpCode::PUSH_CONST:
+                stack_.push_back(program.constants[operand]);
+                break;
+            case OpCode::POP:
+                stack_.pop_back();
+                break;
+            case OpCode::REPLACE: {
+                Value value = std::move(stack_.back());
+                stack_.pop_back();
+                stack_[stack_.size() - operand] = std::move(value);
+            } break;
+            case OpCode::LOAD_LOCAL:
+                stack_.push_back(stack_[frame->base + operand]);
+                break;
+            case OpCode::STORE_LOCAL:
+                stack_[frame->base + operand] = std::move(stack_.back());
+                stack_.pop_back();
+                break;
+            case OpCode::ASSIGN_LOCAL:
+                assign_(stack_[frame->base + operand], stack_.back());
+                break;
+            case OpCode::LOAD_GLOBAL:
+                stack_.push_back(globals_[operand]);
+                break;
+            case OpCode::STORE_GLOBAL:
+                globals_[operand] = std::move(stack_.back());
+                stack_.pop_back();
+                break;
+            case OpCode::ASSIGN_GLOBAL:
+                assign_(globals_[operand], stack_.back());
+                break;
+            case OpCode::CONVERT:
+                stack_.back() = convert_(stack_.back(), static_cast<TypeTag>(operand));
+                break;
+            case OpCode::BINARY: {
+                Value rhs = std::move(stack_.back());
+                stack_.pop_back();
+                stack_.back() = binary_(static_cast<ast::BinaryOperator::OperatorType>(operand), stack_.back(), rhs);
+            } break;
+            case OpCode::UNARY:
+                stack_.back() = unary_(static_cast<ast::UnaryOperator::OperatorType>(operand), stack_.back());
+                break;
+            case OpCode::JUMP:
+                ip = operand;
+                break;
+            case OpCode::JUMP_IF_FALSE: {
+                bool cond = to_condition_(stack_.back());
+                stack_.pop_back();
+                if (not cond) {
+                    ip = operand;
+                }
+            } break;
+            case OpCode::SKIP_IF_FALSE:
+            case OpCode::SKIP_IF_TRUE:
+                if (to_bool_(stack_.back()) == (op == OpCode::SKIP_IF_TRUE)) {
+                    ip = operand;
+                } else {
+                    stack_.pop_back();
+                }
+                break;
+            case OpCode::CHECK_BOOL:
+                to_bool_(stack_.back());
+                break;
+            case OpCode::ASSERT:
+                if (to_bool_(stack_.back())) {
+                    ip = operand;
+                }
+                stack_.pop_back();
+                break;
+            case OpCode::ASSERT_FAIL:
+                if (operand != 0) {
+                    std::visit(
+                        [this](const auto& msg) {
+                            throw AssertionError(fmt::format("{}", msg), current_location_());
+                        },
+                        stack_.back());
+                }
+                throw AssertionError("", current_location_());
+            case OpCode::CALL:
+            case OpCode::TAIL_CALL: {
+                auto callee_pos = stack_.size() - operand - 1;
+                const auto* callee = std::get_if<FunctionReference>(&stack_[callee_pos]);
+                if (callee == nullptr) {
+                    throw TypeError(fmt::format("{} cannot be called", type_info_of(stack_[callee_pos])),
+                                    current_location_());
+                }
+                const auto& function = program.functions[callee->index];
+                auto base = callee_pos + 1;
+                if (function.builtin != Builtin::NONE) {
+                    auto result = call_builtin_(function.builtin, {stack_.begin() + base, stack_.end()});
+                    stack_.resize(callee_pos);
+                    stack_.push_back(std::move(result));
+                    break;
+                }
+                auto arity = function.params.size();
+                if (static_cast<std::size_t>(operand) < arity) {
+                    throw InvalidArgument("insufficient argument", function.location);
+                }
+                for (std::size_t i = 0; i < arity; i++) {
+                    stack_[base + i] = convert_(stack_[base + i], function.params[i]);
+                }
+                if (op == OpCode::TAIL_CALL && function.result == frame->function->result) {
+                    // 呼び出し先と実引数を今のフレームの位置へ移し、局所変数の領域を作り直す
+                    std::move(stack_.begin() + callee_pos, stack_.begin() + base + arity,
+                              stack_.begin() + frame->base - 1);
+                    stack_.resize(frame->base + arity);
+                    stack_.resize(frame->base + function.local_count);
+                    frame->function = &function;
+                    code = function.code.data();
+                    ip = 0;
+                    break;
+                }
+                // 余分な実引数を捨てつつ、局所変数の領域を確保する
+                stack_.resize(base + function.local_count);
+                frame->ip = ip;
+                frames_.push_back({.function = &function, .ip = 0, .base = base});
+                frame = &frames_.back();
+                code = function.code.data();
+                ip = 0;
+            } break;
+            case OpCode::RETURN: {
+                Value result = std::move(stack_.back());
+                stack_.resize(frame->base - 1);
+                stack_.push_back(std::move(result));
+                frames_.pop_back();
+                frame = &frames_.back();
+                code = frame->function->code.data();
+                ip = frame->ip;
+            } break;
+            case OpCode::RAISE:
+                raise_(program.errors[operand]);
+            case OpCode::HALT:
+                return;
+        }
+    }
+}
+location::SourceRegion VirtualMachine::current_location_() const {
+    const auto& frame = frames_.back();
+    return frame.function->locations[frame.ip];
+}
+Value VirtualMachine::convert_(const Value& value, TypeTag type) const {
+    Value result = zero_value(type);
+    std::visit(
+        [this, &value, type](auto& target, const auto& source) {
+            using TargetType = std::remove_cvref_t<decltype(target)>;
+            using SourceType = std::remove_cvref_t<decltype(source)>;
+            if constexpr (StaticConvertible<SourceType, TargetType>) {
+                target = static_cast<TargetType>(source);
+            } else {
+                throw TypeError(fmt::format("cannot convert {} to {}", type_info_of(value), type_info_of(type)),
+                                current_location_());
+            }
+        },
+        result, value);
+    return result;
+}
+void VirtualMachine::assign_(Value& target, const Value& source) const {
+    std::visit(
+        [this, &target, &source](auto& left, const auto& right) {
+            using LeftType = std::remove_cvref_t<decltype(left)>;
+            using RightType = std::remove_cvref_t<decltype(right)>;
+            if constexpr (not StaticConvertible<RightType, LeftType>) {
+                throw TypeError(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
+                                            type_info_of(source), type_info_of(target)),
+                                current_location_());
+            } else {
+                left = static_cast<LeftType>(right);
+            }
+        },
+        target, source);
+}
+Value VirtualMachine::binary_(ast::BinaryOperator::OperatorType op, const Value& lhs, const Value& rhs) const {
+    auto handler = semantics::BinaryDispatchTable<Value>::find(op, lhs.index(), rhs.index());
+    if (handler == nullptr) {
+        throw TypeError(fmt::format("cannot apply {} operator to {} and {}", op, type_info_of(lhs), type_info_of(rhs)),
+                        current_location_());
+    }
+    return handler(lhs, rhs);
+}
+Value VirtualMachine::unary_(ast::UnaryOperator::OperatorType op, const Value& operand) const {
+    auto handler = semantics::UnaryDispatchTable<Value>::find(op, operand.index());
+    if (handler == nullptr) {
+        throw TypeError(fmt::format("cannot apply {} operator to {}", op, type_info_of(operand)), current_location_());
+    }
+    return handler(operand);
+}
+bool VirtualMachine::to_condition_(const Value& value) const {
+    return std::visit(
+        [this, &value](const auto& alternative) -> bool {
+            if constexpr (std::is_convertible_v<decltype(alternative), bool>) {
+                return alternative;
+            } else {
+                throw TypeError(fmt::format("{} cannot be converted to bool", type_info_of(value)),
+                                current_location_());
+            }
+        },
+        value);
+}
+bool VirtualMachine::to_bool_(const Value& value) const {
+    const auto* result = std::get_if<bool>(&value);
+    if (result == nullptr) {
+        throw TypeError(fmt::format("{} is not bool", type_info_of(value)), current_location_());
+    }
+    return *result;
+}
+void VirtualMachine::raise_(const DeferredError& error) const {
+    auto location = current_location_();
+    switch (error.kind) {
+        using enum DeferredError::Kind;
+        case SYNTAX:
+            throw SyntaxError(error.message, location);
+        case NAME:
+            throw NameError(error.message, location);
+        case TYPE:
+            throw TypeError(error.message, location);
+        case REDECLARATION:
+            throw InvalidRedeclarationError(error.message, location);
+    }
+    std::unreachable();
+}
+Value VirtualMachine::call_builtin_(Builtin builtin, std::span<const Value> args) {
+    switch (builtin) {
+        case Builtin::PRINT:
+            print_(args);
+            break;
+        case Builtin::PRINTLN:
+            print_(args);
+            fmt::println("");
+            break;
+        case Builtin::NONE:
+            std::unreachable();
+    }
+    return NilType{};
+}
+void VirtualMachine::print_(std::span<const Value> args) {
+    for (size_t i = 0; const auto& arg : args) {
+        std::visit([](const auto& value) { fmt::print("{}", value); }, arg);
+        if (i < args.size() - 1) {
+            fmt::print(" ");
+        }
+        i++;
+    }
+}
+void VirtualMachine::debug_print() const {
+    fmt::print("globals: [");
+    for (size_t i = 0; const auto& global : globals_) {
+        std::visit([](const auto& value) { fmt::print("{}", value); }, global);
+        if (i < globals_.size() - 1) {
+            fmt::print(", ");
+        }
+        i++;
+    }
+    fmt::println("]");
+}
+}  // namespace Garnet::interpreter::bytecode
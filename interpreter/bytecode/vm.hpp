@@ -0,0 +1,48 @@
+#ifndef GARNET_INTERPRETER_BYTECODE_VM
+#define GARNET_INTERPRETER_BYTECODE_VM
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "concrete_expressions.hpp"
+#include "location.hpp"
+#include "program.hpp"
+#include "value.hpp"
+namespace Garnet::interpreter::bytecode {
+// Compilerが生成したProgramを実行するスタックマシン
+class VirtualMachine {
+    const Program* program_ = nullptr;
+
+    // 各フレームの局所変数と作業用スタックを一本のスタックに積む
+    std::vector<Value> stack_;
+    std::vector<Value> globals_;
+
+    struct Frame {
+        const Function* function;
+        std::size_t ip;
+        // 第一引数(局所変数0番)のstack_上の位置
+        std::size_t base;
+    };
+    std::vector<Frame> frames_;
+
+    location::SourceRegion current_location_() const;
+
+    Value convert_(const Value& value, TypeTag type) const;
+    void assign_(Value& target, const Value& source) const;
+    Value binary_(ast::BinaryOperator::OperatorType op, const Value& lhs, const Value& rhs) const;
+    Value unary_(ast::UnaryOperator::OperatorType op, const Value& operand) const;
+    bool to_condition_(const Value& value) const;
+    // ループの条件式やand/orの被演算子はboolでなければならない
+    bool to_bool_(const Value& value) const;
+    [[noreturn]] void raise_(const DeferredError& error) const;
+
+    Value call_builtin_(Builtin builtin, std::span<const Value> args);
+    void print_(std::span<const Value> args);
+
+   public:
+    void run(const Program& program);
+
+    void debug_print() const;
+};
+}  // namespace Garnet::interpreter::bytecode
+#endif
@@ -0,0 +1,954 @@
+#include "c_emitter.hpp"
+
+#include <fmt/core.h>
+#include <fmt/std.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <typeinfo>
+#include <utility>
+
+#include "../bytecode/value.hpp"
+#include "../exceptions.hpp"
+#include "../interpreter.hpp"
+#include "compilation_unit.hpp"
+#include "concrete_decls.hpp"
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_statements.hpp"
+#include "error_nodes.hpp"
+#include "format.hpp"  // NOLINT
+#include "identifier_mangler.hpp"
+namespace Garnet::interpreter::emit {
+namespace {
+using bytecode::type_tag_of;
+using Garnet::emit::IndentifilerMangler;
+// 型の番号はVMの値(bytecode::Value)のalternativeの番号。VMと同じく、条件式は値に変換してから評価する
+const semantics::TypeRules& type_rules() {
+    static const auto rules =
+        semantics::make_type_rules<bytecode::Value, bytecode::NilType, bytecode::FunctionReference>();
+    return rules;
+}
+constexpr std::size_t U8 = type_tag_of<std::uint8_t>(), I8 = type_tag_of<std::int8_t>(),
+                      U16 = type_tag_of<std::uint16_t>(), I16 = type_tag_of<std::int16_t>(),
+                      U32 = type_tag_of<std::uint32_t>(), I32 = type_tag_of<std::int32_t>(),
+                      U64 = type_tag_of<std::uint64_t>(), I64 = type_tag_of<std::int64_t>(),
+                      F32 = type_tag_of<float>(), F64 = type_tag_of<double>(), BOOL = type_tag_of<bool>();
+bool is_signed(std::size_t type) { return type == I8 || type == I16 || type == I32 || type == I64; }
+bool is_unsigned(std::size_t type) { return type == U8 || type == U16 || type == U32 || type == U64 || type == BOOL; }
+bool is_floating_point(std::size_t type) { return type == F32 || type == F64; }
+// intより狭く、Cの演算では昇格されるので、結果を元の型に戻す必要がある
+bool is_promoted(std::size_t type) { return type == U8 || type == I8 || type == U16 || type == I16 || type == BOOL; }
+// シフトや剰余の実行時ライブラリの関数で、汎整数拡張した後の型を表す接尾辞
+std::string_view promoted_suffix(std::size_t type) {
+    if (type == U32) {
+        return "u32";
+    } else if (type == I64) {
+        return "i64";
+    } else if (type == U64) {
+        return "u64";
+    }
+    return "i32";
+}
+
+std::string c_string_literal(std::string_view str) {
+    std::string result = "\"";
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += static_cast<char>(c);
+        } else if (c == '?') {
+            // トライグラフにならないように
+            result += "\\?";
+        } else if (0x20 <= c && c < 0x7f) {
+            result += static_cast<char>(c);
+        } else {
+            result += fmt::format("\\{:03o}", c);
+        }
+    }
+    result += '"';
+    return result;
+}
+
+// 出力の先頭に置く実行時ライブラリ
+// 表示はtree-walking interpreterと揃え、fmt::print("{}", value)と同じ文字列を書く
+constexpr std::string_view PRELUDE = R"(#include <inttypes.h>
+#include <math.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef unsigned char gn_nil;
+typedef struct {
+    const char* data;
+    size_t size;
+} gn_str;
+
+/* 連結した文字列の領域は解放しない */
+static inline gn_str gn_str_concat(gn_str left, gn_str right) {
+    if (left.size == 0) {
+        return right;
+    }
+    if (right.size == 0) {
+        return left;
+    }
+    char* data = malloc(left.size + right.size);
+    if (data == NULL) {
+        abort();
+    }
+    memcpy(data, left.data, left.size);
+    memcpy(data + left.size, right.data, right.size);
+    gn_str result = {data, left.size + right.size};
+    return result;
+}
+/* シフト量は、左辺を汎整数拡張した型の幅で剰余を取る(semantics::shift_countと同じ) */
+/* 32ビット以下の型はint32_t(uint32_t)に拡張してから計算し、呼び出し側で元の型に戻す */
+static inline int32_t gn_shl_i32(int32_t left, uint64_t count) { return (int32_t)((uint32_t)left << (count & 31)); }
+static inline int32_t gn_shr_i32(int32_t left, uint64_t count) { return left >> (count & 31); }
+static inline uint32_t gn_shl_u32(uint32_t left, uint64_t count) { return left << (count & 31); }
+static inline uint32_t gn_shr_u32(uint32_t left, uint64_t count) { return left >> (count & 31); }
+static inline int64_t gn_shl_i64(int64_t left, uint64_t count) { return (int64_t)((uint64_t)left << (count & 63)); }
+static inline int64_t gn_shr_i64(int64_t left, uint64_t count) { return left >> (count & 63); }
+static inline uint64_t gn_shl_u64(uint64_t left, uint64_t count) { return left << (count & 63); }
+static inline uint64_t gn_shr_u64(uint64_t left, uint64_t count) { return left >> (count & 63); }
+/* 整数の剰余。0で割るときと、最小値を-1で割るときは、解釈器と同じくSIGFPEで止まる */
+static inline void gn_division_error(void) {
+    raise(SIGFPE);
+    abort();
+}
+static inline int32_t gn_rem_i32(int32_t left, int32_t right) {
+    if (right == 0 || (left == INT32_MIN && right == -1)) {
+        gn_division_error();
+    }
+    return left % right;
+}
+static inline uint32_t gn_rem_u32(uint32_t left, uint32_t right) {
+    if (right == 0) {
+        gn_division_error();
+    }
+    return left % right;
+}
+static inline int64_t gn_rem_i64(int64_t left, int64_t right) {
+    if (right == 0 || (left == INT64_MIN && right == -1)) {
+        gn_division_error();
+    }
+    return left % right;
+}
+static inline uint64_t gn_rem_u64(uint64_t left, uint64_t right) {
+    if (right == 0) {
+        gn_division_error();
+    }
+    return left % right;
+}
+/* 浮動小数点数から整数への変換。範囲外やNaNでも、解釈器(x86-64のstatic_cast)と同じ値にする */
+/* cvttsd2siと同じく、変換先の範囲に収まらなければ最小値になる。32ビットより狭い型とi32は32ビットで変換する */
+static inline int32_t gn_f64_to_i32(double value) {
+    return value > -2147483649.0 && value < 2147483648.0 ? (int32_t)value : INT32_MIN;
+}
+static inline int64_t gn_f64_to_i64(double value) {
+    return value >= -9223372036854775808.0 && value < 9223372036854775808.0 ? (int64_t)value : INT64_MIN;
+}
+/* 2^63以上なら2^63を引いて変換し、最上位ビットを反転する */
+static inline uint64_t gn_f64_to_u64(double value) {
+    if (value >= 9223372036854775808.0) {
+        return (uint64_t)gn_f64_to_i64(value - 9223372036854775808.0) ^ (UINT64_C(1) << 63);
+    }
+    return (uint64_t)gn_f64_to_i64(value);
+}
+static inline void gn_print_i64(FILE* out, int64_t value) { fprintf(out, "%" PRId64, value); }
+static inline void gn_print_u64(FILE* out, uint64_t value) { fprintf(out, "%" PRIu64, value); }
+static inline void gn_print_bool(FILE* out, bool value) { fputs(value ? "true" : "false", out); }
+static inline void gn_print_nil(FILE* out, gn_nil value) {
+    (void)value;
+    fputs("nil", out);
+}
+static inline void gn_print_str(FILE* out, gn_str value) {
+    if (value.size != 0) {
+        fwrite(value.data, 1, value.size, out);
+    }
+}
+/* 元の値に戻る最短の桁数で書く。指数が-4以上16未満なら固定小数点で書く */
+static inline void gn_print_floating_point(FILE* out, double value, int max_digits, bool is_float) {
+    if (!isfinite(value)) {
+        fprintf(out, "%g", value);
+        return;
+    }
+    char buffer[40];
+    int digits = 1;
+    for (; digits < max_digits; digits++) {
+        snprintf(buffer, sizeof(buffer), "%.*e", digits - 1, value);
+        if (is_float ? strtof(buffer, NULL) == (float)value : strtod(buffer, NULL) == value) {
+            break;
+        }
+    }
+    snprintf(buffer, sizeof(buffer), "%.*e", digits - 1, value);
+    int exponent = atoi(strchr(buffer, 'e') + 1);
+    if (exponent < -4 || exponent >= 16) {
+        fputs(buffer, out);
+    } else {
+        int decimals = digits - 1 - exponent;
+        fprintf(out, "%.*f", decimals < 0 ? 0 : decimals, value);
+    }
+}
+static inline void gn_print_f32(FILE* out, float value) { gn_print_floating_point(out, value, 9, true); }
+static inline void gn_print_f64(FILE* out, double value) { gn_print_floating_point(out, value, 17, false); }
+static inline void gn_assertion_failed(const char* file, int line, int column) {
+    fflush(stdout);
+    fprintf(stderr, "assertion failed\n    at %s, line %d, col %d\n    what(): ", file, line, column);
+}
+)";
+}  // namespace
+
+CEmitter::CEmitter() : rules_(type_rules()) {
+    auto& pool = SimpleFlyWeight::instance();
+    types_[pool.id("u8")] = U8;
+    types_[pool.id("i8")] = I8;
+    types_[pool.id("u16")] = U16;
+    types_[pool.id("i16")] = I16;
+    types_[pool.id("u32")] = U32;
+    types_[pool.id("i32")] = I32;
+    types_[pool.id("u64")] = U64;
+    types_[pool.id("i64")] = I64;
+    types_[pool.id("f32")] = F32;
+    types_[pool.id("f64")] = F64;
+    types_[pool.id("str")] = rules_.string;
+    types_[pool.id("NilType")] = rules_.nil;
+    types_[pool.id("void")] = rules_.nil;
+    c_types_.resize(rules_.type_count);
+    c_types_[U8] = "uint8_t";
+    c_types_[I8] = "int8_t";
+    c_types_[U16] = "uint16_t";
+    c_types_[I16] = "int16_t";
+    c_types_[U32] = "uint32_t";
+    c_types_[I32] = "int32_t";
+    c_types_[U64] = "uint64_t";
+    c_types_[I64] = "int64_t";
+    c_types_[F32] = "float";
+    c_types_[F64] = "double";
+    c_types_[BOOL] = "bool";
+    c_types_[rules_.string] = "gn_str";
+    c_types_[rules_.nil] = "gn_nil";
+}
+std::string CEmitter::emit(const ast::CompilationUnit& unit) {
+    Interpreter().check(unit);
+    unit.accept(*this);
+    return std::move(output_);
+}
+std::size_t CEmitter::lookup_type_(ast::SourceTypeIdentifier name, location::SourceRegion location) const {
+    auto pos = types_.find(name.source_id());
+    if (pos == types_.end()) {
+        throw NameError(fmt::format("type '{}' is not defined", name.source_name()), location);
+    }
+    return pos->second;
+}
+std::size_t CEmitter::result_type_of_(const ast::FunctionDef* node) const {
+    if (not node->info().result().has_value()) {
+        return rules_.nil;
+    }
+    return lookup_type_(node->info().result()->type().name(), node->location());
+}
+const CEmitter::Operand* CEmitter::lookup_(NameType name) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        if (auto pos = scope->find(name); pos != scope->end()) {
+            return &pos->second;
+        }
+    }
+    return nullptr;
+}
+std::string CEmitter::declare_(NameType name, std::string c_name, std::size_t type, location::SourceRegion location) {
+    if (scopes_.back().contains(name)) {
+        throw InvalidRedeclarationError(
+            fmt::format("variable {} is already declared in this scope.", SimpleFlyWeight::instance().value(name)),
+            location);
+    }
+    // 外側のスコープの同じ名前を隠す変数は、初期化式から外側の変数を参照できるように別の名前にする
+    bool is_shadowing = false;
+    for (const auto& scope : scopes_) {
+        for (const auto& [_, variable] : scope) {
+            is_shadowing = is_shadowing || variable.expr == c_name;
+        }
+    }
+    if (is_shadowing) {
+        c_name = fmt::format("{}_{}", c_name, next_shadow_++);
+    }
+    scopes_.back()[name] = {.expr = c_name, .type = type, .is_lvalue = true};
+    return c_name;
+}
+void CEmitter::line_(const std::string& text) {
+    body_.append(indent_ * 4, ' ');
+    body_ += text;
+    body_ += '\n';
+}
+std::string CEmitter::temporary_(const Operand& operand) {
+    auto name = fmt::format("tmp{}", next_temporary_++);
+    line_(fmt::format("{} {} = {};", c_types_[operand.type], name, operand.expr));
+    return name;
+}
+void CEmitter::stabilize_(Operand& operand, std::size_t position) {
+    if (operand.is_stable || operand.is_lvalue || body_.size() == position) {
+        return;
+    }
+    auto tail = body_.substr(position);
+    body_.resize(position);
+    operand.expr = temporary_(operand);
+    operand.is_stable = true;
+    body_ += tail;
+}
+std::pair<CEmitter::Operand, std::string> CEmitter::capture_(const ast::Expression* expr, int indent,
+                                                             bool is_discarded) {
+    auto saved_body = std::exchange(body_, {});
+    auto saved_indent = std::exchange(indent_, indent);
+    is_discarded_ = is_discarded;
+    expr->accept(*this);
+    is_discarded_ = false;
+    indent_ = saved_indent;
+    return {result_, std::exchange(body_, std::move(saved_body))};
+}
+CEmitter::Operand CEmitter::evaluate_(const ast::Expression* expr) {
+    is_discarded_ = false;
+    expr->accept(*this);
+    return result_;
+}
+void CEmitter::check_value_(const Operand& operand, location::SourceRegion location) const {
+    if (operand.type == rules_.function) {
+        throw UnImplementedError("function values cannot be emitted to C", location);
+    }
+}
+void CEmitter::check_bool_(const Operand& operand, location::SourceRegion location) const {
+    check_value_(operand, location);
+    // ループの条件式やand/orの被演算子は、変数を値に変換してから真偽を問う
+    if (operand.type != BOOL) {
+        throw TypeError(fmt::format("{} is not bool", rules_.type_info(operand.type)), location);
+    }
+}
+std::string CEmitter::convert_(const Operand& operand, std::size_t type, location::SourceRegion location) const {
+    check_value_(operand, location);
+    if (operand.type == type) {
+        return operand.expr;
+    }
+    if (not rules_.is_convertible(operand.type, type)) {
+        throw TypeError(
+            fmt::format("cannot convert {} to {}", rules_.type_info(operand.type), rules_.type_info(type)), location);
+    }
+    // 範囲外の値のCのキャストは未定義動作なので、浮動小数点数から整数へは実行時ライブラリで変換する
+    // f32はf64に正確に変換できるので、同じ関数で変換する
+    if (is_floating_point(operand.type) && (is_signed(type) || (is_unsigned(type) && type != BOOL))) {
+        if (type == U64) {
+            return fmt::format("gn_f64_to_u64({})", operand.expr);
+        }
+        return fmt::format("(({})gn_f64_to_{}({}))", c_types_[type], type == I64 || type == U32 ? "i64" : "i32",
+                           operand.expr);
+    }
+    return fmt::format("(({}){})", c_types_[type], operand.expr);
+}
+std::string CEmitter::zero_(std::size_t type) const {
+    if (type == rules_.string) {
+        return "((gn_str){NULL, 0})";
+    }
+    return fmt::format("(({})0)", c_types_[type]);
+}
+std::string CEmitter::binary_(ast::BinaryOperator::OperatorType op, const Operand& left, const Operand& right,
+                              location::SourceRegion location) const {
+    check_value_(left, location);
+    check_value_(right, location);
+    auto type = rules_.binary_result(op, left.type, right.type);
+    if (type == UNKNOWN) {
+        throw TypeError(fmt::format("cannot apply {} operator to {} and {}", op, rules_.type_info(left.type),
+                                    rules_.type_info(right.type)),
+                        location);
+    }
+    auto cast = [this](const Operand& operand, std::size_t type) {
+        return operand.type == type ? operand.expr : fmt::format("(({}){})", c_types_[type], operand.expr);
+    };
+    // 両辺を結果の型にそろえて計算する(semantics::apply_binaryと同じ)
+    auto arithmetic = [&](std::string_view symbol) {
+        auto expr = fmt::format("({} {} {})", cast(left, type), symbol, cast(right, type));
+        return is_promoted(type) ? fmt::format("(({}){})", c_types_[type], expr) : expr;
+    };
+    // 実行時ライブラリのgn_<name>_<汎整数拡張した型>で計算する
+    auto runtime = [&](std::string_view name, const std::string& lhs, const std::string& rhs) {
+        auto expr = fmt::format("gn_{}_{}({}, {})", name, promoted_suffix(type), lhs, rhs);
+        return is_promoted(type) ? fmt::format("(({}){})", c_types_[type], expr) : expr;
+    };
+    using enum ast::BinaryOperator::OperatorType;
+    switch (op) {
+        case ADD:
+            if (type == rules_.string) {
+                return fmt::format("gn_str_concat({}, {})", left.expr, right.expr);
+            }
+            return arithmetic("+");
+        case SUB:
+            return arithmetic("-");
+        case MUL:
+            return arithmetic("*");
+        case DIV:
+            return arithmetic("/");
+        case MOD:
+            if (is_floating_point(type)) {
+                return fmt::format("{}({}, {})", type == F32 ? "fmodf" : "fmod", cast(left, type), cast(right, type));
+            }
+            return runtime("rem", cast(left, type), cast(right, type));
+        case LESS:
+            return fmt::format("({} < {})", left.expr, right.expr);
+        case GREATER:
+            return fmt::format("({} > {})", left.expr, right.expr);
+        case LESS_EQUAL:
+            return fmt::format("({} <= {})", left.expr, right.expr);
+        case GREATER_EQUAL:
+            return fmt::format("({} >= {})", left.expr, right.expr);
+        case EQUAL:
+            return fmt::format("({} == {})", left.expr, right.expr);
+        case NOT_EQUAL:
+            return fmt::format("({} != {})", left.expr, right.expr);
+        case BIT_AND:
+            return arithmetic("&");
+        case BIT_OR:
+            return arithmetic("|");
+        case BIT_XOR:
+            return arithmetic("^");
+        case LEFT_SHIFT:
+        case RIGHT_SHIFT:
+            // 結果は左辺の型。シフト量は符号の有無にかかわらず、uint64_tにして下位のビットだけを使う
+            return runtime(op == LEFT_SHIFT ? "shl" : "shr", left.expr, fmt::format("(uint64_t){}", right.expr));
+        case ASSIGN:
+            break;
+    }
+    throw UnImplementedError(fmt::format("operator {} cannot be emitted to C", op), location);
+}
+void CEmitter::emit_sentence_(const ast::Base* sentence) {
+    if (const auto* expr = dynamic_cast<const ast::Expression*>(sentence); expr != nullptr) {
+        is_discarded_ = true;
+        expr->accept(*this);
+        is_discarded_ = false;
+    } else {
+        sentence->accept(*this);
+    }
+}
+
+void CEmitter::visit(const ast::CompilationUnit* node) {
+    auto& pool = SimpleFlyWeight::instance();
+    scopes_.assign(1, {});
+    for (const auto* builtin : {"print", "println"}) {
+        scopes_.front()[pool.id(builtin)] = {.expr = builtin, .type = rules_.function, .is_builtin = true};
+    }
+    for (const auto& child : node->children()) {
+        const auto& raw = *child;
+        if (typeid(raw) == typeid(ast::FunctionDef)) {
+            child->accept(*this);
+        } else if (typeid(raw) == typeid(ast::VariableDecl)) {
+            child->accept(*this);
+        }
+    }
+    auto globals = std::exchange(body_, {});
+
+    // 関数本体はグローバルな宣言が出揃ってから変換するので、先に全ての関数を宣言しておく
+    std::vector<const ast::FunctionDef*> functions;
+    for (const auto& child : node->children()) {
+        const auto* function = dynamic_cast<const ast::FunctionDef*>(child.get());
+        const auto* global = function != nullptr ? lookup_(function->info().name().source_id()) : nullptr;
+        // 再定義されて使われない関数は出力しない
+        if (global != nullptr && global->function == function) {
+            functions.push_back(function);
+        }
+    }
+    std::string prototypes, definitions;
+    for (const auto* function : functions) {
+        auto signature = signature_(function);
+        prototypes += fmt::format("static {};\n", signature);
+        definitions += fmt::format("static {} {{\n{}}}\n", signature, emit_function_(function));
+    }
+
+    const auto* main = lookup_(pool.id("main"));
+    if (main == nullptr || main->function == nullptr) {
+        throw NameError("function 'main' is not defined", node->location());
+    }
+    // tree-walking interpreterと同じく、mainには0を一つ渡す(余分な実引数は捨てられる)
+    std::string main_args;
+    if (not main->function->info().args().empty()) {
+        auto type = lookup_type_(main->function->info().args().front().type().name(), main->function->location());
+        main_args = convert_({.expr = "((int32_t)0)", .type = I32}, type, main->function->location());
+    }
+    output_ = fmt::format("{}\n{}\n{}\n{}\nint main(void) {{\n    {}({});\n    return 0;\n}}\n", PRELUDE, prototypes,
+                          globals, definitions, mangled_name_(main->function), main_args);
+}
+std::string CEmitter::mangled_name_(const ast::FunctionDef* node) const {
+    return IndentifilerMangler::mangle_function_name(node->info().name(), node->info());
+}
+std::string CEmitter::signature_(const ast::FunctionDef* node) const {
+    std::string args;
+    for (const auto& arg : node->info().args()) {
+        if (not args.empty()) {
+            args += ", ";
+        }
+        args += fmt::format("{} {}", c_types_[lookup_type_(arg.type().name(), arg.location())],
+                            IndentifilerMangler::mangle_variable_name(arg));
+    }
+    return fmt::format("{} {}({})", c_types_[result_type_of_(node)], mangled_name_(node),
+                       args.empty() ? "void" : args);
+}
+std::string CEmitter::emit_function_(const ast::FunctionDef* node) {
+    if (node->block() == nullptr) {
+        throw UnImplementedError(
+            fmt::format("function {} has no body", node->info().name().source_name()), node->location());
+    }
+    body_.clear();
+    indent_ = 1;
+    next_temporary_ = 0;
+    next_shadow_ = 0;
+    // 引数のスコープ。関数本体のブロックはその内側のスコープになる
+    scopes_.emplace_back();
+    for (const auto& arg : node->info().args()) {
+        auto c_name = IndentifilerMangler::mangle_variable_name(arg);
+        if (declare_(arg.name().source_id(), c_name, lookup_type_(arg.type().name(), arg.location()),
+                     arg.location()) != c_name) {
+            throw InvalidRedeclarationError(
+                fmt::format("variable {} is already declared in this scope.", arg.name().source_name()),
+                arg.location());
+        }
+        // 使わない引数(mainのargcなど)で警告が出ないように
+        line_(fmt::format("(void){};", c_name));
+    }
+    result_type_ = result_type_of_(node);
+    scopes_.emplace_back();
+    for (const auto& sentence : node->block()->sentences()) {
+        emit_sentence_(sentence.get());
+    }
+    scopes_.pop_back();
+    scopes_.pop_back();
+    // returnせずに抜けたら、戻り値の型のゼロ値を返す
+    line_(fmt::format("return {};", zero_(result_type_)));
+    result_type_ = UNKNOWN;
+    return std::exchange(body_, {});
+}
+void CEmitter::visit(const ast::FunctionDef* node) {
+    // 関数の再定義と、組み込み関数や同名のグローバル変数の上書きは許される
+    scopes_.front()[node->info().name().source_id()] = {.type = rules_.function, .function = node};
+}
+void CEmitter::visit(const ast::VariableDecl* node) {
+    auto type = lookup_type_(node->type(), node->location());
+    if (scopes_.size() == 1) {
+        // グローバル変数は初期化式を持たない
+        if (node->init().has_value()) {
+            throw UnImplementedError("initializers of global variables cannot be emitted to C", node->location());
+        }
+        auto c_name = declare_(node->name().source_id(), node->mangled_name(), type, node->location());
+        line_(fmt::format("static {} {};", c_types_[type], c_name));
+        return;
+    }
+    auto init = zero_(type);
+    if (node->init().has_value()) {
+        init = convert_(evaluate_(node->init().value().get()), type, node->location());
+    }
+    // 初期化式を評価してから宣言する
+    auto c_name = declare_(node->name().source_id(), node->mangled_name(), type, node->location());
+    line_(fmt::format("{} {} = {};", c_types_[type], c_name, init));
+}
+void CEmitter::visit(const ast::TypeDecl*) {}
+void CEmitter::visit(const ast::ErrorNode* node) { throw SyntaxError("invalid node", node->location()); }
+void CEmitter::visit(const ast::ErrorSentence* node) { throw SyntaxError("invalid sentence", node->location()); }
+void CEmitter::visit(const ast::ErrorExpression* node) {
+    throw SyntaxError("invalid expresssion", node->location());
+}
+void CEmitter::visit(const ast::ErrorStatement* node) { throw SyntaxError("invalid statement", node->location()); }
+void CEmitter::visit(const ast::BinaryOperator* node) {
+    bool is_discarded = std::exchange(is_discarded_, false);
+    auto location = node->location();
+    if (node->op() == ast::BinaryOperator::OperatorType::ASSIGN) {
+        auto target = evaluate_(node->left().get());
+        if (not target.is_lvalue) {
+            throw TypeError("cannot assign to rvalue", location);
+        }
+        check_value_(target, location);
+        auto value = evaluate_(node->right().get());
+        check_value_(value, location);
+        if (not rules_.is_convertible(value.type, target.type)) {
+            throw TypeError(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
+                                        rules_.type_info(value.type), rules_.type_info(target.type)),
+                            location);
+        }
+        // 代入式の値は右辺の値そのもの(右辺が変数なら、その変数)
+        if (not is_discarded && not value.is_stable && not value.is_lvalue) {
+            value.expr = temporary_(value);
+            value.is_stable = true;
+        }
+        line_(fmt::format("{} = {};", target.expr, convert_(value, target.type, location)));
+        result_ = value;
+        return;
+    }
+    auto left = evaluate_(node->left().get());
+    auto position = body_.size();
+    auto right = evaluate_(node->right().get());
+    stabilize_(left, position);
+    auto expr = binary_(node->op(), left, right, location);
+    result_ = {.expr = expr,
+               .type = rules_.binary_result(node->op(), left.type, right.type),
+               .is_stable = left.is_stable && right.is_stable};
+}
+void CEmitter::visit(const ast::CompoundAssign* node) {
+    bool is_discarded = std::exchange(is_discarded_, false);
+    auto location = node->location();
+    auto target = evaluate_(node->target().get());
+    auto value = evaluate_(node->value().get());
+    auto expr = binary_(node->op(), target, value, location);
+    if (not target.is_lvalue) {
+        throw TypeError("cannot assign to rvalue", location);
+    }
+    Operand result{.expr = expr, .type = rules_.binary_result(node->op(), target.type, value.type)};
+    if (not rules_.is_convertible(result.type, target.type)) {
+        throw TypeError(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
+                                    rules_.type_info(result.type), rules_.type_info(target.type)),
+                        location);
+    }
+    // 代入式の値は演算の結果そのもの
+    if (not is_discarded) {
+        result.expr = temporary_(result);
+        result.is_stable = true;
+    }
+    line_(fmt::format("{} = {};", target.expr, convert_(result, target.type, location)));
+    result_ = result;
+}
+void CEmitter::visit(const ast::LogicalOperator* node) {
+    bool is_and = node->op() == ast::LogicalOperator::OperatorType::AND;
+    auto left = evaluate_(node->left().get());
+    check_bool_(left, node->left()->location());
+    auto [right, statements] = capture_condition_(node->right().get(), indent_ + 1);
+    if (statements.empty()) {
+        result_ = {.expr = fmt::format("({} {} {})", left.expr, is_and ? "&&" : "||", right.expr),
+                   .type = BOOL,
+                   .is_stable = left.is_stable && right.is_stable};
+        return;
+    }
+    // rightが文を出力するなら、その文はleftで結果が決まらないときだけ実行する
+    Operand result{.expr = left.expr, .type = BOOL};
+    result.expr = temporary_(result);
+    result.is_stable = true;
+    line_(fmt::format("if ({}{}) {{", is_and ? "" : "!", result.expr));
+    body_ += statements;
+    indent_++;
+    line_(fmt::format("{} = {};", result.expr, right.expr));
+    indent_--;
+    line_("}");
+    result_ = result;
+}
+void CEmitter::visit(const ast::UnaryOperator* node) {
+    auto operand = evaluate_(node->operand().get());
+    check_value_(operand, node->location());
+    auto type = rules_.unary_result(node->op(), operand.type);
+    if (type == UNKNOWN) {
+        throw TypeError(fmt::format("cannot apply {} operator to {}", node->op(), rules_.type_info(operand.type)),
+                        node->location());
+    }
+    auto wrap = [&](std::string expr) {
+        return is_promoted(type) ? fmt::format("(({}){})", c_types_[type], expr) : expr;
+    };
+    std::string expr;
+    using enum ast::UnaryOperator::OperatorType;
+    switch (node->op()) {
+        case PLUS:
+            expr = wrap(fmt::format("(+{})", operand.expr));
+            break;
+        case MINUS:
+            expr = wrap(fmt::format("(-{})", operand.expr));
+            break;
+        case BOOL_NOT:
+            expr = fmt::format("(!{})", operand.expr);
+            break;
+        case BIT_NOT:
+            expr = type == BOOL ? fmt::format("(!{})", operand.expr) : wrap(fmt::format("(~{})", operand.expr));
+            break;
+    }
+    result_ = {.expr = expr, .type = type, .is_stable = operand.is_stable};
+}
+void CEmitter::visit(const ast::VariableReference* node) {
+    const auto* variable = lookup_(node->name().source_id());
+    if (variable == nullptr) {
+        throw NameError(fmt::format("variable '{}' is not defined", node->name().source_name()), node->location());
+    }
+    result_ = *variable;
+}
+void CEmitter::visit(const ast::SignedIntegerLiteral* node) {
+    auto value = node->value();
+    std::string expr;
+    if (value == std::numeric_limits<std::int64_t>::min()) {
+        expr = "INT64_MIN";
+    } else if (value < 0) {
+        expr = fmt::format("(-INT64_C({}))", -value);
+    } else {
+        expr = fmt::format("INT64_C({})", value);
+    }
+    result_ = {.expr = expr, .type = I64, .is_stable = true};
+}
+void CEmitter::visit(const ast::UnsignedIntegerLiteral* node) {
+    result_ = {.expr = fmt::format("UINT64_C({})", node->value()), .type = U64, .is_stable = true};
+}
+void CEmitter::visit(const ast::FloatingPointLiteral* node) {
+    // 定数の畳み込みで、無限大やNaNのリテラルもできうる
+    auto value = node->value();
+    std::string expr;
+    if (std::isnan(value)) {
+        expr = "NAN";
+    } else if (std::isinf(value)) {
+        expr = "INFINITY";
+    } else {
+        // 最短で元の値に戻る表記。整数に見える表記には小数点を補う
+        expr = fmt::format("{}", std::abs(value));
+        if (expr.find_first_of(".e") == std::string::npos) {
+            expr += ".0";
+        }
+    }
+    if (std::signbit(value)) {
+        expr = fmt::format("(-{})", expr);
+    }
+    result_ = {.expr = expr, .type = F64, .is_stable = true};
+}
+void CEmitter::visit(const ast::StringLiteral* node) {
+    auto value = node->value();
+    result_ = {.expr = fmt::format("((gn_str){{{}, {}}})", c_string_literal(value), value.size()),
+               .type = rules_.string,
+               .is_stable = true};
+}
+void CEmitter::visit(const ast::BooleanLiteral* node) {
+    result_ = {.expr = node->value() ? "true" : "false", .type = BOOL, .is_stable = true};
+}
+void CEmitter::visit(const ast::NilLiteral*) {
+    result_ = {.expr = zero_(rules_.nil), .type = rules_.nil, .is_stable = true};
+}
+void CEmitter::visit(const ast::FunctionCall* node) {
+    bool is_discarded = std::exchange(is_discarded_, false);
+    node->callee()->accept(*this);
+    auto callee = result_;
+    if (callee.type != rules_.function) {
+        throw TypeError(fmt::format("{} cannot be called", rules_.type_info(callee.type)), node->location());
+    }
+    std::vector<Operand> args;
+    std::vector<std::size_t> positions;
+    for (const auto& arg : node->args()) {
+        args.push_back(evaluate_(arg.get()));
+        positions.push_back(body_.size());
+    }
+    // 実引数は左から順に評価するので、後の実引数が副作用を出力したら、先の実引数を写しておく
+    // 後ろから挿入すれば、前の位置はずれない
+    for (auto i = args.size(); i-- > 0;) {
+        stabilize_(args[i], positions[i]);
+    }
+    if (callee.is_builtin) {
+        for (std::size_t i = 0; i < args.size(); i++) {
+            line_(print_call_(args[i], "stdout", node->args()[i]->location()));
+            if (i + 1 < args.size()) {
+                line_("fputc(' ', stdout);");
+            }
+        }
+        if (callee.expr == "println") {
+            line_("fputc('\\n', stdout);");
+        }
+        result_ = {.expr = zero_(rules_.nil), .type = rules_.nil, .is_stable = true};
+        return;
+    }
+    const auto* function = callee.function;
+    const auto arginfos = function->info().args();
+    if (args.size() < arginfos.size()) {
+        throw InvalidArgument("insufficient argument", function->location());
+    }
+    // 余分な実引数は評価だけして捨てる
+    std::string converted;
+    for (std::size_t i = 0; i < arginfos.size(); i++) {
+        if (i != 0) {
+            converted += ", ";
+        }
+        converted += convert_(args[i], lookup_type_(arginfos[i].type().name(), arginfos[i].location()),
+                              arginfos[i].location());
+    }
+    auto call = fmt::format("{}({})", mangled_name_(function), converted);
+    result_ = {.expr = zero_(rules_.nil), .type = rules_.nil, .is_stable = true};
+    if (is_discarded) {
+        line_(call + ";");
+        return;
+    }
+    result_ = {.expr = call, .type = result_type_of_(function)};
+    result_.expr = temporary_(result_);
+    result_.is_stable = true;
+}
+std::string CEmitter::print_call_(const Operand& operand, const std::string& stream,
+                                  location::SourceRegion location) const {
+    check_value_(operand, location);
+    if (is_signed(operand.type)) {
+        return fmt::format("gn_print_i64({}, {});", stream, operand.expr);
+    }
+    if (operand.type == BOOL) {
+        return fmt::format("gn_print_bool({}, {});", stream, operand.expr);
+    }
+    if (is_unsigned(operand.type)) {
+        return fmt::format("gn_print_u64({}, {});", stream, operand.expr);
+    }
+    if (operand.type == F32) {
+        return fmt::format("gn_print_f32({}, {});", stream, operand.expr);
+    }
+    if (operand.type == F64) {
+        return fmt::format("gn_print_f64({}, {});", stream, operand.expr);
+    }
+    if (operand.type == rules_.string) {
+        return fmt::format("gn_print_str({}, {});", stream, operand.expr);
+    }
+    return fmt::format("gn_print_nil({}, {});", stream, operand.expr);
+}
+void CEmitter::visit(const ast::VariableDeclStatement* node) {
+    for (const auto& child : node->children()) {
+        child->accept(*this);
+    }
+}
+void CEmitter::visit(const ast::ReturnStatement* node) {
+    auto value = evaluate_(node->retval().get());
+    check_value_(value, node->location());
+    if (not rules_.is_convertible(value.type, result_type_)) {
+        throw TypeError(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
+                                    rules_.type_info(value.type), rules_.type_info(result_type_)),
+                        node->location());
+    }
+    line_(fmt::format("return {};", convert_(value, result_type_, node->location())));
+}
+void CEmitter::visit(const ast::Block* node) {
+    line_("{");
+    indent_++;
+    scopes_.emplace_back();
+    for (const auto& sentence : node->sentences()) {
+        emit_sentence_(sentence.get());
+    }
+    scopes_.pop_back();
+    indent_--;
+    line_("}");
+}
+void CEmitter::visit(const ast::LoopStatement* node) {
+    line_("for (;;)");
+    node->block()->accept(*this);
+}
+std::pair<CEmitter::Operand, std::string> CEmitter::capture_condition_(const ast::Expression* cond, int indent) {
+    auto result = capture_(cond, indent, false);
+    check_bool_(result.first, cond->location());
+    return result;
+}
+void CEmitter::visit(const ast::WhileStatement* node) {
+    auto [cond, statements] = capture_condition_(node->cond().get(), indent_ + 1);
+    if (statements.empty()) {
+        line_(fmt::format("while ({})", cond.expr));
+        node->block()->accept(*this);
+        return;
+    }
+    // 条件式が文を出力するなら、毎回の評価の後で抜けるかを決める
+    line_("for (;;) {");
+    body_ += statements;
+    indent_++;
+    line_(fmt::format("if (!{}) break;", cond.expr));
+    node->block()->accept(*this);
+    indent_--;
+    line_("}");
+}
+void CEmitter::visit(const ast::DoWhileStatement* node) {
+    // 本体のスコープの外で条件式を評価する
+    line_("for (;;) {");
+    indent_++;
+    node->block()->accept(*this);
+    auto [cond, statements] = capture_condition_(node->cond().get(), indent_);
+    body_ += statements;
+    line_(fmt::format("if (!{}) break;", cond.expr));
+    indent_--;
+    line_("}");
+}
+void CEmitter::visit(const ast::ForStatement* node) {
+    // initで宣言した変数のスコープ
+    line_("{");
+    indent_++;
+    scopes_.emplace_back();
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+    }
+    Operand cond{.expr = "true", .type = BOOL};
+    std::string statements;
+    if (node->cond().has_value()) {
+        std::tie(cond, statements) = capture_condition_(node->cond().value().get(), indent_ + 1);
+    }
+    if (statements.empty()) {
+        line_(fmt::format("while ({}) {{", cond.expr));
+        indent_++;
+    } else {
+        line_("for (;;) {");
+        body_ += statements;
+        indent_++;
+        line_(fmt::format("if (!{}) break;", cond.expr));
+    }
+    node->block()->accept(*this);
+    // breakで抜けたときはupdateを評価しない
+    if (node->update().has_value()) {
+        emit_sentence_(node->update().value().get());
+    }
+    indent_--;
+    line_("}");
+    scopes_.pop_back();
+    indent_--;
+    line_("}");
+}
+void CEmitter::visit(const ast::BreakStatement*) { line_("break;"); }
+void CEmitter::emit_if_(const ast::IfStatement* node, std::size_t index) {
+    const auto& [raw_cond, block] = node->cond_blocks()[index];
+    auto cond = evaluate_(raw_cond.get());
+    check_value_(cond, raw_cond->location());
+    if (not rules_.bool_convertible[cond.type]) {
+        throw TypeError(fmt::format("{} cannot be converted to bool", rules_.type_info(cond.type)),
+                        raw_cond->location());
+    }
+    line_(fmt::format("if ({})", cond.expr));
+    block->accept(*this);
+    if (index + 1 == node->cond_blocks().size()) {
+        return;
+    }
+    line_("else");
+    const auto& [next_cond, next_block] = node->cond_blocks()[index + 1];
+    if (next_cond.use_count() == 0) {
+        next_block->accept(*this);
+        return;
+    }
+    // 後続の条件式は、前の条件が偽のときだけ評価する
+    line_("{");
+    indent_++;
+    emit_if_(node, index + 1);
+    indent_--;
+    line_("}");
+}
+void CEmitter::visit(const ast::IfStatement* node) {
+    if (node->cond_blocks().empty()) {
+        return;
+    }
+    emit_if_(node, 0);
+}
+void CEmitter::visit(const ast::AssertStatement* node) {
+    auto cond_loc = node->cond()->location();
+    auto cond = evaluate_(node->cond().get());
+    check_value_(cond, cond_loc);
+    if (cond.type != BOOL) {
+        throw TypeError(fmt::format("{} is not bool", rules_.type_info(cond.type)), cond_loc);
+    }
+    line_(fmt::format("if (!{}) {{", cond.expr));
+    indent_++;
+    // メッセージは失敗したときだけ評価する
+    std::optional<Operand> msg;
+    if (node->msg().has_value()) {
+        msg = evaluate_(node->msg().value().get());
+    }
+    line_(fmt::format("gn_assertion_failed({}, {}, {});", c_string_literal(cond_loc.begin.source_file()),
+                      cond_loc.begin.line, cond_loc.begin.column));
+    if (msg.has_value()) {
+        line_(print_call_(*msg, "stderr", node->msg().value()->location()));
+    }
+    line_("fputc('\\n', stderr);");
+    line_("exit(EXIT_FAILURE);");
+    indent_--;
+    line_("}");
+}
+}  // namespace Garnet::interpreter::emit
@@ -0,0 +1,125 @@
+#ifndef GARNET_INTERPRETER_EMIT_C_EMITTER
+#define GARNET_INTERPRETER_EMIT_C_EMITTER
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../semantics.hpp"
+#include "base.hpp"
+#include "concrete_source_identifiers.hpp"
+#include "expression.hpp"
+#include "flyweight.hpp"
+#include "location.hpp"
+#include "visitor/visitor.hpp"
+namespace Garnet::interpreter::emit {
+// ast::CompilationUnitを、Cコンパイラでネイティブの実行ファイルにできるC(C99)のソースに変換する
+// 変数の型は宣言で静的に決まるので、各式の型も変換時に決め、型の誤りは変換時にTypeErrorで報告する
+// 変換する前に木の解釈器と同じ型検査を行い、解釈器が実行を拒むプログラムは変換しない
+// 演算の結果の型はsemantics::TypeRules(実行エンジンと同じ規則)で決める
+// 関数や変数の名前はIndentifilerManglerなどで変換した名前をそのまま使う
+// 関数を値として扱う式(関数の代入や、print(f)など)は変換できないので、UnImplementedErrorを投げる
+class CEmitter : public ast::Visitor {
+    using NameType = SimpleFlyWeight::id_type;
+    static constexpr std::size_t UNKNOWN = semantics::TypeRules::NONE;
+
+    // 式を変換した結果。副作用(呼び出しや代入)は文として先に出力し、ここには副作用のないCの式だけが残る
+    struct Operand {
+        std::string expr = {};
+        std::size_t type = UNKNOWN;
+        // 後続の副作用で値が変わらない(リテラルか一時変数)
+        bool is_stable = false;
+        // 関数を指す名前なら、その関数。組み込み関数ならnullptrでis_builtinがtrue
+        const ast::FunctionDef* function = nullptr;
+        bool is_builtin = false;
+        // 変数を指す式(ASSIGNの左辺になれる)
+        // tree-walking interpreterと同じく、変数の値は後の被演算子や実引数の副作用の後で読む
+        bool is_lvalue = false;
+    };
+    using Scope = std::unordered_map<NameType, Operand>;
+
+    const semantics::TypeRules& rules_;
+    std::unordered_map<NameType, std::size_t> types_;
+    std::vector<std::string> c_types_;
+
+    std::vector<Scope> scopes_;
+    // 関数の再定義は最後の定義が有効になる
+    std::unordered_map<NameType, const ast::FunctionDef*> functions_;
+    std::size_t result_type_ = UNKNOWN;
+
+    std::string output_;
+    // 出力中の関数本体
+    std::string body_;
+    int indent_ = 0;
+    std::size_t next_temporary_ = 0;
+    std::size_t next_shadow_ = 0;
+    Operand result_;
+    // 式文の値は使われないので、呼び出しの戻り値を一時変数に受けなくてよい
+    bool is_discarded_ = false;
+
+    std::size_t lookup_type_(ast::SourceTypeIdentifier name, location::SourceRegion location) const;
+    std::size_t result_type_of_(const ast::FunctionDef* node) const;
+    std::string mangled_name_(const ast::FunctionDef* node) const;
+    std::string signature_(const ast::FunctionDef* node) const;
+    const Operand* lookup_(NameType name) const;
+    // 宣言した変数のCでの名前を返す
+    std::string declare_(NameType name, std::string c_name, std::size_t type, location::SourceRegion location);
+
+    void line_(const std::string& text);
+    std::string temporary_(const Operand& operand);
+    // positionより後に副作用が出力されていたら、operandの値をpositionの時点で一時変数に写しておく(変数は写さない)
+    void stabilize_(Operand& operand, std::size_t position);
+    // 式を評価し、その式が出力した文を別に返す
+    std::pair<Operand, std::string> capture_(const ast::Expression* expr, int indent, bool is_discarded);
+    std::pair<Operand, std::string> capture_condition_(const ast::Expression* cond, int indent);
+    Operand evaluate_(const ast::Expression* expr);
+    void emit_sentence_(const ast::Base* sentence);
+    void check_value_(const Operand& operand, location::SourceRegion location) const;
+    void check_bool_(const Operand& operand, location::SourceRegion location) const;
+    std::string convert_(const Operand& operand, std::size_t type, location::SourceRegion location) const;
+    std::string zero_(std::size_t type) const;
+    std::string binary_(ast::BinaryOperator::OperatorType op, const Operand& left, const Operand& right,
+                        location::SourceRegion location) const;
+    std::string print_call_(const Operand& operand, const std::string& stream,
+                            location::SourceRegion location) const;
+    void emit_if_(const ast::IfStatement* node, std::size_t index);
+    std::string emit_function_(const ast::FunctionDef* node);
+
+   public:
+    CEmitter();
+    std::string emit(const ast::CompilationUnit& unit);
+
+    virtual void visit(const ast::VariableDecl*) override;
+    virtual void visit(const ast::TypeDecl*) override;
+    virtual void visit(const ast::ErrorNode*) override;
+    virtual void visit(const ast::ErrorSentence*) override;
+    virtual void visit(const ast::ErrorExpression*) override;
+    virtual void visit(const ast::ErrorStatement*) override;
+    virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
+    virtual void visit(const ast::UnaryOperator*) override;
+    virtual void visit(const ast::VariableReference*) override;
+    virtual void visit(const ast::SignedIntegerLiteral*) override;
+    virtual void visit(const ast::UnsignedIntegerLiteral*) override;
+    virtual void visit(const ast::FloatingPointLiteral*) override;
+    virtual void visit(const ast::StringLiteral*) override;
+    virtual void visit(const ast::FunctionCall*) override;
+    virtual void visit(const ast::CompilationUnit*) override;
+    virtual void visit(const ast::FunctionDef*) override;
+    virtual void visit(const ast::VariableDeclStatement*) override;
+    virtual void visit(const ast::ReturnStatement*) override;
+    virtual void visit(const ast::Block*) override;
+    virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
+    virtual void visit(const ast::BreakStatement*) override;
+    virtual void visit(const ast::IfStatement*) override;
+    virtual void visit(const ast::AssertStatement*) override;
+    virtual void visit(const ast::BooleanLiteral*) override;
+    virtual void visit(const ast::NilLiteral*) override;
+};
+}  // namespace Garnet::interpreter::emit
+#endif
@@ -0,0 +1,103 @@
+#include "instrumented_interpreter.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <functional>
+#include <magic_enum_format.hpp>
+#include <map>
+#include <ranges>
+#include <tuple>
+
+#include "block.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_statements.hpp"
+namespace Garnet::interpreter {
+namespace {
+std::string escape_json(const std::string& text) {
+    std::string result;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+}  // namespace
+
+void InstrumentedInterpreter::visit(const ast::BinaryOperator* node) { measure_(node, node); }
+void InstrumentedInterpreter::visit(const ast::FunctionCall* node) { measure_(node, node); }
+void InstrumentedInterpreter::visit(const ast::Block* node) { measure_(node, node); }
+void InstrumentedInterpreter::visit(const ast::ReturnStatement* node) {
+    // 末尾呼び出しの形のreturn文はvisit(FunctionCall)を通らずに呼び出すので、return文ごと呼び出しとして数える
+    if (const auto* call = node->tail_call(); call != nullptr) {
+        measure_(node, call);
+        return;
+    }
+    Interpreter::visit(node);
+}
+std::vector<InstrumentedInterpreter::Entry> InstrumentedInterpreter::entries() const {
+    using Key = std::tuple<std::string, std::string, std::string, int, int>;
+    std::map<Key, Entry> grouped;
+    for (const auto& [node, counter] : counters_) {
+        Entry entry{.location = node->location(),
+                    .count = counter.count,
+                    .time = std::chrono::duration_cast<std::chrono::nanoseconds>(counter.time)};
+        if (const auto* op = dynamic_cast<const ast::BinaryOperator*>(node); op != nullptr) {
+            entry.kind = "BinaryOperator";
+            entry.label = fmt::format("{}", op->op());
+        } else if (const auto* call = dynamic_cast<const ast::FunctionCall*>(node); call != nullptr) {
+            entry.kind = "FunctionCall";
+            const auto* callee = dynamic_cast<const ast::VariableReference*>(call->callee().get());
+            entry.label = callee != nullptr ? callee->name().source_name() : "(expression)";
+        } else {
+            entry.kind = "Block";
+        }
+        const auto& begin = entry.location.begin;
+        Key key{entry.kind, entry.label, begin.source_file(), begin.line, begin.column};
+        if (auto [pos, inserted] = grouped.try_emplace(key, entry); not inserted) {
+            pos->second.count += entry.count;
+            pos->second.time += entry.time;
+        }
+    }
+    std::vector<Entry> result;
+    for (auto& [key, entry] : grouped) {
+        result.push_back(std::move(entry));
+    }
+    std::ranges::stable_sort(result, std::ranges::greater{}, &Entry::time);
+    return result;
+}
+void InstrumentedInterpreter::write_report(std::ostream& out, std::size_t count) const {
+    auto all = entries();
+    fmt::print(out, "{:>12} {:>12}  {}\n", "count", "time(ms)", "node");
+    for (const auto& entry : all | std::views::take(count)) {
+        const auto& begin = entry.location.begin;
+        auto name = entry.label.empty() ? entry.kind : fmt::format("{} {}", entry.kind, entry.label);
+        fmt::print(out, "{:>12} {:>12.3f}  {} ({}:{}:{})\n", entry.count,
+                   std::chrono::duration<double, std::milli>(entry.time).count(), name, begin.source_file(),
+                   begin.line, begin.column);
+    }
+}
+void InstrumentedInterpreter::write_json(std::ostream& out) const {
+    auto all = entries();
+    fmt::print(out, "[\n");
+    for (std::size_t i = 0; i < all.size(); i++) {
+        const auto& entry = all[i];
+        const auto& begin = entry.location.begin;
+        const auto& end = entry.location.end;
+        fmt::print(out,
+                   R"(  {{"kind": "{}", "label": "{}", "file": "{}", "line": {}, "column": {}, "end_line": {}, )"
+                   R"("end_column": {}, "count": {}, "nanoseconds": {}}}{})"
+                   "\n",
+                   entry.kind, escape_json(entry.label), escape_json(begin.source_file()), begin.line, begin.column,
+                   end.line, end.column, entry.count, entry.time.count(), i + 1 < all.size() ? "," : "");
+    }
+    fmt::print(out, "]\n");
+}
+}  // namespace Garnet::interpreter
@@ -0,0 +1,69 @@
+#ifndef GARNET_INTERPRETER_INSTRUMENTED_INTERPRETER
+#define GARNET_INTERPRETER_INSTRUMENTED_INTERPRETER
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base.hpp"
+#include "interpreter.hpp"
+#include "location.hpp"
+namespace Garnet::interpreter {
+// 節ごとの実行回数と実行時間を数えるInterpreter
+// 数えるのはBinaryOperator(演算子ごと)、FunctionCall(呼び出し先の名前ごと)、Block(スコープに入った回数)で、
+// 時間はその節の中で実行した全て(入れ子の節や呼び出し先の本体)を含む。再帰で同じ節を実行している間は重ねて数えない
+// 計測はvisitを上書きして行うので、計測しないときはInterpreterをそのまま使い、実行の経路に何も足さない
+// 末尾呼び出しは呼び出し元の関数に戻ってから本体を実行するので、その時間は呼び出し元の呼び出しに含まれる
+class InstrumentedInterpreter : public Interpreter {
+    using Clock = std::chrono::steady_clock;
+    struct Counter {
+        std::uint64_t count = 0;
+        Clock::duration time{};
+        // 再帰で実行中の数。時間は最も外側の実行だけで測り、入れ子の実行の分を重ねて数えない
+        std::uint32_t active = 0;
+    };
+    // 要素への参照は再ハッシュでも無効にならないので、実行中も持ち続けてよい
+    std::unordered_map<const ast::Base*, Counter> counters_;
+
+    // nodeを実行し、keyの節の実行として数える
+    template <typename Node>
+    void measure_(const Node* node, const ast::Base* key) {
+        auto& counter = counters_[key];
+        counter.count++;
+        if (counter.active++ != 0) {
+            Interpreter::visit(node);
+            counter.active--;
+            return;
+        }
+        auto begin = Clock::now();
+        Interpreter::visit(node);
+        counter.time += Clock::now() - begin;
+        counter.active--;
+    }
+
+   public:
+    // 同じ種類で同じ位置の節の計測結果をまとめたもの
+    struct Entry {
+        std::string kind = {};
+        std::string label = {};
+        location::SourceRegion location = {};
+        std::uint64_t count = 0;
+        std::chrono::nanoseconds time = {};
+    };
+    // 時間の長い順
+    std::vector<Entry> entries() const;
+    // 時間の長い順に上位count個を表にする
+    void write_report(std::ostream& out, std::size_t count) const;
+    void write_json(std::ostream& out) const;
+
+    using Interpreter::visit;
+    virtual void visit(const ast::BinaryOperator* node) override;
+    virtual void visit(const ast::FunctionCall* node) override;
+    virtual void visit(const ast::Block* node) override;
+    virtual void visit(const ast::ReturnStatement* node) override;
+};
+}  // namespace Garnet::interpreter
+#endif
@@ -20,14 +20,13 @@
 #include "exceptions.hpp"
 #include "flyweight.hpp"
 #include "format.hpp"  // NOLINT
-#include "instance_pool.hpp"
 #include "location.hpp"
+#include "purity_analyzer.hpp"
+#include "semantics.hpp"
+#include "type_checker.hpp"
 namespace Garnet::interpreter {
 
-template <typename From, typename To>
-concept StaticConvertible = requires(From a, To b) {
-    { static_cast<To>(a) } -> std::convertible_to<To>;
-};
+using semantics::StaticConvertible;
 
 void Interpreter::visit(const ast::VariableDecl* node) {
     std::optional<Value> init;
@@ -39,46 +38,57 @@ void Interpreter::visit(const ast::VariableDecl* node) {
         auto value = std::any_cast<Value>(node->userdata);
         init = value;
     }
-    declare_variable_(node->name(), node->type(), init);
+    declare_variable_(node->name(), node->type(), init, node->slot().value());
 }
 void Interpreter::declare_variable_(ast::SourceVariableIdentifier name, ast::SourceTypeIdentifier type,
-                                    std::optional<Value> value, location::SourceRegion location) {
-    if (current_scope_->keymap->contains(name.source_id())) {
+                                    std::optional<Value> value, Slot slot, location::SourceRegion location) {
+    // 同じスコープで同じ名前を宣言すると、Resolverは同じ番号を割り当てる
+    if (stack_[current_scope_->base + slot].is_declared) {
         throw InvalidRedeclarationError(
             std::format("variable {} is already declared in this scope.", name.source_name()), location);
     }
     Variable var;
-    auto key = key_generator_();
     var.name_id = name.source_id();
+    var.is_declared = true;
     var.value = types_.at(type.source_id())();
     if (value.has_value()) {
-        std::visit(
-            [this, &location](auto& target, auto& source) mutable {
-                auto assign_only = [&location](auto& target, auto& source) {
-                    if constexpr (StaticConvertible<decltype(source), std::remove_cvref_t<decltype(target)>>) {
-                        target = static_cast<std::remove_cvref_t<decltype(target)>>(source);
-                    } else {
-                        throw TypeError(fmt::format("cannot convert {} to {}", typeid(source), typeid(target)),
-                                        location);
-                    }
-                };
-                using namespace std::placeholders;
-                if constexpr (std::is_convertible_v<decltype(source), VariableReference> &&
-                              std::is_convertible_v<decltype(target), VariableReference>) {
-                    std::visit(assign_only, variables_[target.key].value, variables_[source.key].value);
-                } else if constexpr (std::is_convertible_v<decltype(source), VariableReference>) {
-                    std::visit([&target, assign_only](auto& source) { assign_only(target, source); },
-                               variables_[source.key].value);
-                } else if constexpr (std::is_convertible_v<decltype(target), VariableReference>) {
-                    std::visit(std::bind(assign_only, std::ref(_1), source), variables_[target.key].value);
-                } else {
-                    assign_only(target, source);
-                }
-            },
-            var.value, *value);
+        var.value = convert_(var.value, *value, location);
     }
-    variables_[key] = var;
-    (*(current_scope_->keymap))[var.name_id] = key;
+    stack_[current_scope_->base + slot] = std::move(var);
+}
+Interpreter::Value Interpreter::convert_(const Value& type, const Value& source, location::SourceRegion location) {
+    const Value& right =
+        std::holds_alternative<VariableReference>(source) ? variable_(std::get<VariableReference>(source)).value : source;
+    Value result = type;
+    std::visit(
+        [&location](auto& target, const auto& source) {
+            using TargetType = std::remove_cvref_t<decltype(target)>;
+            using SourceType = std::remove_cvref_t<decltype(source)>;
+            if constexpr (StaticConvertible<SourceType, TargetType>) {
+                target = static_cast<TargetType>(source);
+            } else {
+                throw TypeError(fmt::format("cannot convert {} to {}", typeid(source), typeid(target)), location);
+            }
+        },
+        result, right);
+    return result;
+}
+void Interpreter::assign_(Variable& target, const Value& source, location::SourceRegion location) {
+    const Value& right =
+        std::holds_alternative<VariableReference>(source) ? variable_(std::get<VariableReference>(source)).value : source;
+    std::visit(
+        [&location](auto& left, auto right) {
+            using LeftType = decltype(left);
+            using RightType = decltype(right);
+            if constexpr (not StaticConvertible<std::remove_cvref_t<RightType>, std::remove_cvref_t<LeftType>>) {
+                throw TypeError(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
+                                            typeid(RightType), typeid(LeftType)),
+                                location);
+            } else {
+                left = static_cast<std::remove_cvref_t<LeftType>>(right);
+            }
+        },
+        target.value, right);
 }
 void Interpreter::visit(const ast::TypeDecl* node) {
     for (const auto& child : node->children()) {
@@ -92,39 +102,6 @@ void Interpreter::visit(const ast::ErrorExpression* node) {
 }
 void Interpreter::visit(const ast::ErrorStatement* node) { throw SyntaxError("invalid statement", node->location()); }
 
-namespace {
-template <typename T, typename U>
-concept LessComparable = requires(T a, U b) {
-    { a < b } -> std::convertible_to<bool>;
-};
-template <typename T, typename U>
-concept LessEqualComparable = requires(T a, U b) {
-    { a <= b } -> std::convertible_to<bool>;
-};
-template <typename T, typename U>
-concept GreaterComparable = requires(T a, U b) {
-    { a > b } -> std::convertible_to<bool>;
-};
-template <typename T, typename U>
-concept GreaterEqualComparable = requires(T a, U b) {
-    { a >= b } -> std::convertible_to<bool>;
-};
-template <typename T, typename U>
-concept EqualComparable = requires(T a, U b) {
-    { a == b } -> std::convertible_to<bool>;
-};
-template <typename T, typename U>
-concept NotEqualComparable = requires(T a, U b) {
-    { a != b } -> std::convertible_to<bool>;
-};
-template <typename T, typename U>
-concept SignednessMatch =
-    (std::signed_integral<T> && std::signed_integral<U>) || (std::unsigned_integral<T> && std::unsigned_integral<U>);
-template <typename T, typename U>
-concept BothFloat = (std::is_floating_point_v<T> && std::is_floating_point_v<U>);
-template <typename T, typename U>
-concept StrictComparable = BothFloat<T, U> || SignednessMatch<T, U>;
-}  // namespace
 void Interpreter::visit(const ast::BinaryOperator* node) {
     node->left()->accept(*this);
 
@@ -133,494 +110,71 @@ void Interpreter::visit(const ast::BinaryOperator* node) {
     node->right()->accept(*this);
 
     auto rhs = expr_result_;
-    auto deref_and_apply = [this](auto func, auto& lhs, auto& rhs) {
-        using LeftType = decltype(lhs);
-        using RightType = decltype(rhs);
-        using namespace std::placeholders;
-        if constexpr (std::is_convertible_v<LeftType, VariableReference> &&
-                      std::is_convertible_v<RightType, VariableReference>) {
-            std::visit(func, variables_[lhs.key].value, variables_[rhs.key].value);
-        } else if constexpr (std::is_convertible_v<LeftType, VariableReference>) {
-            std::visit(std::bind(func, _1, std::ref(rhs)), variables_[lhs.key].value);
-        } else if constexpr (std::is_convertible_v<RightType, VariableReference>) {
-            std::visit([&lhs, func](auto& rhs) { func(lhs, rhs); }, variables_[rhs.key].value);
-        } else {
-            func(lhs, rhs);
+    auto location = node->location();
+    if (node->op() == ast::BinaryOperator::OperatorType::ASSIGN) {
+        // 左辺は必ず参照でなくてはならないので、derefできない
+        if (not std::holds_alternative<VariableReference>(lhs)) {
+            throw TypeError("cannot assign to rvalue", location);
         }
+        assign_(variable_(std::get<VariableReference>(lhs)), rhs, location);
+        return;
+    }
+    auto deref = [this](const Value& value) -> const Value& {
+        if (std::holds_alternative<VariableReference>(value)) {
+            return variable_(std::get<VariableReference>(value)).value;
+        }
+        return value;
     };
+    expr_result_ = binary_(node->op(), deref(lhs), deref(rhs), node->operand_types(), location);
+}
+Interpreter::Value Interpreter::binary_(ast::BinaryOperator::OperatorType op, const Value& left, const Value& right,
+                                        std::optional<std::array<std::uint8_t, 2>> types,
+                                        location::SourceRegion location) {
+    if (types.has_value()) {
+        // 型検査で被演算子の型が決まっていれば、適用できることも確かめてある
+        return semantics::BinaryDispatchTable<Value>::find(op, (*types)[0], (*types)[1])(left, right);
+    }
+    auto handler = semantics::BinaryDispatchTable<Value>::find(op, left.index(), right.index());
+    if (handler == nullptr) {
+        std::visit(
+            [op, &location](const auto& left, const auto& right) {
+                throw TypeError(fmt::format("cannot apply {} operator to {} and {}", op, typeid(left), typeid(right)),
+                                location);
+            },
+            left, right);
+    }
+    return handler(left, right);
+}
+void Interpreter::visit(const ast::CompoundAssign* node) {
+    node->target()->accept(*this);
+    auto target = expr_result_;
+    node->value()->accept(*this);
+    Value value = std::holds_alternative<VariableReference>(expr_result_)
+                      ? variable_(std::get<VariableReference>(expr_result_)).value
+                      : std::move(expr_result_);
     auto location = node->location();
-    switch (node->op()) {
-        using enum ast::BinaryOperator::OperatorType;
-        using namespace std::placeholders;
-        case ADD:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        using Left = std::numeric_limits<LeftType>;
-                        using Right = std::numeric_limits<RightType>;
-                        if constexpr (std::is_convertible_v<LeftType, VariableReference> ||
-                                      std::is_convertible_v<RightType, VariableReference>) {
-                            throw TypeError(fmt::format("cannot apply ADD operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        } else if constexpr (Left::is_specialized && Right::is_specialized) {
-                            if constexpr (Left::is_integer && (not Right::is_integer)) {
-                                this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) + right);
-                            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
-                                this->expr_result_ = static_cast<LeftType>(left + static_cast<LeftType>(right));
-                            } else {
-                                if constexpr (Left::digits >= Right::digits) {
-                                    this->expr_result_ = static_cast<LeftType>(left + static_cast<LeftType>(right));
-                                } else {
-                                    this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) + right);
-                                }
-                            }
-                        } else if constexpr (std::is_convertible_v<LeftType, std::string> &&
-                                             std::is_convertible_v<RightType, std::string>) {
-                            this->expr_result_ = left + right;
-                        } else {
-                            throw TypeError(fmt::format("cannot apply ADD operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case SUB:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        using Left = std::numeric_limits<LeftType>;
-                        using Right = std::numeric_limits<RightType>;
-                        if constexpr (std::is_convertible_v<LeftType, VariableReference> ||
-                                      std::is_convertible_v<RightType, VariableReference>) {
-                            throw TypeError(fmt::format("cannot apply SUB operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        } else if constexpr (Left::is_specialized && Right::is_specialized) {
-                            if constexpr (Left::is_integer && (not Right::is_integer)) {
-                                this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) - right);
-                            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
-                                this->expr_result_ = static_cast<LeftType>(left - static_cast<LeftType>(right));
-                            } else {
-                                if constexpr (Left::digits >= Right::digits) {
-                                    this->expr_result_ = static_cast<LeftType>(left - static_cast<LeftType>(right));
-                                } else {
-                                    this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) - right);
-                                }
-                            }
-                        } else {
-                            throw TypeError(fmt::format("cannot apply SUB operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case MUL:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        using Left = std::numeric_limits<LeftType>;
-                        using Right = std::numeric_limits<RightType>;
-                        if constexpr (std::is_convertible_v<LeftType, VariableReference> ||
-                                      std::is_convertible_v<RightType, VariableReference>) {
-                            throw TypeError(fmt::format("cannot apply MUL operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        } else if constexpr (Left::is_specialized && Right::is_specialized) {
-                            if constexpr (Left::is_integer && (not Right::is_integer)) {
-                                this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) * right);
-                            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
-                                this->expr_result_ = static_cast<LeftType>(left * static_cast<LeftType>(right));
-                            } else {
-                                if constexpr (Left::digits >= Right::digits) {
-                                    this->expr_result_ = static_cast<LeftType>(left * static_cast<LeftType>(right));
-                                } else {
-                                    this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) * right);
-                                }
-                            }
-                        } else {
-                            throw TypeError(fmt::format("cannot apply MUL operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case DIV:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        using Left = std::numeric_limits<LeftType>;
-                        using Right = std::numeric_limits<RightType>;
-                        if constexpr (std::is_convertible_v<LeftType, VariableReference> ||
-                                      std::is_convertible_v<RightType, VariableReference>) {
-                            throw TypeError(fmt::format("cannot apply DIV operator to {} and {}", typeid(LeftType),
-
-                                                        typeid(RightType)),
-                                            location);
-                        } else if constexpr (Left::is_specialized && Right::is_specialized) {
-                            if constexpr (Left::is_integer && Right::is_integer) {
-                                this->expr_result_ =
-                                    static_cast<double>(static_cast<double>(left) / static_cast<double>(right));
-                            } else if constexpr (Left::is_integer && (not Right::is_integer)) {
-                                this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) / right);
-                            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
-                                this->expr_result_ = static_cast<LeftType>(left / static_cast<LeftType>(right));
-                            } else {
-                                if constexpr (Left::digits >= Right::digits) {
-                                    this->expr_result_ = static_cast<LeftType>(left / static_cast<LeftType>(right));
-                                } else {
-                                    this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) / right);
-                                }
-                            }
-                        } else {
-                            throw TypeError(fmt::format("cannot apply DIV operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case MOD:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        using Left = std::numeric_limits<LeftType>;
-                        using Right = std::numeric_limits<RightType>;
-                        if constexpr (std::is_convertible_v<LeftType, VariableReference> ||
-                                      std::is_convertible_v<RightType, VariableReference>) {
-                            throw TypeError(fmt::format("cannot apply MOD operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        } else if constexpr (Left::is_specialized && Right::is_specialized) {
-                            if constexpr (Left::is_integer && (not Right::is_integer)) {
-                                this->expr_result_ =
-                                    static_cast<RightType>(std::fmod(static_cast<RightType>(left), right));
-                            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
-                                this->expr_result_ =
-                                    static_cast<LeftType>(std::fmod(left, static_cast<LeftType>(right)));
-                            } else if constexpr (Left::is_integer && Right::is_integer) {
-                                if constexpr (Left::digits >= Right::digits) {
-                                    this->expr_result_ = static_cast<LeftType>(left % static_cast<LeftType>(right));
-                                } else {
-                                    this->expr_result_ = static_cast<RightType>(static_cast<RightType>(left) % right);
-                                }
-                            } else {
-                                if constexpr (Left::digits >= Right::digits) {
-                                    this->expr_result_ =
-                                        static_cast<LeftType>(std::fmod(left, static_cast<LeftType>(right)));
-                                } else {
-                                    this->expr_result_ =
-                                        static_cast<RightType>(std::fmod(static_cast<RightType>(left), right));
-                                }
-                            }
-                        } else {
-                            throw TypeError(fmt::format("cannot apply MOD operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case ASSIGN: {
-            // 左辺は必ず参照でなくてはならないので、deref_and_applyは使えない
-            if (not std::holds_alternative<VariableReference>(lhs)) {
-                throw TypeError("cannot assign to rvalue", location);
-            }
-            auto& left = variables_.at(std::get<VariableReference>(lhs).key);
-            Value right = rhs;
-            if (std::holds_alternative<VariableReference>(rhs)) {
-                right = variables_.at(std::get<VariableReference>(rhs).key).value;
-            }
-            std::visit(
-                [this, &location](auto& left, auto right) {
-                    using LeftType = decltype(left);
-                    using RightType = decltype(right);
-                    if constexpr (not StaticConvertible<std::remove_cvref_t<RightType>,
-                                                        std::remove_cvref_t<LeftType>>) {
-                        throw TypeError(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
-                                                    typeid(RightType), typeid(LeftType)),
-                                        location);
-                    } else {
-                        left = static_cast<std::remove_cvref_t<LeftType>>(right);
-                    }
-                },
-                left.value, right);
-        } break;
-        case LESS:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        if constexpr (LessComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
-                            this->expr_result_ = left < right;
-                        } else {
-                            throw TypeError(fmt::format("cannot apply LESS operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case LESS_EQUAL:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, &location](auto left, auto right) {
-                               using LeftType = decltype(left);
-                               using RightType = decltype(right);
-                               if constexpr (LessEqualComparable<LeftType, RightType> &&
-                                             StrictComparable<LeftType, RightType>) {
-                                   this->expr_result_ = left <= right;
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply LESS_EQUAL operator to {} and {}",
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case GREATER:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        if constexpr (GreaterComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
-                            this->expr_result_ = left > right;
-                        } else {
-                            throw TypeError(fmt::format("cannot apply GREATER operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case GREATER_EQUAL:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, &location](auto left, auto right) {
-                               using LeftType = decltype(left);
-                               using RightType = decltype(right);
-                               if constexpr (GreaterEqualComparable<LeftType, RightType> &&
-                                             StrictComparable<LeftType, RightType>) {
-                                   this->expr_result_ = left >= right;
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply GREATER_EQUAL operator to {} and {}",
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case EQUAL:
-            std::visit(
-                std::bind(
-                    deref_and_apply,
-                    [this, &location](auto left, auto right) {
-                        using LeftType = decltype(left);
-                        using RightType = decltype(right);
-                        if constexpr (EqualComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
-                            this->expr_result_ = left == right;
-                        } else {
-                            throw TypeError(fmt::format("cannot apply EQUAL operator to {} and {}", typeid(LeftType),
-                                                        typeid(RightType)),
-                                            location);
-                        }
-                    },
-                    _1, _2),
-                lhs, rhs);
-            break;
-        case NOT_EQUAL:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, &location](auto left, auto right) {
-                               using LeftType = decltype(left);
-                               using RightType = decltype(right);
-                               if constexpr (NotEqualComparable<LeftType, RightType> &&
-                                             StrictComparable<LeftType, RightType>) {
-                                   this->expr_result_ = left != right;
-                               } else if constexpr (EqualComparable<LeftType, RightType> &&
-                                                    StrictComparable<LeftType, RightType>) {
-                                   this->expr_result_ = not(left == right);
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply NOT_EQUAL operator to {} and {}",
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case BOOL_AND:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, node, &location](auto left, auto right) {
-                               using LeftType = std::remove_cvref_t<decltype(left)>;
-                               using RightType = std::remove_cvref_t<decltype(right)>;
-                               if constexpr (std::is_same_v<LeftType, bool> && std::is_same_v<RightType, bool>) {
-                                   this->expr_result_ = left && right;
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply {} operator to {} and {}", node->op(),
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case BIT_AND:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, node, &location](auto left, auto right) {
-                               using LeftType = std::remove_cvref_t<decltype(left)>;
-                               using RightType = std::remove_cvref_t<decltype(right)>;
-                               using Left = std::numeric_limits<LeftType>;
-                               using Right = std::numeric_limits<RightType>;
-                               if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
-                                   if constexpr (Left::digits > Right::digits) {
-                                       this->expr_result_ = static_cast<LeftType>(left & static_cast<LeftType>(right));
-                                   } else {
-                                       this->expr_result_ =
-                                           static_cast<RightType>(static_cast<RightType>(left) & right);
-                                   }
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply {} operator to {} and {}", node->op(),
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case BOOL_OR:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, node, &location](auto left, auto right) {
-                               using LeftType = std::remove_cvref_t<decltype(left)>;
-                               using RightType = std::remove_cvref_t<decltype(right)>;
-                               if constexpr (std::is_same_v<LeftType, bool> && std::is_same_v<RightType, bool>) {
-                                   this->expr_result_ = left || right;
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply {} operator to {} and {}", node->op(),
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case BIT_OR:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, node, &location](auto left, auto right) {
-                               using LeftType = std::remove_cvref_t<decltype(left)>;
-                               using RightType = std::remove_cvref_t<decltype(right)>;
-                               using Left = std::numeric_limits<LeftType>;
-                               using Right = std::numeric_limits<RightType>;
-                               if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
-                                   if constexpr (Left::digits > Right::digits) {
-                                       this->expr_result_ = static_cast<LeftType>(left | static_cast<LeftType>(right));
-                                   } else {
-                                       this->expr_result_ =
-                                           static_cast<RightType>(static_cast<RightType>(left) | right);
-                                   }
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply {} operator to {} and {}", node->op(),
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case BIT_XOR:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, node, &location](auto left, auto right) {
-                               using LeftType = std::remove_cvref_t<decltype(left)>;
-                               using RightType = std::remove_cvref_t<decltype(right)>;
-                               using Left = std::numeric_limits<LeftType>;
-                               using Right = std::numeric_limits<RightType>;
-                               if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
-                                   if constexpr (Left::digits > Right::digits) {
-                                       this->expr_result_ = static_cast<LeftType>(left ^ static_cast<LeftType>(right));
-                                   } else {
-                                       this->expr_result_ =
-                                           static_cast<RightType>(static_cast<RightType>(left) ^ right);
-                                   }
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply {} operator to {} and {}", node->op(),
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case LEFT_SHIFT:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, node, &location](auto left, auto right) {
-                               using LeftType = std::remove_cvref_t<decltype(left)>;
-                               using RightType = std::remove_cvref_t<decltype(right)>;
-                               if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
-                                   this->expr_result_ = static_cast<LeftType>(left << right);
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply {} operator to {} and {}", node->op(),
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
-        case RIGHT_SHIFT:
-            std::visit(std::bind(
-                           deref_and_apply,
-                           [this, node, &location](auto left, auto right) {
-                               using LeftType = std::remove_cvref_t<decltype(left)>;
-                               using RightType = std::remove_cvref_t<decltype(right)>;
-                               if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
-                                   this->expr_result_ = static_cast<LeftType>(left >> right);
-                               } else {
-                                   throw TypeError(fmt::format("cannot apply {} operator to {} and {}", node->op(),
-                                                               typeid(LeftType), typeid(RightType)),
-                                                   location);
-                               }
-                           },
-                           _1, _2),
-                       lhs, rhs);
-            break;
+    if (not std::holds_alternative<VariableReference>(target)) {
+        // 演算の誤りを、左辺が参照でないことより先に報告する
+        binary_(node->op(), target, value, std::nullopt, location);
+        throw TypeError("cannot assign to rvalue", location);
     }
+    auto& variable = variable_(std::get<VariableReference>(target));
+    expr_result_ = binary_(node->op(), variable.value, value, node->operand_types(), location);
+    if (expr_result_.index() == variable.value.index()) {
+        variable.value = expr_result_;
+    } else {
+        assign_(variable, expr_result_, location);
+    }
+}
+void Interpreter::visit(const ast::LogicalOperator* node) {
+    // leftだけで結果が決まれば、rightは評価しない
+    bool is_and = node->op() == ast::LogicalOperator::OperatorType::AND;
+    bool left = evaluate_bool_(node->left().get());
+    if (left != is_and) {
+        expr_result_ = left;
+        return;
+    }
+    expr_result_ = evaluate_bool_(node->right().get());
 }
 void Interpreter::visit(const ast::UnaryOperator* node) {
     node->operand()->accept(*this);
@@ -628,126 +182,123 @@ void Interpreter::visit(const ast::UnaryOperator* node) {
     auto operand = expr_result_;
 
     while (std::holds_alternative<VariableReference>(operand)) {
-        operand = variables_[std::get<VariableReference>(operand).key].value;
+        operand = variable_(std::get<VariableReference>(operand)).value;
     }
 
-    auto location = node->location();
-    switch (node->op()) {
-        using enum ast::UnaryOperator::OperatorType;
-        using namespace std::placeholders;
-        case PLUS:
-            std::visit(
-                [this, &location](auto operand) {
-                    using OperandType = decltype(operand);
-                    using Operand = std::numeric_limits<OperandType>;
-                    if constexpr (std::is_convertible_v<OperandType, VariableReference>) {
-                        throw TypeError(fmt::format("cannot apply unary PLUS operator to {}", typeid(OperandType)),
-                                        location);
-                    } else if constexpr (Operand::is_specialized) {
-                        this->expr_result_ = static_cast<OperandType>(+operand);
-                    } else {
-                        throw TypeError(fmt::format("cannot apply unary PLUS operator to {}", typeid(OperandType)),
-                                        location);
-                    }
-                },
-                operand);
-            break;
-        case MINUS:
-            std::visit(
-                [this, &location](auto operand) {
-                    using OperandType = decltype(operand);
-                    using Operand = std::numeric_limits<OperandType>;
-                    if constexpr (std::is_convertible_v<OperandType, VariableReference>) {
-                        throw TypeError(fmt::format("cannot apply unary PLUS operator to {}", typeid(OperandType)),
-                                        location);
-                    } else if constexpr (Operand::is_specialized) {
-                        this->expr_result_ = static_cast<OperandType>(-operand);
-                    } else {
-                        throw TypeError(fmt::format("cannot apply unary MINUS operator to {}", typeid(OperandType)),
-                                        location);
-                    }
-                },
-                operand);
-            break;
-        case BOOL_NOT:
-            std::visit(
-                [this, &location](auto operand) {
-                    using OperandType = decltype(operand);
-                    if constexpr (std::is_same_v<std::remove_cvref_t<OperandType>, bool>) {
-                        this->expr_result_ = static_cast<bool>(not operand);
-                    } else {
-                        throw TypeError(fmt::format("cannot apply BOOL_NOT operator to {}", typeid(OperandType)),
-                                        location);
-                    }
-                },
-                operand);
-            break;
-        case BIT_NOT:
-            std::visit(
-                [this, &location](auto operand) {
-                    using OperandType = decltype(operand);
-                    using Operand = std::numeric_limits<OperandType>;
-                    if constexpr (Operand::is_specialized && Operand::is_integer) {
-                        if constexpr (not std::is_same_v<std::remove_cvref_t<OperandType>, bool>) {
-                            this->expr_result_ = static_cast<OperandType>(~operand);
-                        } else {
-                            this->expr_result_ = !operand;
-                        }
-                    } else {
-                        throw TypeError(fmt::format("cannot apply BIT_NOT operator to {}", typeid(OperandType)),
-                                        location);
-                    }
-                },
-                operand);
-            break;
+    if (auto type = node->operand_type(); type.has_value()) {
+        expr_result_ = semantics::UnaryDispatchTable<Value>::find(node->op(), *type)(operand);
+        return;
     }
+    auto handler = semantics::UnaryDispatchTable<Value>::find(node->op(), operand.index());
+    if (handler == nullptr) {
+        std::visit(
+            [node](const auto& operand) {
+                throw TypeError(fmt::format("cannot apply {} operator to {}", node->op(), typeid(operand)),
+                                node->location());
+            },
+            operand);
+    }
+    expr_result_ = handler(operand);
 }
 void Interpreter::visit(const ast::VariableReference* node) {
-    Scope* scope = current_scope_;
-    auto name = node->name().source_id();
-    while (scope != nullptr) {
-        if (scope->keymap->contains(name)) {
+    if (auto binding = node->binding(); binding.has_value()) {
+        Scope* scope = current_scope_;
+        for (std::uint32_t i = 0; i < binding->depth; i++) {
+            scope = scope->parent;
+        }
+        // 宣言より前に実行された場合(グローバル変数の初期化中など)はまだ空いている
+        auto key = scope->base + binding->slot;
+        if (stack_[key].is_declared) {
             // ASSIGN演算子の都合上値ではなく参照を返す
-            expr_result_ = VariableReference((*(scope->keymap))[name]);
+            expr_result_ = VariableReference(key);
             return;
         }
-        scope = scope->parent;
     }
-    throw NameError(fmt::format("variable '{}' is not defined", SimpleFlyWeight::instance().value(name)),
-                    node->location());
+    throw NameError(fmt::format("variable '{}' is not defined", node->name().source_name()), node->location());
 }
 void Interpreter::visit(const ast::SignedIntegerLiteral* node) { expr_result_ = node->value(); }
 void Interpreter::visit(const ast::UnsignedIntegerLiteral* node) { expr_result_ = node->value(); }
 void Interpreter::visit(const ast::FloatingPointLiteral* node) { expr_result_ = node->value(); }
-void Interpreter::visit(const ast::StringLiteral* node) { expr_result_ = node->value(); }
+void Interpreter::visit(const ast::StringLiteral* node) { expr_result_ = SharedString(node->value()); }
 void Interpreter::visit(const ast::BooleanLiteral* node) { expr_result_ = node->value(); }
 void Interpreter::visit(const ast::NilLiteral*) { expr_result_ = NilType{}; }
-void Interpreter::visit(const ast::FunctionCall* node) {
+void Interpreter::visit(const ast::FunctionCall* node) { call_(node, callee_(node)); }
+Interpreter::Callee Interpreter::callee_(const ast::FunctionCall* node) {
+    auto site = node->call_site();
+    if (site.has_value()) {
+        const auto& cache = call_caches_[site->site];
+        const auto& variable = stack_[global_scope_->base + site->slot];
+        const auto* reference = std::get_if<FunctionReference>(&variable.value);
+        if (cache.function != nullptr && variable.is_declared && reference != nullptr && reference->key == cache.key) {
+            return cache;
+        }
+    }
     node->callee()->accept(*this);
-    auto raw_callee = expr_result_;
-    while (std::holds_alternative<VariableReference>(raw_callee)) {
-        raw_callee = variables_.at(std::get<VariableReference>(raw_callee).key).value;
+    const Value* raw_callee = &expr_result_;
+    while (std::holds_alternative<VariableReference>(*raw_callee)) {
+        raw_callee = &variable_(std::get<VariableReference>(*raw_callee)).value;
     }
-    std::visit(
-        [this, node](auto callee) {
-            if constexpr (not std::is_convertible_v<decltype(callee), FunctionReference>) {
+    const auto* callee = std::get_if<FunctionReference>(raw_callee);
+    if (callee == nullptr) {
+        std::visit(
+            [node](const auto& callee) {
                 throw TypeError(fmt::format("{} cannot be called", typeid(callee)), node->location());
-            } else {
-                ArgType args;
-                for (const auto& arg : node->args()) {
-                    arg->accept(*this);
-                    args.push_back(expr_result_);
-                }
-                expr_result_ = functions_[callee.key](args, {});
-            }
-        },
-        raw_callee);
+            },
+            *raw_callee);
+    }
+    // 関数の再定義は同じ要素を上書きするので、要素へのポインタは指す関数ごと最新に保たれる
+    Callee result{.key = callee->key, .function = &functions_[callee->key]};
+    if (auto frame = frames_.find(callee->key); frame != frames_.end()) {
+        result.frame = &frame->second;
+    }
+    if (site.has_value()) {
+        call_caches_[site->site] = result;
+    }
+    return result;
+}
+void Interpreter::call_(const ast::FunctionCall* node, const Callee& callee) {
+    const auto& args = node->args();
+    auto result_slot = stack_.size();
+    stack_.push_back({.name_id = {}, .value = NilType{}});
+    for (const auto& arg : args) {
+        arg->accept(*this);
+        stack_.push_back({.name_id = {}, .value = expr_result_});
+    }
+    if (callee.frame != nullptr) {
+        if (profiler_ != nullptr) {
+            profiler_->call_from(node);
+        }
+        call_function_(callee.frame, result_slot + 1, args.size());
+    } else {
+        (*callee.function)(result_slot + 1, args.size());
+    }
+    expr_result_ = std::move(stack_[result_slot].value);
+    stack_.resize(result_slot);
 }
 void Interpreter::visit(const ast::CompilationUnit* node) {
-    Scope scope(nullptr, &variables_);
+    Scope scope(nullptr, stack_, 0);
     current_scope_ = &scope;
     global_scope_ = &scope;
     init_builtin_functions_();
+    node->accept(resolver_);
+    call_caches_.resize(resolver_.call_site_count());
+    check_types_(*node);
+    if (memo_capacity_ > 0 || jit_threshold_ > 0) {
+        PurityAnalyzer analyzer;
+        for (auto slot : builtin_slots_) {
+            analyzer.declare_builtin(slot);
+        }
+        pure_functions_ = analyzer.analyze(*node);
+        if (jit_threshold_ > 0) {
+            jit_ = std::make_unique<jit::Compiler>(type_rules_(), type_indices_(), jit::numeric_types<Value>(),
+                                                   analyzer.fixed_functions());
+        }
+    }
+    if (profiler_ != nullptr) {
+        profiler_->start();
+    }
+    // グローバルスコープは最下段にあるので、組み込み関数を置いた後からでも広げられる
+    stack_.resize(resolver_.global_frame_size());
     for (const auto& child : node->children()) {
         const auto& raw = *child;
         if (typeid(raw) == typeid(ast::FunctionDef)) {
@@ -756,44 +307,172 @@ void Interpreter::visit(const ast::CompilationUnit* node) {
             child->accept(*this);
         }
     }
-    functions_[encode_function_key_("main")]({0}, {});
+    auto result_slot = stack_.size();
+    stack_.push_back({.name_id = {}, .value = NilType{}});
+    stack_.push_back({.name_id = {}, .value = 0});
+    functions_[encode_function_key_("main")](result_slot + 1, 1);
+    stack_.resize(result_slot);
     current_scope_ = nullptr;
+    if (profiler_ != nullptr) {
+        profiler_->stop();
+    }
+}
+const semantics::TypeRules& Interpreter::type_rules_() {
+    static const auto rules = [] {
+        auto rules = semantics::make_type_rules<Value, NilType, FunctionReference>();
+        // IfStatementとAssertStatementは、条件式の変数を値に変換せずに評価する
+        rules.reference = &typeid(VariableReference);
+        return rules;
+    }();
+    return rules;
+}
+std::unordered_map<Interpreter::TypeKey, std::size_t> Interpreter::type_indices_() const {
+    std::unordered_map<TypeKey, std::size_t> type_indices;
+    for (const auto& [key, zero] : types_) {
+        type_indices[key] = zero().index();
+    }
+    return type_indices;
+}
+void Interpreter::check_types_(const ast::CompilationUnit& unit) {
+    auto type_indices = type_indices_();
+    TypeChecker checker(type_rules_(), type_indices);
+    for (auto slot : builtin_slots_) {
+        checker.declare_builtin(slot);
+    }
+    checker.check(unit);
+}
+void Interpreter::check(const ast::CompilationUnit& unit) {
+    Scope scope(nullptr, stack_, 0);
+    global_scope_ = &scope;
+    init_builtin_functions_();
+    unit.accept(resolver_);
+    check_types_(unit);
+    global_scope_ = nullptr;
 }
 void Interpreter::visit(const ast::FunctionDef* node) {
     auto info = node->info();
-    register_function_(info.name().source_name(), [this, node, info](const ArgType& args, const KwArgType& kwargs) {
-        auto previous_scope = current_scope_;
-        Scope arg_scope(global_scope_, &variables_);
-        current_scope_ = &arg_scope;
-        auto arg_iter = args.begin();
-        for (const auto& arginfo : info.args()) {
-            Value arg_value;
-            auto name = arginfo.name();
-            if (kwargs.contains(name.source_id())) {
-                arg_value = kwargs.at(name.source_id());
-            } else if (arg_iter != args.end()) {
-                arg_value = *arg_iter;
-                ++arg_iter;
-            } else {
+    FunctionFrame frame{.node = node};
+    for (const auto& arginfo : info.args()) {
+        frame.arg_names.push_back(arginfo.name());
+        frame.arg_locations.push_back(arginfo.location());
+        frame.arg_types.push_back(types_.at(arginfo.type().name().source_id())());
+    }
+    auto return_type = info.result()->type().name();
+    using namespace ast::operators;
+    static const ast::SourceTypeIdentifier void_type{"void"};
+    static const ast::SourceTypeIdentifier nil_type{"NilType"};
+    if (return_type == void_type) {
+        return_type = nil_type;
+    }
+    frame.result_name = info.result()->name().source_id();
+    frame.result_type = types_.at(return_type.source_id())();
+    if (memo_capacity_ > 0 && pure_functions_.contains(node)) {
+        frame.memo.emplace(memo_capacity_);
+    }
+    // 再定義されたら同じ要素を上書きする
+    auto& stored = frames_[encode_function_key_(info.name().source_name())];
+    stored = std::move(frame);
+    auto function = [this, frame = &stored](VariableKey base, std::size_t count) {
+        call_function_(frame, base, count);
+    };
+    register_function_(info.name().source_name(), function, node->slot().value());
+}
+void Interpreter::call_function_(FunctionFrame* frame, VariableKey base, std::size_t count) {
+    auto previous_scope = current_scope_;
+    auto previous_return_slot = return_slot_;
+    auto pending = memo_pending_.size();
+    // 戻り値は引数のスコープの外にあり、どの名前からも参照されない
+    return_slot_ = base - 1;
+    if (profiler_ != nullptr) {
+        profiler_->enter(frame->node);
+    }
+    for (;;) {
+        const auto* node = frame->node;
+        const auto& arg_slots = node->arg_slots();
+        for (std::size_t i = 0; i < frame->arg_types.size(); i++) {
+            if (i >= count) {
                 throw InvalidArgument("insufficient argument", node->location());
             }
-            declare_variable_(name, arginfo.type().name(), arg_value, arginfo.location());
+            // 引数の名前が重複していると、Resolverは同じ番号を割り当てる
+            if (arg_slots[i] != i) {
+                throw InvalidRedeclarationError(std::format("variable {} is already declared in this scope.",
+                                                            frame->arg_names[i].source_name()),
+                                                frame->arg_locations[i]);
+            }
+            auto& arg = stack_[base + i];
+            arg.value = convert_(frame->arg_types[i], arg.value, frame->arg_locations[i]);
+            arg.name_id = frame->arg_names[i].source_id();
+            arg.is_declared = true;
         }
-        auto return_type = info.result()->type().name();
-        using namespace ast::operators;
-        static const ast::SourceTypeIdentifier void_type{"void"};
-        static const ast::SourceTypeIdentifier nil_type{"NilType"};
-        if (return_type == void_type) {
-            return_type = nil_type;
+        stack_[return_slot_] = {.name_id = frame->result_name, .value = frame->result_type};
+        if (jit_ && not frame->memo.has_value() && (frame->native != nullptr || ++frame->calls == jit_threshold_)) {
+            if (frame->native == nullptr) {
+                frame->native = jit_->compile(node);
+            }
+            if (frame->native != nullptr) {
+                // 末尾呼び出しの連なりは機械語の中でたどるので、戻ってきた時点で呼び出しは終わっている
+                auto args = jit_args_.size();
+                for (std::size_t i = 0; i < frame->arg_types.size(); i++) {
+                    jit_args_.push_back(jit::to_native(stack_[base + i].value));
+                }
+                auto result = jit_->run(frame->native, jit_args_.data() + args);
+                jit_args_.resize(args);
+                stack_[return_slot_].value = jit::from_native<Value>(frame->result_type.index(), result);
+                stack_.resize(base);
+                break;
+            }
         }
-        auto return_loc = info.result()->location();
-        declare_variable_(info.result()->name(), return_type, std::nullopt, return_loc);
-        node->block()->accept(*this);
-        auto result = variables_.at(current_scope_->keymap->at(RETURN_SPECIAL_VARNAME_ID));
-        is_returned_ = false;
-        current_scope_ = previous_scope;
-        return result.value;
-    });
+        if (frame->memo.has_value()) {
+            // 本体が引数の変数を書き換えてもよいように、実引数を写してからキーにする
+            auto args = memo_args_.size();
+            for (std::size_t i = 0; i < frame->arg_types.size(); i++) {
+                memo_args_.push_back(stack_[base + i].value);
+            }
+            if (const auto* result = frame->memo->find({memo_args_.begin() + args, memo_args_.end()})) {
+                stack_[return_slot_].value = *result;
+                memo_args_.resize(args);
+                stack_.resize(base);
+                break;
+            }
+            memo_pending_.push_back({.cache = &*frame->memo, .args = args});
+        }
+        {
+            // 余分な実引数はここで捨てられる
+            Scope arg_scope(global_scope_, stack_, base, node->arg_frame_size());
+            current_scope_ = &arg_scope;
+            node->block()->accept(*this);
+            is_returned_ = false;
+        }
+        if (not tail_call_.has_value()) {
+            break;
+        }
+        // 末尾呼び出しの実引数を、このフレームの引数の位置へ移す
+        auto [next, args] = *std::exchange(tail_call_, std::nullopt);
+        frame = next;
+        if (profiler_ != nullptr) {
+            profiler_->replace(frame->node);
+        }
+        count = tail_args_.size() - args;
+        for (auto i = args; i < tail_args_.size(); i++) {
+            stack_.push_back({.name_id = {}, .value = std::move(tail_args_[i])});
+        }
+        tail_args_.resize(args);
+    }
+    if (memo_pending_.size() > pending) {
+        const auto& result = stack_[return_slot_].value;
+        for (auto i = pending; i < memo_pending_.size(); i++) {
+            auto end = i + 1 < memo_pending_.size() ? memo_pending_[i + 1].args : memo_args_.size();
+            memo_pending_[i].cache->insert({memo_args_.begin() + memo_pending_[i].args, memo_args_.begin() + end},
+                                           result);
+        }
+        memo_args_.resize(memo_pending_[pending].args);
+        memo_pending_.resize(pending);
+    }
+    if (profiler_ != nullptr) {
+        profiler_->leave();
+    }
+    current_scope_ = previous_scope;
+    return_slot_ = previous_return_slot;
 }
 void Interpreter::visit(const ast::VariableDeclStatement* node) {
     for (const auto& child : node->children()) {
@@ -801,15 +480,43 @@ void Interpreter::visit(const ast::VariableDeclStatement* node) {
     }
 }
 void Interpreter::visit(const ast::ReturnStatement* node) {
-    ast::BinaryOperator(ast::BinaryOperator::OperatorType::ASSIGN,
-                        std::make_shared<ast::VariableReference>(ast::SourceVariableIdentifier{RETURN_SPECIAL_VARNAME},
-                                                                 ValRef::VALUE, node->location()),
-                        node->retval(), node->location())
-        .accept(*this);
+    if (const auto* call = node->tail_call(); call != nullptr) {
+        auto callee = callee_(call);
+        // 戻り値の型が同じGarnetの関数なら戻り値を変換しなくてよいので、今のフレームを明け渡せる
+        if (callee.frame != nullptr && callee.frame->result_type.index() == stack_[return_slot_].value.index()) {
+            auto args = tail_args_.size();
+            for (const auto& arg : call->args()) {
+                arg->accept(*this);
+                tail_args_.push_back(expr_result_);
+            }
+            // 通常の呼び出しと同じく、全ての実引数を評価してから変数を値に変換する
+            for (auto i = args; i < tail_args_.size(); i++) {
+                if (std::holds_alternative<VariableReference>(tail_args_[i])) {
+                    tail_args_[i] = variable_(std::get<VariableReference>(tail_args_[i])).value;
+                }
+            }
+            tail_call_ = TailCall{.frame = callee.frame, .args = args};
+            is_returned_ = true;
+            return;
+        }
+        call_(call, callee);
+    } else {
+        node->retval()->accept(*this);
+    }
+    auto& result = stack_[return_slot_];
+    const auto& value = std::holds_alternative<VariableReference>(expr_result_)
+                            ? variable_(std::get<VariableReference>(expr_result_)).value
+                            : expr_result_;
+    // 宣言された型の値なら変換は要らない
+    if (value.index() == result.value.index()) {
+        result.value = value;
+    } else {
+        assign_(result, value, node->location());
+    }
     is_returned_ = true;
 }
 void Interpreter::visit(const ast::Block* node) {
-    Scope scope(current_scope_, &variables_);
+    Scope scope(current_scope_, stack_, node->frame_size());
     current_scope_ = &scope;
     for (const auto& sentence : node->sentences()) {
         sentence->accept(*this);
@@ -820,14 +527,69 @@ void Interpreter::visit(const ast::Block* node) {
     current_scope_ = scope.parent;
 }
 void Interpreter::visit(const ast::LoopStatement* node) {
-    while (not is_broken_) {
+    while (not is_broken_ && not is_returned_) {
         node->block()->accept(*this);
     }
     is_broken_ = false;
 }
+bool Interpreter::evaluate_bool_(const ast::Expression* expr) {
+    expr->accept(*this);
+    const Value* value = &expr_result_;
+    if (std::holds_alternative<VariableReference>(*value)) {
+        value = &variable_(std::get<VariableReference>(*value)).value;
+    }
+    const auto* result = std::get_if<bool>(value);
+    if (result == nullptr) {
+        std::visit(
+            [expr](const auto& value) {
+                throw TypeError(fmt::format("{} is not bool", typeid(value)), expr->location());
+            },
+            *value);
+    }
+    return *result;
+}
+void Interpreter::visit(const ast::WhileStatement* node) {
+    while (evaluate_bool_(node->cond().get())) {
+        node->block()->accept(*this);
+        if (is_broken_ || is_returned_) {
+            break;
+        }
+    }
+    is_broken_ = false;
+}
+void Interpreter::visit(const ast::DoWhileStatement* node) {
+    do {
+        node->block()->accept(*this);
+        if (is_broken_ || is_returned_) {
+            break;
+        }
+    } while (evaluate_bool_(node->cond().get()));
+    is_broken_ = false;
+}
+void Interpreter::visit(const ast::ForStatement* node) {
+    // initの変数はループ全体で一つのスコープに置く
+    Scope scope(current_scope_, stack_, node->frame_size());
+    current_scope_ = &scope;
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+    }
+    const auto& cond = node->cond();
+    const auto& update = node->update();
+    while (not cond.has_value() || evaluate_bool_(cond.value().get())) {
+        node->block()->accept(*this);
+        if (is_broken_ || is_returned_) {
+            break;
+        }
+        if (update.has_value()) {
+            update.value()->accept(*this);
+        }
+    }
+    is_broken_ = false;
+    current_scope_ = scope.parent;
+}
 void Interpreter::visit(const ast::BreakStatement*) { is_broken_ = true; }
 void Interpreter::visit(const ast::IfStatement* node) {
-    for (auto [raw_cond, block] : node->cond_blocks()) {
+    for (const auto& [raw_cond, block] : node->cond_blocks()) {
         if (raw_cond.use_count() == 0) {
             block->accept(*this);
             break;
@@ -884,53 +646,61 @@ Interpreter::Interpreter() {
     types_[encode_type_key_("i64")] = [] { return Value(static_cast<std::int64_t>(0)); };
     types_[encode_type_key_("f32")] = [] { return Value(static_cast<float>(0)); };
     types_[encode_type_key_("f64")] = [] { return Value(static_cast<double>(0)); };
-    types_[encode_type_key_("str")] = [] { return Value(static_cast<std::string>("")); };
+    types_[encode_type_key_("str")] = [] { return Value(SharedString()); };
     types_[encode_type_key_("NilType")] = [] { return Value(static_cast<NilType>(NilType{})); };
 }
-void Interpreter::debug_print() const { fmt::println("variables: {}", variables_); }
+void Interpreter::debug_print() const {
+    fmt::println("variables: {}", stack_);
+    for (const auto& [key, frame] : frames_) {
+        if (frame.memo.has_value()) {
+            const auto& memo = frame.memo.value();
+            fmt::println("memo {}: hits: {}, misses: {}, entries: {}/{}", SimpleFlyWeight::instance().value(key),
+                         memo.hits(), memo.misses(), memo.size(), memo.capacity());
+        }
+        if (frame.native != nullptr) {
+            fmt::println("jit {}: compiled after {} calls", SimpleFlyWeight::instance().value(key), frame.calls);
+        }
+    }
+}
 std::string Interpreter::Variable::to_string() const {
     return fmt::format("Variable(name: {}, value: {})", name_id, value);
 }
 std::string Interpreter::VariableReference::to_string() const { return fmt::format("VariableReference(key: {})", key); }
 std::string Interpreter::FunctionReference::to_string() const { return fmt::format("FunctionReference(key: {})", key); }
-Interpreter::Value Interpreter::print_(ArgType args, KwArgType kwargs) {
-    (void)kwargs;
-    for (size_t i = 0; auto arg : args) {
+void Interpreter::print_(VariableKey base, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
         // VariableReferenceExpressionの都合上どんな変数でもVariableReferenceで覆われているので、剥がす
         // その中身がVariableReferenceでもそれは追わない
-        if (std::holds_alternative<VariableReference>(arg)) {
-            arg = variables_.at(std::get<VariableReference>(arg).key).value;
+        const Value* arg = &stack_[base + i].value;
+        if (std::holds_alternative<VariableReference>(*arg)) {
+            arg = &variable_(std::get<VariableReference>(*arg)).value;
         }
-        std::visit([](auto value) { fmt::print("{}", value); }, arg);
-        if (i < args.size() - 1) {
+        std::visit([](const auto& value) { fmt::print("{}", value); }, *arg);
+        if (i < count - 1) {
             fmt::print(" ");
         }
-        i++;
     }
-    return NilType{};
 }
-Interpreter::Value Interpreter::println_(ArgType args, KwArgType kwargs) {
-    print_(args, kwargs);
+void Interpreter::println_(VariableKey base, std::size_t count) {
+    print_(base, count);
     fmt::println("");
-    return NilType{};
 }
 void Interpreter::init_builtin_functions_() {
     using namespace std::placeholders;
-    register_function_("print", std::bind(std::mem_fn(&Interpreter::print_), std::ref(*this), _1, _2));
-    register_function_("println", std::bind(std::mem_fn(&Interpreter::println_), std::ref(*this), _1, _2));
+    auto register_builtin = [this](const std::string& name, Function func) {
+        auto slot = resolver_.declare_global(SimpleFlyWeight::instance().id(name));
+        stack_.resize(resolver_.global_frame_size());
+        builtin_slots_.push_back(slot);
+        register_function_(name, std::move(func), slot);
+    };
+    register_builtin("print", std::bind(std::mem_fn(&Interpreter::print_), std::ref(*this), _1, _2));
+    register_builtin("println", std::bind(std::mem_fn(&Interpreter::println_), std::ref(*this), _1, _2));
 }
-void Interpreter::register_function_(const std::string& name, Function func) {
+void Interpreter::register_function_(const std::string& name, Function func, Slot slot) {
     functions_[encode_function_key_(name)] = func;
-    VariableKey var_key = key_generator_();
-    variables_[var_key] = {.name_id = SimpleFlyWeight::instance().id(name),
-                           .value = FunctionReference{encode_function_key_(name)}};
-    (*(global_scope_->keymap))[SimpleFlyWeight::instance().id(name)] = var_key;
-}
-Interpreter::Scope::~Scope() {
-    for (const auto& [name, key] : *keymap) {
-        varmap_->erase(key);
-    }
-    keymap->clear();
-    InstancePool<KeyMapType>::return_instance(keymap);
+    // 関数の再定義、または同名のグローバル変数があれば、その変数を上書きする
+    stack_[global_scope_->base + slot] = {.name_id = SimpleFlyWeight::instance().id(name),
+                                          .value = FunctionReference{encode_function_key_(name)},
+                                          .is_declared = true};
 }
 }  // namespace Garnet::interpreter
@@ -5,32 +5,38 @@
 #include <fmt/base.h>
 #include <fmt/format.h>
 
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
+#include "concrete_expressions.hpp"
 #include "concrete_source_identifiers.hpp"
 #include "flyweight.hpp"
 #include "format_support.hpp"  // NOLINT
-#include "instance_pool.hpp"
+#include "jit/compiler.hpp"
 #include "location.hpp"
+#include "memo_cache.hpp"
+#include "profiler.hpp"
+#include "resolver.hpp"
+#include "shared_string.hpp"
 #include "visitor/visitor.hpp"
 namespace Garnet {
 namespace ast {
 class Expression;
+class CompilationUnit;
 }
 namespace interpreter {
 class Interpreter : public ast::Visitor {
-    // using VariableKey = boost::uuids::uuid;
-    // boost::uuids::random_generator key_generator_;
-    using VariableKey = std::uint64_t;
-    VariableKey counter_ = 0;
-    VariableKey key_generator_() { return counter_++; }
+    // stack_上の位置。stack_は伸長時に再確保されるので、ポインタではなく位置で指す
+    using VariableKey = std::size_t;
     struct VariableReference {
         VariableKey key;
         explicit VariableReference() = default;
@@ -53,9 +59,11 @@ class Interpreter : public ast::Visitor {
         using std::monostate::monostate;
     };
     friend fmt::formatter<NilType>;
+    // 文字列は参照カウントで共有し、どの型も8バイトに収めて、Value全体を16バイトにする
     using Value = std::variant<NilType, std::uint8_t, std::int8_t, std::uint16_t, std::int16_t, std::uint32_t,
-                               std::int32_t, std::int64_t, std::uint64_t, float, double, bool, std::string,
+                               std::int32_t, std::int64_t, std::uint64_t, float, double, bool, SharedString,
                                VariableReference, FunctionReference>;
+    static_assert(sizeof(Value) == 16);
 
     Value expr_result_;
     Value func_result_;
@@ -64,57 +72,156 @@ class Interpreter : public ast::Visitor {
     struct Variable {
         VariableNameType name_id;
         Value value;
+        // スコープの領域は確保済みでも、宣言文を実行するまではfalse
+        bool is_declared = false;
 
         std::string to_string() const;
     };
 
+    using Slot = std::uint32_t;
     void declare_variable_(ast::SourceVariableIdentifier name, ast::SourceTypeIdentifier type,
-                           std::optional<Value> value, location::SourceRegion location = {});
+                           std::optional<Value> value, Slot slot, location::SourceRegion location = {});
+    void assign_(Variable& target, const Value& source, location::SourceRegion location);
+    // sourceをtypeの型に変換した値を返す。sourceが変数への参照なら、その値を変換する
+    Value convert_(const Value& type, const Value& source, location::SourceRegion location);
+    Value binary_(ast::BinaryOperator::OperatorType op, const Value& left, const Value& right,
+                  std::optional<std::array<std::uint8_t, 2>> types, location::SourceRegion location);
+    // ループの条件式やand/orの被演算子を評価する。boolでなければTypeErrorを投げる
+    bool evaluate_bool_(const ast::Expression* expr);
 
-    using VariableMap = std::unordered_map<VariableKey, Variable>;
-    VariableMap variables_;
+    // 全スコープの変数を一本に積む。各スコープは[base, base + 宣言数)を占める
+    std::vector<Variable> stack_;
+    Variable& variable_(VariableReference reference) { return stack_[reference.key]; }
 
     struct Scope {
         Scope* parent = nullptr;
-        using KeyMapType = std::unordered_map<VariableNameType, VariableKey>;
-        KeyMapType* keymap;
-        Scope(Scope* parent, VariableMap* varmap)
-            : parent(parent), keymap(InstancePool<KeyMapType>::aquire()), varmap_(varmap) {}
-
-        ~Scope();
+        VariableKey base;
+        // 大きさはResolverが数えた宣言数で、生成時にまとめて確保し、破棄時にまとめて解放する
+        Scope(Scope* parent, std::vector<Variable>& stack, std::size_t size)
+            : Scope(parent, stack, stack.size(), size) {}
+        // 既に積まれている[base, stack.size())を、そのままスコープの先頭として使う
+        Scope(Scope* parent, std::vector<Variable>& stack, VariableKey base, std::size_t size)
+            : parent(parent), base(base), stack_(stack) {
+            stack.resize(base + size);
+        }
+        Scope(const Scope&) = delete;
+        ~Scope() { stack_.resize(base); }
 
        private:
-        VariableMap* varmap_;
+        std::vector<Variable>& stack_;
     };
 
     Scope* current_scope_ = nullptr;
     Scope* global_scope_ = nullptr;
+    // 実行中の関数の戻り値を書き込むstack_上の位置
+    VariableKey return_slot_ = 0;
+
+    Resolver resolver_;
 
-    using ArgType = std::vector<Value>;
-    using KwArgType = std::unordered_map<VariableNameType, Value>;
-    using Function = std::function<Value(const ArgType&, const KwArgType&)>;
+    // 呼び出し側は戻り値の領域をstack_[base - 1]に、実引数を[base, base + count)に積んでから関数を呼ぶ
+    // 関数は実引数の領域をそのまま引数のスコープとして使い、戻り値を直接stack_[base - 1]に書き込む
+    // 戻り値の領域はNilTypeで初期化しておき、何も書き込まない関数(組み込み関数)はnilを返したことになる
+    using Function = std::function<void(VariableKey base, std::size_t count)>;
 
     std::unordered_map<FunctionKey, Function> functions_;
 
-    void register_function_(const std::string& name, Function func);
+    void register_function_(const std::string& name, Function func, Slot slot);
+
+    // 関数定義の時点で決まる、引数と戻り値の型
+    struct FunctionFrame {
+        const ast::FunctionDef* node = nullptr;
+        std::vector<ast::SourceVariableIdentifier> arg_names = {};
+        std::vector<location::SourceRegion> arg_locations = {};
+        // 各引数の型のゼロ値
+        std::vector<Value> arg_types = {};
+        VariableNameType result_name = {};
+        Value result_type = {};
+        // 純粋な関数で、メモ化が有効なら呼び出し結果を覚える
+        std::optional<MemoCache<Value>> memo = std::nullopt;
+        // JITが有効なら、呼び出し回数が閾値に達した時点で機械語に変換する。変換できなければnullptrのまま
+        std::size_t calls = 0;
+        jit::NativeFunction native = nullptr;
+    };
+
+    // Garnetの関数の呼び出し情報。要素への参照は再ハッシュでも無効にならないので、Functionから指す
+    std::unordered_map<FunctionKey, FunctionFrame> frames_;
+
+    // 呼び出し先の関数。Garnetの関数ならframeも指し、組み込み関数ならframeはnullptr
+    struct Callee {
+        FunctionKey key;
+        Function* function = nullptr;
+        FunctionFrame* frame = nullptr;
+    };
+    // calleeがグローバル変数を直接指す呼び出し箇所ごとの、単相のインラインキャッシュ
+    // その変数が前回と同じ関数を指している間は、スコープの走査と関数表の検索を省く
+    // 変数に別の値が代入されると次の呼び出しで一致しなくなるので、引き直して置き換える
+    std::vector<Callee> call_caches_;
+    Callee callee_(const ast::FunctionCall* node);
+    void call_(const ast::FunctionCall* node, const Callee& callee);
+    void call_function_(FunctionFrame* frame, VariableKey base, std::size_t count);
+
+    // 末尾呼び出しでは、実引数をtail_args_の[args, end)に置いてから呼び出し元の関数まで戻り、
+    // 呼び出し元のフレームの上で呼び出し先の本体を実行する。ネイティブのスタックは伸びない
+    struct TailCall {
+        FunctionFrame* frame;
+        std::size_t args;
+    };
+    std::optional<TailCall> tail_call_;
+    std::vector<Value> tail_args_;
+
+    // 0ならメモ化しない
+    std::size_t memo_capacity_ = 0;
+    std::unordered_set<const ast::FunctionDef*> pure_functions_;
+    // 結果を覚える呼び出しの実引数は、本体の実行前にmemo_args_の[args, 次の要素のargs)へ写しておく
+    // 末尾呼び出しで連なった呼び出しは、全て最後の呼び出しの結果を覚える
+    struct PendingMemo {
+        MemoCache<Value>* cache;
+        std::size_t args;
+    };
+    std::vector<PendingMemo> memo_pending_;
+    std::vector<Value> memo_args_;
+
+    // 0ならJITを使わない
+    std::size_t jit_threshold_ = 0;
+    std::unique_ptr<jit::Compiler> jit_;
+    std::vector<std::uint64_t> jit_args_;
+
+    // nullptrなら標本化しない
+    Profiler* profiler_ = nullptr;
 
     /* builtin functions */
-    Value print_(ArgType args, KwArgType kwargs);
-    Value println_(ArgType args, KwArgType kwargs);
+    void print_(VariableKey base, std::size_t count);
+    void println_(VariableKey base, std::size_t count);
 
     void init_builtin_functions_();
+    std::vector<Slot> builtin_slots_;
 
     using TypeKey = SimpleFlyWeight::id_type;
     TypeKey encode_type_key_(std::string name) const;
     std::unordered_map<TypeKey, std::function<Value()>> types_;
 
     void gather_global_decls_();
+    // 型検査とJITで共有する、Valueの型の規則と、型名からValueの型の番号への表
+    static const semantics::TypeRules& type_rules_();
+    std::unordered_map<TypeKey, std::size_t> type_indices_() const;
+    void check_types_(const ast::CompilationUnit& unit);
 
     bool is_broken_ = false;
     bool is_returned_ = false;
 
    public:
     Interpreter();
+    // 純粋な関数の呼び出し結果を、関数ごとに最大capacity個まで覚える
+    void enable_memoization(std::size_t capacity) { memo_capacity_ = capacity; }
+    // threshold回呼び出された関数を機械語に変換して実行する。このプラットフォームで使えなければ何もしない
+    void enable_jit(std::size_t threshold) { jit_threshold_ = jit::Compiler::is_supported() ? threshold : 0; }
+    // プログラムを実行している間、profilerで呼び出し列を標本化する
+    void enable_profiling(Profiler* profiler) { profiler_ = profiler; }
+    // 実行せずに、名前の解決と型の検査だけを行う。型の誤りがあればTypeErrorを投げる
+    // 他の実行エンジンやCへの変換の前に呼び、この解釈器と同じ誤りを報告する。呼んだ後のInterpreterでは実行しない
+    void check(const ast::CompilationUnit& unit);
+    // Valueのindex番目の型。他の実行エンジンが、この解釈器と同じ型の名前で誤りを報告するのに使う
+    static const std::type_info& type_info(std::size_t index) { return type_rules_().type_info(index); }
     virtual void visit(const ast::VariableDecl*) override;
     virtual void visit(const ast::TypeDecl*) override;
     virtual void visit(const ast::ErrorNode*) override;
@@ -122,6 +229,8 @@ class Interpreter : public ast::Visitor {
     virtual void visit(const ast::ErrorExpression*) override;
     virtual void visit(const ast::ErrorStatement*) override;
     virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
     virtual void visit(const ast::UnaryOperator*) override;
     virtual void visit(const ast::VariableReference*) override;
     virtual void visit(const ast::SignedIntegerLiteral*) override;
@@ -135,6 +244,9 @@ class Interpreter : public ast::Visitor {
     virtual void visit(const ast::ReturnStatement*) override;
     virtual void visit(const ast::Block*) override;
     virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
     virtual void visit(const ast::BreakStatement*) override;
     virtual void visit(const ast::IfStatement*) override;
     virtual void visit(const ast::AssertStatement*) override;
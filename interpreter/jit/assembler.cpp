@@ -0,0 +1,217 @@
+#include "assembler.hpp"
+
+#include <bit>
+#include <cstring>
+namespace Garnet::interpreter::jit {
+void Assembler::emit_(std::initializer_list<std::uint8_t> bytes) { code_.insert(code_.end(), bytes); }
+void Assembler::emit_imm32_(std::int32_t value) {
+    auto bits = std::bit_cast<std::uint32_t>(value);
+    for (int i = 0; i < 4; i++) {
+        code_.push_back(static_cast<std::uint8_t>(bits >> (i * 8)));
+    }
+}
+void Assembler::emit_imm64_(std::uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        code_.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+    }
+}
+
+Assembler::Patch Assembler::prologue() {
+    emit_({0x55, 0x48, 0x89, 0xE5, 0x48, 0x81, 0xEC});
+    auto patch = here();
+    emit_imm32_(0);
+    return patch;
+}
+void Assembler::patch_imm32_(Patch patch, std::int32_t value) {
+    auto bits = std::bit_cast<std::uint32_t>(value);
+    std::memcpy(&code_[patch], &bits, sizeof(bits));
+}
+void Assembler::patch_frame_size(Patch patch, std::int32_t size) { patch_imm32_(patch, size); }
+void Assembler::epilogue() { emit_({0x31, 0xD2, 0xC9, 0xC3}); }
+void Assembler::leave_ret() { emit_({0xC9, 0xC3}); }
+
+void Assembler::push_rax() { emit_({0x50}); }
+void Assembler::pop_rax() { emit_({0x58}); }
+void Assembler::push_rcx() { emit_({0x51}); }
+void Assembler::pop_rcx() { emit_({0x59}); }
+void Assembler::reserve(std::int32_t size) {
+    emit_({0x48, 0x81, 0xEC});
+    emit_imm32_(size);
+}
+void Assembler::release(std::int32_t size) {
+    emit_({0x48, 0x81, 0xC4});
+    emit_imm32_(size);
+}
+
+void Assembler::mov_rcx_rax() { emit_({0x48, 0x89, 0xC1}); }
+void Assembler::mov_rdi_rax() { emit_({0x48, 0x89, 0xC7}); }
+void Assembler::mov_rsi_rcx() { emit_({0x48, 0x89, 0xCE}); }
+void Assembler::mov_rdi_rsp() { emit_({0x48, 0x89, 0xE7}); }
+void Assembler::xor_eax_eax() { emit_({0x31, 0xC0}); }
+Assembler::Patch Assembler::mov_rax_imm(std::uint64_t value) {
+    emit_({0x48, 0xB8});
+    auto patch = here();
+    emit_imm64_(value);
+    return patch;
+}
+Assembler::Patch Assembler::mov_rcx_imm(std::uint64_t value) {
+    emit_({0x48, 0xB9});
+    auto patch = here();
+    emit_imm64_(value);
+    return patch;
+}
+Assembler::Patch Assembler::mov_rdx_imm(std::uint64_t value) {
+    emit_({0x48, 0xBA});
+    auto patch = here();
+    emit_imm64_(value);
+    return patch;
+}
+Assembler::Patch Assembler::mov_rdi_imm(std::uint64_t value) {
+    emit_({0x48, 0xBF});
+    auto patch = here();
+    emit_imm64_(value);
+    return patch;
+}
+void Assembler::patch_imm64(Patch patch, std::uint64_t value) { std::memcpy(&code_[patch], &value, sizeof(value)); }
+
+void Assembler::load_local(std::int32_t disp) {
+    emit_({0x48, 0x8B, 0x85});
+    emit_imm32_(disp);
+}
+void Assembler::store_local(std::int32_t disp) {
+    emit_({0x48, 0x89, 0x85});
+    emit_imm32_(disp);
+}
+void Assembler::clear_local(std::int32_t disp) {
+    emit_({0x48, 0xC7, 0x85});
+    emit_imm32_(disp);
+    emit_imm32_(0);
+}
+void Assembler::load_arg(std::int32_t disp) {
+    emit_({0x48, 0x8B, 0x87});
+    emit_imm32_(disp);
+}
+void Assembler::load_stack(std::int32_t disp) {
+    emit_({0x48, 0x8B, 0x84, 0x24});
+    emit_imm32_(disp);
+}
+void Assembler::store_stack(std::int32_t disp) {
+    emit_({0x48, 0x89, 0x84, 0x24});
+    emit_imm32_(disp);
+}
+void Assembler::store_rcx_relative(std::int32_t disp) {
+    emit_({0x48, 0x89, 0x81});
+    emit_imm32_(disp);
+}
+
+void Assembler::add() { emit_({0x48, 0x01, 0xC8}); }
+void Assembler::sub() { emit_({0x48, 0x29, 0xC8}); }
+void Assembler::imul() { emit_({0x48, 0x0F, 0xAF, 0xC1}); }
+void Assembler::bit_and() { emit_({0x48, 0x21, 0xC8}); }
+void Assembler::bit_or() { emit_({0x48, 0x09, 0xC8}); }
+void Assembler::bit_xor() { emit_({0x48, 0x31, 0xC8}); }
+// cqo; idiv rcx; mov rax, rdx
+void Assembler::signed_remainder() { emit_({0x48, 0x99, 0x48, 0xF7, 0xF9, 0x48, 0x89, 0xD0}); }
+// xor edx, edx; div rcx; mov rax, rdx
+void Assembler::unsigned_remainder() { emit_({0x31, 0xD2, 0x48, 0xF7, 0xF1, 0x48, 0x89, 0xD0}); }
+void Assembler::shl() { emit_({0x48, 0xD3, 0xE0}); }
+void Assembler::sar() { emit_({0x48, 0xD3, 0xF8}); }
+void Assembler::shr() { emit_({0x48, 0xD3, 0xE8}); }
+void Assembler::shl32() { emit_({0xD3, 0xE0}); }
+void Assembler::sar32() { emit_({0xD3, 0xF8}); }
+void Assembler::shr32() { emit_({0xD3, 0xE8}); }
+void Assembler::neg() { emit_({0x48, 0xF7, 0xD8}); }
+void Assembler::bit_not() { emit_({0x48, 0xF7, 0xD0}); }
+void Assembler::xor_eax_1() { emit_({0x83, 0xF0, 0x01}); }
+// btc rax, 63
+void Assembler::flip_sign64() { emit_({0x48, 0x0F, 0xBA, 0xF8, 0x3F}); }
+// xor eax, 0x80000000
+void Assembler::flip_sign32() { emit_({0x35, 0x00, 0x00, 0x00, 0x80}); }
+
+void Assembler::sign_extend8() { emit_({0x48, 0x0F, 0xBE, 0xC0}); }
+void Assembler::sign_extend16() { emit_({0x48, 0x0F, 0xBF, 0xC0}); }
+void Assembler::sign_extend32() { emit_({0x48, 0x63, 0xC0}); }
+void Assembler::zero_extend8() { emit_({0x0F, 0xB6, 0xC0}); }
+void Assembler::zero_extend16() { emit_({0x0F, 0xB7, 0xC0}); }
+void Assembler::zero_extend32() { emit_({0x89, 0xC0}); }
+
+void Assembler::cmp() { emit_({0x48, 0x39, 0xC8}); }
+void Assembler::test_rax() { emit_({0x48, 0x85, 0xC0}); }
+void Assembler::test_rdx() { emit_({0x48, 0x85, 0xD2}); }
+void Assembler::set(Condition cond) {
+    emit_({0x0F, static_cast<std::uint8_t>(0x90 | static_cast<std::uint8_t>(cond)), 0xC0});
+    zero_extend8();
+}
+void Assembler::set_and(Condition cond, Condition cond2) {
+    emit_({0x0F, static_cast<std::uint8_t>(0x90 | static_cast<std::uint8_t>(cond)), 0xC0});
+    emit_({0x0F, static_cast<std::uint8_t>(0x90 | static_cast<std::uint8_t>(cond2)), 0xC1});
+    emit_({0x20, 0xC8});
+    zero_extend8();
+}
+void Assembler::set_or(Condition cond, Condition cond2) {
+    emit_({0x0F, static_cast<std::uint8_t>(0x90 | static_cast<std::uint8_t>(cond)), 0xC0});
+    emit_({0x0F, static_cast<std::uint8_t>(0x90 | static_cast<std::uint8_t>(cond2)), 0xC1});
+    emit_({0x08, 0xC8});
+    zero_extend8();
+}
+
+// movq xmm0, rax; movq xmm1, rcx; (op)sd xmm0, xmm1; movq rax, xmm0
+void Assembler::float64(FloatOp op) {
+    emit_({0x66, 0x48, 0x0F, 0x6E, 0xC0, 0x66, 0x48, 0x0F, 0x6E, 0xC9});
+    emit_({0xF2, 0x0F, static_cast<std::uint8_t>(op), 0xC1});
+    emit_({0x66, 0x48, 0x0F, 0x7E, 0xC0});
+}
+// movd xmm0, eax; movd xmm1, ecx; (op)ss xmm0, xmm1; movd eax, xmm0
+void Assembler::float32(FloatOp op) {
+    emit_({0x66, 0x0F, 0x6E, 0xC0, 0x66, 0x0F, 0x6E, 0xC9});
+    emit_({0xF3, 0x0F, static_cast<std::uint8_t>(op), 0xC1});
+    emit_({0x66, 0x0F, 0x7E, 0xC0});
+}
+void Assembler::compare_float64(bool swapped) {
+    emit_({0x66, 0x48, 0x0F, 0x6E, 0xC0, 0x66, 0x48, 0x0F, 0x6E, 0xC9});
+    emit_({0x66, 0x0F, 0x2E, static_cast<std::uint8_t>(swapped ? 0xC8 : 0xC1)});
+}
+
+// cvtsi2sd xmm0, rax; movq rax, xmm0
+void Assembler::int_to_float64() { emit_({0xF2, 0x48, 0x0F, 0x2A, 0xC0, 0x66, 0x48, 0x0F, 0x7E, 0xC0}); }
+// cvtsi2ss xmm0, rax; movd eax, xmm0
+void Assembler::int_to_float32() { emit_({0xF3, 0x48, 0x0F, 0x2A, 0xC0, 0x66, 0x0F, 0x7E, 0xC0}); }
+// movq xmm0, rax; cvttsd2si rax, xmm0
+void Assembler::float64_to_int() { emit_({0x66, 0x48, 0x0F, 0x6E, 0xC0, 0xF2, 0x48, 0x0F, 0x2C, 0xC0}); }
+// movd xmm0, eax; cvttss2si rax, xmm0
+void Assembler::float32_to_int() { emit_({0x66, 0x0F, 0x6E, 0xC0, 0xF3, 0x48, 0x0F, 0x2C, 0xC0}); }
+// movq xmm0, rax; cvttsd2si eax, xmm0
+void Assembler::float64_to_int32() { emit_({0x66, 0x48, 0x0F, 0x6E, 0xC0, 0xF2, 0x0F, 0x2C, 0xC0}); }
+// movd xmm0, eax; cvttss2si eax, xmm0
+void Assembler::float32_to_int32() { emit_({0x66, 0x0F, 0x6E, 0xC0, 0xF3, 0x0F, 0x2C, 0xC0}); }
+// movd xmm0, eax; cvtss2sd xmm0, xmm0; movq rax, xmm0
+void Assembler::float32_to_float64() {
+    emit_({0x66, 0x0F, 0x6E, 0xC0, 0xF3, 0x0F, 0x5A, 0xC0, 0x66, 0x48, 0x0F, 0x7E, 0xC0});
+}
+// movq xmm0, rax; cvtsd2ss xmm0, xmm0; movd eax, xmm0
+void Assembler::float64_to_float32() {
+    emit_({0x66, 0x48, 0x0F, 0x6E, 0xC0, 0xF2, 0x0F, 0x5A, 0xC0, 0x66, 0x0F, 0x7E, 0xC0});
+}
+
+void Assembler::call_rax() { emit_({0xFF, 0xD0}); }
+void Assembler::call_rdx() { emit_({0xFF, 0xD2}); }
+Assembler::Patch Assembler::jump() {
+    emit_({0xE9});
+    auto patch = here();
+    emit_imm32_(0);
+    return patch;
+}
+Assembler::Patch Assembler::jump_if(Condition cond) {
+    emit_({0x0F, static_cast<std::uint8_t>(0x80 | static_cast<std::uint8_t>(cond))});
+    auto patch = here();
+    emit_imm32_(0);
+    return patch;
+}
+void Assembler::patch_jump(Patch patch, std::size_t target) {
+    // 相対位置は分岐命令の直後から数える
+    auto offset = static_cast<std::int32_t>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(patch + 4));
+    patch_imm32_(patch, offset);
+}
+void Assembler::jump_to(std::size_t target) { patch_jump(jump(), target); }
+void Assembler::jump_if_to(Condition cond, std::size_t target) { patch_jump(jump_if(cond), target); }
+}  // namespace Garnet::interpreter::jit
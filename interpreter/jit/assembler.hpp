@@ -0,0 +1,151 @@
+#ifndef GARNET_INTERPRETER_JIT_ASSEMBLER
+#define GARNET_INTERPRETER_JIT_ASSEMBLER
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+namespace Garnet::interpreter::jit {
+// x86-64の命令の雛形(テンプレート)を並べて機械語を作る
+// 値は全てraxに置き、二項演算の右辺だけrcxに置く。浮動小数点数もビット列のままraxに置き、
+// 演算する間だけxmm0, xmm1に移す。局所変数はrbpからの位置で指す
+class Assembler {
+    std::vector<std::uint8_t> code_;
+
+    void emit_(std::initializer_list<std::uint8_t> bytes);
+    void emit_imm32_(std::int32_t value);
+    void emit_imm64_(std::uint64_t value);
+    void patch_imm32_(std::size_t patch, std::int32_t value);
+
+   public:
+    // 分岐の条件。値はjcc/setccの下位4ビット
+    enum class Condition : std::uint8_t {
+        BELOW = 0x2,
+        ABOVE_EQUAL = 0x3,
+        EQUAL = 0x4,
+        NOT_EQUAL = 0x5,
+        BELOW_EQUAL = 0x6,
+        ABOVE = 0x7,
+        PARITY = 0xA,
+        NOT_PARITY = 0xB,
+        LESS = 0xC,
+        GREATER_EQUAL = 0xD,
+        LESS_EQUAL = 0xE,
+        GREATER = 0xF,
+    };
+    // 後から書き換える即値や分岐先の位置
+    using Patch = std::size_t;
+
+    const std::vector<std::uint8_t>& code() const { return code_; }
+    std::size_t here() const { return code_.size(); }
+
+    // push rbp; mov rbp, rsp; sub rsp, imm32。確保量は後からpatch_frame_sizeで決める
+    Patch prologue();
+    void patch_frame_size(Patch patch, std::int32_t size);
+    // xor edx, edx; leave; ret
+    void epilogue();
+    // leave; ret (rdxは呼び出し側が設定する)
+    void leave_ret();
+
+    void push_rax();
+    void pop_rax();
+    void push_rcx();
+    void pop_rcx();
+    // sub rsp, imm32 / add rsp, imm32
+    void reserve(std::int32_t size);
+    void release(std::int32_t size);
+
+    void mov_rcx_rax();
+    void mov_rdi_rax();
+    void mov_rsi_rcx();
+    void mov_rdi_rsp();
+    void xor_eax_eax();
+    // mov r64, imm64。書き換える場合に備えて即値の位置を返す
+    Patch mov_rax_imm(std::uint64_t value);
+    Patch mov_rcx_imm(std::uint64_t value);
+    Patch mov_rdx_imm(std::uint64_t value);
+    Patch mov_rdi_imm(std::uint64_t value);
+    void patch_imm64(Patch patch, std::uint64_t value);
+
+    // mov rax, [rbp + disp] / mov [rbp + disp], rax / mov qword [rbp + disp], 0
+    void load_local(std::int32_t disp);
+    void store_local(std::int32_t disp);
+    void clear_local(std::int32_t disp);
+    // mov rax, [rdi + disp]
+    void load_arg(std::int32_t disp);
+    // mov rax, [rsp + disp] / mov [rsp + disp], rax
+    void load_stack(std::int32_t disp);
+    void store_stack(std::int32_t disp);
+    // mov [rcx + disp], rax
+    void store_rcx_relative(std::int32_t disp);
+
+    // 整数演算。結果はrax
+    void add();
+    void sub();
+    void imul();
+    void bit_and();
+    void bit_or();
+    void bit_xor();
+    // raxをrcxで割った余り
+    void signed_remainder();
+    void unsigned_remainder();
+    // rax をclだけシフトする。32ビット版はeaxをシフトし、シフト量はclの下位5ビットだけを使う
+    void shl();
+    void sar();
+    void shr();
+    void shl32();
+    void sar32();
+    void shr32();
+    void neg();
+    void bit_not();
+    void xor_eax_1();
+    // 浮動小数点数の符号ビットを反転する
+    void flip_sign64();
+    void flip_sign32();
+
+    // 64ビットから幅を詰めて、符号拡張/ゼロ拡張し直す
+    void sign_extend8();
+    void sign_extend16();
+    void sign_extend32();
+    void zero_extend8();
+    void zero_extend16();
+    void zero_extend32();
+
+    void cmp();
+    void test_rax();
+    void test_rdx();
+    // setcc al; movzx eax, al
+    void set(Condition cond);
+    // setcc al; setcc2 cl; and/or al, cl; movzx eax, al
+    void set_and(Condition cond, Condition cond2);
+    void set_or(Condition cond, Condition cond2);
+
+    // 浮動小数点演算。raxとrcxのビット列をxmm0, xmm1に移して演算し、結果をraxに戻す
+    enum class FloatOp : std::uint8_t { ADD = 0x58, MUL = 0x59, SUB = 0x5C, DIV = 0x5E };
+    void float64(FloatOp op);
+    void float32(FloatOp op);
+    // raxとrcxをxmm0, xmm1に移してucomisd xmm0, xmm1(swappedならucomisd xmm1, xmm0)
+    void compare_float64(bool swapped);
+
+    // 変換。整数は64ビットの符号付き整数として扱う
+    void int_to_float64();
+    void int_to_float32();
+    void float64_to_int();
+    void float32_to_int();
+    // 32ビットの整数に変換する。範囲外やNaNはINT32_MIN
+    void float64_to_int32();
+    void float32_to_int32();
+    void float32_to_float64();
+    void float64_to_float32();
+
+    void call_rax();
+    void call_rdx();
+    // 分岐先は後からpatch_jumpで決める
+    Patch jump();
+    Patch jump_if(Condition cond);
+    void patch_jump(Patch patch, std::size_t target);
+    // 既に出力した位置への分岐
+    void jump_to(std::size_t target);
+    void jump_if_to(Condition cond, std::size_t target);
+};
+}  // namespace Garnet::interpreter::jit
+#endif
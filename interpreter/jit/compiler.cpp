@@ -0,0 +1,866 @@
+#include "compiler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#include "compilation_unit.hpp"
+#include "concrete_decls.hpp"
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_statements.hpp"
+#include "error_nodes.hpp"
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+namespace Garnet::interpreter::jit {
+namespace {
+using Condition = Assembler::Condition;
+using FloatOp = Assembler::FloatOp;
+using Kind = NumericType::Kind;
+
+// 機械語から呼び出す変換と演算。インタプリタと同じくstatic_castとstd::fmodで計算する
+std::uint64_t u64_to_f64(std::uint64_t value, std::uint64_t) {
+    return std::bit_cast<std::uint64_t>(static_cast<double>(value));
+}
+std::uint64_t u64_to_f32(std::uint64_t value, std::uint64_t) {
+    return std::bit_cast<std::uint32_t>(static_cast<float>(value));
+}
+std::uint64_t f64_to_u64(std::uint64_t value, std::uint64_t) {
+    return static_cast<std::uint64_t>(std::bit_cast<double>(value));
+}
+std::uint64_t f32_to_u64(std::uint64_t value, std::uint64_t) {
+    return static_cast<std::uint64_t>(std::bit_cast<float>(static_cast<std::uint32_t>(value)));
+}
+std::uint64_t f64_to_bool(std::uint64_t value, std::uint64_t) {
+    return static_cast<bool>(std::bit_cast<double>(value));
+}
+std::uint64_t f32_to_bool(std::uint64_t value, std::uint64_t) {
+    return static_cast<bool>(std::bit_cast<float>(static_cast<std::uint32_t>(value)));
+}
+std::uint64_t fmod_f64(std::uint64_t left, std::uint64_t right) {
+    return std::bit_cast<std::uint64_t>(std::fmod(std::bit_cast<double>(left), std::bit_cast<double>(right)));
+}
+std::uint64_t fmod_f32(std::uint64_t left, std::uint64_t right) {
+    return std::bit_cast<std::uint32_t>(std::fmod(std::bit_cast<float>(static_cast<std::uint32_t>(left)),
+                                                  std::bit_cast<float>(static_cast<std::uint32_t>(right))));
+}
+}  // namespace
+
+Compiler::Compiler(const semantics::TypeRules& rules, std::unordered_map<TypeKey, std::size_t> type_indices,
+                   std::vector<NumericType> numeric_types,
+                   std::unordered_map<Slot, const ast::FunctionDef*> functions)
+    : rules_(rules),
+      type_indices_(std::move(type_indices)),
+      numeric_types_(std::move(numeric_types)),
+      functions_(std::move(functions)) {}
+Compiler::~Compiler() {
+#if defined(__x86_64__) && defined(__linux__)
+    for (auto [region, size] : regions_) {
+        munmap(region, size);
+    }
+#endif
+}
+bool Compiler::is_supported() {
+#if defined(__x86_64__) && defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+NativeFunction Compiler::compile(const ast::FunctionDef* node) {
+    if (auto iter = compiled_.find(node); iter != compiled_.end()) {
+        return iter->second;
+    }
+    if (not is_supported() || rejected_.contains(node)) {
+        return nullptr;
+    }
+    std::unordered_map<const ast::FunctionDef*, Function> functions;
+    std::vector<const ast::FunctionDef*> worklist{node};
+    while (not worklist.empty()) {
+        const auto* function = worklist.back();
+        worklist.pop_back();
+        if (functions.contains(function) || compiled_.contains(function) || rejected_.contains(function)) {
+            continue;
+        }
+        try {
+            auto compiled = compile_function_(function);
+            for (const auto& call : compiled.calls) {
+                worklist.push_back(call.callee);
+            }
+            functions.emplace(function, std::move(compiled));
+        } catch (const Unsupported&) {
+            rejected_.insert(function);
+        }
+    }
+    // 変換できない関数を呼ぶ関数も変換できない。再帰呼び出しは妨げない
+    auto calls_rejected = [this](const CallPatch& call) { return rejected_.contains(call.callee); };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto iter = functions.begin(); iter != functions.end();) {
+            if (std::ranges::any_of(iter->second.calls, calls_rejected)) {
+                rejected_.insert(iter->first);
+                iter = functions.erase(iter);
+                changed = true;
+            } else {
+                ++iter;
+            }
+        }
+    }
+    if (not place_(functions)) {
+        for (const auto& [function, compiled] : functions) {
+            rejected_.insert(function);
+        }
+        return nullptr;
+    }
+    auto iter = compiled_.find(node);
+    return iter == compiled_.end() ? nullptr : iter->second;
+}
+bool Compiler::place_(std::unordered_map<const ast::FunctionDef*, Function>& functions) {
+    if (functions.empty()) {
+        return true;
+    }
+#if defined(__x86_64__) && defined(__linux__)
+    std::unordered_map<const ast::FunctionDef*, std::size_t> offsets;
+    std::size_t size = 0;
+    for (const auto& [node, function] : functions) {
+        offsets[node] = size;
+        size += (function.code.size() + 15) / 16 * 16;
+    }
+    void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return false;
+    }
+    auto* base = static_cast<std::uint8_t*>(region);
+    auto address = [this, base, &offsets](const ast::FunctionDef* callee) {
+        if (auto iter = offsets.find(callee); iter != offsets.end()) {
+            return reinterpret_cast<std::uint64_t>(base + iter->second);
+        }
+        return reinterpret_cast<std::uint64_t>(compiled_.at(callee));
+    };
+    for (const auto& [node, function] : functions) {
+        auto* code = base + offsets.at(node);
+        std::memcpy(code, function.code.data(), function.code.size());
+        for (const auto& call : function.calls) {
+            auto target = address(call.callee);
+            std::memcpy(code + call.patch, &target, sizeof(target));
+        }
+    }
+    // 書き終えたら、書き込めない実行可能な領域にする
+    if (mprotect(region, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(region, size);
+        return false;
+    }
+    regions_.emplace_back(region, size);
+    for (const auto& [node, offset] : offsets) {
+        compiled_[node] = reinterpret_cast<NativeFunction>(base + offset);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+std::uint64_t Compiler::run(NativeFunction function, const std::uint64_t* args) {
+    auto result = function(args);
+    while (result.next != nullptr) {
+        result = result.next(tail_args_.data());
+    }
+    return result.value;
+}
+
+std::optional<Compiler::Signature> Compiler::signature_(const ast::FunctionDef* node) const {
+    auto numeric = [this](ast::SourceTypeIdentifier name) -> std::optional<std::size_t> {
+        auto iter = type_indices_.find(name.source_id());
+        if (iter == type_indices_.end() || not numeric_(iter->second).is_numeric()) {
+            return std::nullopt;
+        }
+        return iter->second;
+    };
+    const auto& info = node->info();
+    Signature signature;
+    for (const auto& arg : info.args()) {
+        auto type = numeric(arg.type().name());
+        if (not type.has_value()) {
+            return std::nullopt;
+        }
+        signature.args.push_back(*type);
+    }
+    // 戻り値のない関数(void)の戻り値はnilなので、ここで除かれる
+    if (not info.result().has_value()) {
+        return std::nullopt;
+    }
+    auto result = numeric(info.result()->type().name());
+    if (not result.has_value()) {
+        return std::nullopt;
+    }
+    signature.result = *result;
+    return signature;
+}
+Compiler::Function Compiler::compile_function_(const ast::FunctionDef* node) {
+    auto signature = signature_(node);
+    if (not signature.has_value() || signature->args.size() > MAX_ARGS) {
+        throw Unsupported{};
+    }
+    assembler_ = Assembler();
+    scopes_.clear();
+    next_slot_ = 0;
+    max_slots_ = 0;
+    depth_ = 0;
+    break_patches_.clear();
+    calls_.clear();
+    result_type_ = signature->result;
+
+    auto frame = assembler_.prologue();
+    push_scope_(node->arg_frame_size());
+    const auto& arg_slots = node->arg_slots();
+    for (std::size_t i = 0; i < signature->args.size(); i++) {
+        // 引数の名前が重複していると、インタプリタは呼び出し時にエラーにする
+        if (arg_slots[i] != i) {
+            throw Unsupported{};
+        }
+        scopes_.back().types[i] = signature->args[i];
+        assembler_.load_arg(static_cast<std::int32_t>(8 * i));
+        assembler_.store_local(disp_(static_cast<std::int32_t>(i)));
+    }
+    node->block()->accept(*this);
+    // 最後まで実行したら、戻り値の型のゼロ値を返す
+    assembler_.xor_eax_eax();
+    assembler_.epilogue();
+    pop_scope_();
+    assembler_.patch_frame_size(frame, (max_slots_ * 8 + 15) / 16 * 16);
+    return {.code = assembler_.code(), .calls = std::move(calls_)};
+}
+
+void Compiler::push_scope_(std::size_t size) {
+    scopes_.push_back({.base = next_slot_, .types = std::vector<std::size_t>(size, UNKNOWN)});
+    next_slot_ += static_cast<std::int32_t>(size);
+    max_slots_ = std::max(max_slots_, next_slot_);
+}
+void Compiler::pop_scope_() {
+    next_slot_ = scopes_.back().base;
+    scopes_.pop_back();
+}
+Compiler::Operand Compiler::local_(const ast::Expression* expr) const {
+    const auto* reference = dynamic_cast<const ast::VariableReference*>(expr);
+    if (reference == nullptr) {
+        throw Unsupported{};
+    }
+    auto binding = reference->binding();
+    // グローバル変数は機械語から読み書きしない
+    if (not binding.has_value() || binding->depth >= scopes_.size()) {
+        throw Unsupported{};
+    }
+    const auto& scope = scopes_[scopes_.size() - 1 - binding->depth];
+    // 宣言より前の参照は、インタプリタでは実行時のエラーになる
+    if (binding->slot >= scope.types.size() || scope.types[binding->slot] == UNKNOWN) {
+        throw Unsupported{};
+    }
+    return {.type = scope.types[binding->slot],
+            .local = disp_(scope.base + static_cast<std::int32_t>(binding->slot))};
+}
+const ast::FunctionDef* Compiler::callee_(const ast::FunctionCall* node) const {
+    const auto* reference = dynamic_cast<const ast::VariableReference*>(node->callee().get());
+    if (reference == nullptr || not reference->binding().has_value() ||
+        reference->binding()->depth != scopes_.size()) {
+        return nullptr;
+    }
+    auto iter = functions_.find(reference->binding()->slot);
+    if (iter == functions_.end() || rejected_.contains(iter->second)) {
+        return nullptr;
+    }
+    return iter->second;
+}
+
+Compiler::Operand Compiler::evaluate_(const ast::Expression* expr) {
+    expr->accept(*this);
+    return result_;
+}
+void Compiler::load_(const Operand& operand) {
+    if (operand.local.has_value()) {
+        assembler_.load_local(*operand.local);
+    }
+}
+void Compiler::push_(bool is_rcx) {
+    is_rcx ? assembler_.push_rcx() : assembler_.push_rax();
+    depth_++;
+}
+void Compiler::pop_(bool is_rcx) {
+    is_rcx ? assembler_.pop_rcx() : assembler_.pop_rax();
+    depth_--;
+}
+void Compiler::call_helper_(Helper helper) {
+    // 呼び出し規約に従い、rspを16バイト境界に揃えてから呼ぶ
+    bool is_padded = depth_ % 2 != 0;
+    if (is_padded) {
+        assembler_.reserve(8);
+    }
+    assembler_.mov_rdi_rax();
+    assembler_.mov_rsi_rcx();
+    assembler_.mov_rax_imm(reinterpret_cast<std::uint64_t>(helper));
+    assembler_.call_rax();
+    if (is_padded) {
+        assembler_.release(8);
+    }
+}
+void Compiler::normalize_(std::size_t type) {
+    const auto& numeric = numeric_(type);
+    if (numeric.kind == Kind::BOOLEAN) {
+        assembler_.test_rax();
+        assembler_.set(Condition::NOT_EQUAL);
+    } else if (numeric.kind == Kind::SIGNED) {
+        if (numeric.bits == 8) {
+            assembler_.sign_extend8();
+        } else if (numeric.bits == 16) {
+            assembler_.sign_extend16();
+        } else if (numeric.bits == 32) {
+            assembler_.sign_extend32();
+        }
+    } else if (numeric.kind == Kind::UNSIGNED) {
+        if (numeric.bits == 8) {
+            assembler_.zero_extend8();
+        } else if (numeric.bits == 16) {
+            assembler_.zero_extend16();
+        } else if (numeric.bits == 32) {
+            assembler_.zero_extend32();
+        }
+    }
+}
+void Compiler::convert_(std::size_t from, std::size_t to) {
+    const auto& source = numeric_(from);
+    const auto& target = numeric_(to);
+    if (not source.is_numeric() || not target.is_numeric()) {
+        throw Unsupported{};
+    }
+    if (from == to) {
+        return;
+    }
+    bool is_u64 = source.kind == Kind::UNSIGNED && source.bits == 64;
+    if (source.is_integral() && target.is_integral()) {
+        normalize_(to);
+    } else if (source.is_integral()) {
+        // cvtsi2sdは符号付きとして変換するので、最上位ビットの立ったu64は別に扱う
+        if (is_u64) {
+            call_helper_(target.bits == 64 ? u64_to_f64 : u64_to_f32);
+        } else {
+            target.bits == 64 ? assembler_.int_to_float64() : assembler_.int_to_float32();
+        }
+    } else if (target.is_float()) {
+        target.bits == 64 ? assembler_.float32_to_float64() : assembler_.float64_to_float32();
+    } else if (target.kind == Kind::BOOLEAN) {
+        call_helper_(source.bits == 64 ? f64_to_bool : f32_to_bool);
+    } else if (target.kind == Kind::UNSIGNED && target.bits == 64) {
+        call_helper_(source.bits == 64 ? f64_to_u64 : f32_to_u64);
+    } else if (target.bits == 64 || (target.kind == Kind::UNSIGNED && target.bits == 32)) {
+        source.bits == 64 ? assembler_.float64_to_int() : assembler_.float32_to_int();
+        normalize_(to);
+    } else {
+        // static_castと同じく、32ビット以下の型(u32を除く)へは32ビットで変換してから詰める
+        source.bits == 64 ? assembler_.float64_to_int32() : assembler_.float32_to_int32();
+        normalize_(to);
+    }
+}
+void Compiler::condition_(const ast::Expression* cond, bool is_loop) {
+    auto value = evaluate_(cond);
+    if (is_loop) {
+        // ループの条件はboolでなければならない
+        if (value.type != rules_.boolean) {
+            throw Unsupported{};
+        }
+        load_(value);
+    } else {
+        // IfStatementは条件式の変数を値に変換しないので、インタプリタでは型のエラーになる
+        if (value.local.has_value()) {
+            throw Unsupported{};
+        }
+        convert_(value.type, rules_.boolean);
+    }
+    assembler_.test_rax();
+}
+std::pair<std::size_t, std::size_t> Compiler::operand_types_(ast::BinaryOperator::OperatorType op, std::size_t left,
+                                                             std::size_t right, std::size_t result) const {
+    using enum ast::BinaryOperator::OperatorType;
+    switch (op) {
+        case ADD:
+        case SUB:
+        case MUL:
+        case DIV:
+        case MOD:
+        case BIT_AND:
+        case BIT_OR:
+        case BIT_XOR:
+            // 両辺を結果の型に揃えてから計算する
+            return {result, result};
+        case LESS:
+        case LESS_EQUAL:
+        case GREATER:
+        case GREATER_EQUAL:
+        case EQUAL:
+        case NOT_EQUAL:
+            // 整数同士は符号の有無が揃っているので、64ビットに広げたまま比べられる
+            if (numeric_(left).is_float()) {
+                return {rules_.f64, rules_.f64};
+            }
+            return {left, right};
+        default:
+            return {left, right};
+    }
+}
+void Compiler::binary_(ast::BinaryOperator::OperatorType op, std::size_t type, std::size_t result) {
+    using enum ast::BinaryOperator::OperatorType;
+    const auto& numeric = numeric_(type);
+    bool is_signed = numeric.kind == Kind::SIGNED;
+    auto arithmetic = [this, &numeric, result](FloatOp float_op, void (Assembler::*integer_op)()) {
+        if (numeric.is_float()) {
+            numeric.bits == 64 ? assembler_.float64(float_op) : assembler_.float32(float_op);
+        } else {
+            (assembler_.*integer_op)();
+            normalize_(result);
+        }
+    };
+    auto compare = [this, &numeric, is_signed](Condition if_signed, Condition if_unsigned, Condition if_float,
+                                                bool swapped) {
+        if (numeric.is_float()) {
+            // 比較できない(NaNを含む)ときはCFが立つので、a, aeだけで偽になる
+            assembler_.compare_float64(swapped);
+            assembler_.set(if_float);
+        } else {
+            assembler_.cmp();
+            assembler_.set(is_signed ? if_signed : if_unsigned);
+        }
+    };
+    switch (op) {
+        case ADD:
+            arithmetic(FloatOp::ADD, &Assembler::add);
+            return;
+        case SUB:
+            arithmetic(FloatOp::SUB, &Assembler::sub);
+            return;
+        case MUL:
+            arithmetic(FloatOp::MUL, &Assembler::imul);
+            return;
+        case DIV:
+            // 整数同士の除算は、doubleに変換してから行う
+            if (not numeric.is_float()) {
+                throw Unsupported{};
+            }
+            numeric.bits == 64 ? assembler_.float64(FloatOp::DIV) : assembler_.float32(FloatOp::DIV);
+            return;
+        case MOD:
+            if (numeric.is_float()) {
+                call_helper_(numeric.bits == 64 ? fmod_f64 : fmod_f32);
+                return;
+            }
+            is_signed ? assembler_.signed_remainder() : assembler_.unsigned_remainder();
+            normalize_(result);
+            return;
+        case BIT_AND:
+            assembler_.bit_and();
+            normalize_(result);
+            return;
+        case BIT_OR:
+            assembler_.bit_or();
+            normalize_(result);
+            return;
+        case BIT_XOR:
+            assembler_.bit_xor();
+            normalize_(result);
+            return;
+        // semantics::shift_countと同じく、シフト量は汎整数拡張した左辺の幅で剰余を取る
+        // 32ビット以下の型はint(unsigned int)に拡張されるので、32ビット幅の命令がそのまま使える
+        case LEFT_SHIFT:
+            numeric.bits == 64 ? assembler_.shl() : assembler_.shl32();
+            normalize_(result);
+            return;
+        case RIGHT_SHIFT:
+            if (numeric.bits == 64) {
+                is_signed ? assembler_.sar() : assembler_.shr();
+            } else {
+                is_signed ? assembler_.sar32() : assembler_.shr32();
+            }
+            normalize_(result);
+            return;
+        case LESS:
+            compare(Condition::LESS, Condition::BELOW, Condition::ABOVE, true);
+            return;
+        case LESS_EQUAL:
+            compare(Condition::LESS_EQUAL, Condition::BELOW_EQUAL, Condition::ABOVE_EQUAL, true);
+            return;
+        case GREATER:
+            compare(Condition::GREATER, Condition::ABOVE, Condition::ABOVE, false);
+            return;
+        case GREATER_EQUAL:
+            compare(Condition::GREATER_EQUAL, Condition::ABOVE_EQUAL, Condition::ABOVE_EQUAL, false);
+            return;
+        case EQUAL:
+            if (numeric.is_float()) {
+                assembler_.compare_float64(false);
+                assembler_.set_and(Condition::EQUAL, Condition::NOT_PARITY);
+            } else {
+                assembler_.cmp();
+                assembler_.set(Condition::EQUAL);
+            }
+            return;
+        case NOT_EQUAL:
+            if (numeric.is_float()) {
+                assembler_.compare_float64(false);
+                assembler_.set_or(Condition::NOT_EQUAL, Condition::PARITY);
+            } else {
+                assembler_.cmp();
+                assembler_.set(Condition::NOT_EQUAL);
+            }
+            return;
+        default:
+            throw Unsupported{};
+    }
+}
+std::int32_t Compiler::arguments_(const ast::FunctionCall* node, const Signature& signature) {
+    const auto& args = node->args();
+    if (args.size() < signature.args.size()) {
+        throw Unsupported{};
+    }
+    auto count = static_cast<std::int32_t>(signature.args.size());
+    // 呼び出す時点でrspが16バイト境界に揃うよう、必要なら一つ余分に確保する
+    auto slots = count + (depth_ + count) % 2;
+    assembler_.reserve(slots * 8);
+    depth_ += slots;
+    std::vector<std::pair<std::int32_t, Operand>> deferred;
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(args.size()); i++) {
+        auto arg = evaluate_(args[i].get());
+        // 余分な実引数は評価するだけで捨てる
+        if (i >= count) {
+            continue;
+        }
+        // インタプリタと同じく、全ての実引数を評価してから変数の値を読む
+        if (arg.local.has_value()) {
+            deferred.emplace_back(i, arg);
+            continue;
+        }
+        convert_(arg.type, signature.args[i]);
+        assembler_.store_stack(8 * i);
+    }
+    for (const auto& [i, arg] : deferred) {
+        load_(arg);
+        convert_(arg.type, signature.args[i]);
+        assembler_.store_stack(8 * i);
+    }
+    return slots * 8;
+}
+void Compiler::loop_body_(const ast::Block* block) {
+    break_patches_.emplace_back();
+    block->accept(*this);
+}
+void Compiler::end_loop_() {
+    for (auto patch : break_patches_.back()) {
+        assembler_.patch_jump(patch, assembler_.here());
+    }
+    break_patches_.pop_back();
+}
+
+void Compiler::visit(const ast::VariableDecl* node) {
+    auto type = type_indices_.find(node->type().source_id());
+    if (type == type_indices_.end() || not numeric_(type->second).is_numeric() || not node->slot().has_value() ||
+        node->userdata.has_value()) {
+        throw Unsupported{};
+    }
+    auto slot = node->slot().value();
+    auto disp = disp_(scopes_.back().base + static_cast<std::int32_t>(slot));
+    if (node->init().has_value()) {
+        auto value = evaluate_(node->init().value().get());
+        load_(value);
+        convert_(value.type, type->second);
+        assembler_.store_local(disp);
+    } else {
+        assembler_.clear_local(disp);
+    }
+    // 同じスコープでの再宣言は、インタプリタでは実行時のエラーになる
+    auto& scope = scopes_.back();
+    if (slot >= scope.types.size() || scope.types[slot] != UNKNOWN) {
+        throw Unsupported{};
+    }
+    scope.types[slot] = type->second;
+}
+void Compiler::visit(const ast::TypeDecl*) { throw Unsupported{}; }
+void Compiler::visit(const ast::ErrorNode*) { throw Unsupported{}; }
+void Compiler::visit(const ast::ErrorSentence*) { throw Unsupported{}; }
+void Compiler::visit(const ast::ErrorExpression*) { throw Unsupported{}; }
+void Compiler::visit(const ast::ErrorStatement*) { throw Unsupported{}; }
+void Compiler::visit(const ast::BinaryOperator* node) {
+    if (node->op() == ast::BinaryOperator::OperatorType::ASSIGN) {
+        auto target = local_(node->left().get());
+        auto value = evaluate_(node->right().get());
+        // 代入式の値は右辺そのもの(右辺が変数ならその変数)なので、raxを壊さないようにする
+        if (value.local.has_value() || value.type == target.type) {
+            load_(value);
+            convert_(value.type, target.type);
+            assembler_.store_local(*target.local);
+        } else {
+            push_(false);
+            convert_(value.type, target.type);
+            assembler_.store_local(*target.local);
+            pop_(false);
+        }
+        result_ = value;
+        return;
+    }
+    auto types = node->operand_types();
+    if (not types.has_value()) {
+        throw Unsupported{};
+    }
+    std::size_t left_type = (*types)[0], right_type = (*types)[1];
+    auto result = rules_.binary_result(node->op(), left_type, right_type);
+    if (result == UNKNOWN || not numeric_(result).is_numeric()) {
+        throw Unsupported{};
+    }
+    auto [left_operand, right_operand] = operand_types_(node->op(), left_type, right_type, result);
+    auto left = evaluate_(node->left().get());
+    if (left.type != left_type) {
+        throw Unsupported{};
+    }
+    if (not left.local.has_value()) {
+        convert_(left_type, left_operand);
+        push_(false);
+    }
+    auto right = evaluate_(node->right().get());
+    if (right.type != right_type) {
+        throw Unsupported{};
+    }
+    load_(right);
+    convert_(right_type, right_operand);
+    assembler_.mov_rcx_rax();
+    if (left.local.has_value()) {
+        // 左辺の変数は、右辺を評価した後の値を使う
+        push_(true);
+        load_(left);
+        convert_(left_type, left_operand);
+        pop_(true);
+    } else {
+        pop_(false);
+    }
+    binary_(node->op(), left_operand, result);
+    result_ = {.type = result};
+}
+void Compiler::visit(const ast::CompoundAssign* node) {
+    auto target = local_(node->target().get());
+    auto types = node->operand_types();
+    if (not types.has_value() || (*types)[0] != target.type) {
+        throw Unsupported{};
+    }
+    std::size_t right_type = (*types)[1];
+    auto result = rules_.binary_result(node->op(), target.type, right_type);
+    if (result == UNKNOWN || not numeric_(result).is_numeric()) {
+        throw Unsupported{};
+    }
+    auto [left_operand, right_operand] = operand_types_(node->op(), target.type, right_type, result);
+    auto value = evaluate_(node->value().get());
+    if (value.type != right_type) {
+        throw Unsupported{};
+    }
+    load_(value);
+    convert_(right_type, right_operand);
+    push_(false);
+    load_(target);
+    convert_(target.type, left_operand);
+    pop_(true);
+    binary_(node->op(), left_operand, result);
+    if (result == target.type) {
+        assembler_.store_local(*target.local);
+    } else {
+        push_(false);
+        convert_(result, target.type);
+        assembler_.store_local(*target.local);
+        pop_(false);
+    }
+    result_ = {.type = result};
+}
+void Compiler::visit(const ast::LogicalOperator* node) {
+    // leftの0/1をraxに置いたまま、それで結果が決まればrightを飛ばす
+    condition_(node->left().get(), true);
+    auto end = assembler_.jump_if(node->op() == ast::LogicalOperator::OperatorType::AND ? Condition::EQUAL
+                                                                                        : Condition::NOT_EQUAL);
+    condition_(node->right().get(), true);
+    assembler_.patch_jump(end, assembler_.here());
+    result_ = {.type = rules_.boolean};
+}
+void Compiler::visit(const ast::UnaryOperator* node) {
+    using enum ast::UnaryOperator::OperatorType;
+    auto type = node->operand_type();
+    if (not type.has_value() || rules_.unary_result(node->op(), *type) != *type) {
+        throw Unsupported{};
+    }
+    const auto& numeric = numeric_(*type);
+    auto operand = evaluate_(node->operand().get());
+    if (operand.type != *type || not numeric.is_numeric()) {
+        throw Unsupported{};
+    }
+    load_(operand);
+    switch (node->op()) {
+        case PLUS:
+            break;
+        case MINUS:
+            if (numeric.is_float()) {
+                numeric.bits == 64 ? assembler_.flip_sign64() : assembler_.flip_sign32();
+            } else {
+                assembler_.neg();
+                normalize_(*type);
+            }
+            break;
+        case BOOL_NOT:
+            assembler_.xor_eax_1();
+            break;
+        default:
+            if (numeric.kind == Kind::BOOLEAN) {
+                assembler_.xor_eax_1();
+            } else {
+                assembler_.bit_not();
+                normalize_(*type);
+            }
+            break;
+    }
+    result_ = {.type = *type};
+}
+void Compiler::visit(const ast::VariableReference* node) { result_ = local_(node); }
+void Compiler::visit(const ast::SignedIntegerLiteral* node) {
+    assembler_.mov_rax_imm(static_cast<std::uint64_t>(node->value()));
+    result_ = {.type = rules_.i64};
+}
+void Compiler::visit(const ast::UnsignedIntegerLiteral* node) {
+    assembler_.mov_rax_imm(node->value());
+    result_ = {.type = rules_.u64};
+}
+void Compiler::visit(const ast::FloatingPointLiteral* node) {
+    assembler_.mov_rax_imm(std::bit_cast<std::uint64_t>(node->value()));
+    result_ = {.type = rules_.f64};
+}
+void Compiler::visit(const ast::StringLiteral*) { throw Unsupported{}; }
+void Compiler::visit(const ast::BooleanLiteral* node) {
+    assembler_.mov_rax_imm(node->value() ? 1 : 0);
+    result_ = {.type = rules_.boolean};
+}
+void Compiler::visit(const ast::NilLiteral*) { throw Unsupported{}; }
+void Compiler::visit(const ast::FunctionCall* node) {
+    const auto* callee = callee_(node);
+    auto signature = callee == nullptr ? std::nullopt : signature_(callee);
+    if (not signature.has_value()) {
+        throw Unsupported{};
+    }
+    auto size = arguments_(node, *signature);
+    assembler_.mov_rdi_rsp();
+    calls_.push_back({.patch = assembler_.mov_rax_imm(0), .callee = callee});
+    assembler_.call_rax();
+    // 呼び出し先が末尾呼び出しで戻ってきたら、その続きを呼ぶ
+    auto loop = assembler_.here();
+    assembler_.test_rdx();
+    auto done = assembler_.jump_if(Condition::EQUAL);
+    assembler_.mov_rdi_imm(reinterpret_cast<std::uint64_t>(tail_args_.data()));
+    assembler_.call_rdx();
+    assembler_.jump_to(loop);
+    assembler_.patch_jump(done, assembler_.here());
+    assembler_.release(size);
+    depth_ -= size / 8;
+    result_ = {.type = signature->result};
+}
+void Compiler::visit(const ast::CompilationUnit*) { throw Unsupported{}; }
+void Compiler::visit(const ast::FunctionDef*) { throw Unsupported{}; }
+void Compiler::visit(const ast::VariableDeclStatement* node) { node->decl()->accept(*this); }
+void Compiler::visit(const ast::ReturnStatement* node) {
+    if (const auto* call = node->tail_call(); call != nullptr) {
+        const auto* callee = callee_(call);
+        auto signature = callee == nullptr ? std::nullopt : signature_(callee);
+        // 戻り値の型が同じなら、このフレームを畳んでから呼び出し元に続きを呼ばせる
+        if (signature.has_value() && signature->result == result_type_) {
+            auto size = arguments_(call, *signature);
+            assembler_.mov_rcx_imm(reinterpret_cast<std::uint64_t>(tail_args_.data()));
+            for (std::int32_t i = 0; i < static_cast<std::int32_t>(signature->args.size()); i++) {
+                assembler_.load_stack(8 * i);
+                assembler_.store_rcx_relative(8 * i);
+            }
+            calls_.push_back({.patch = assembler_.mov_rdx_imm(0), .callee = callee});
+            assembler_.leave_ret();
+            depth_ -= size / 8;
+            return;
+        }
+    }
+    auto value = evaluate_(node->retval().get());
+    load_(value);
+    convert_(value.type, result_type_);
+    assembler_.epilogue();
+}
+void Compiler::visit(const ast::Block* node) {
+    push_scope_(node->frame_size());
+    for (const auto& sentence : node->sentences()) {
+        sentence->accept(*this);
+    }
+    pop_scope_();
+}
+void Compiler::visit(const ast::LoopStatement* node) {
+    auto top = assembler_.here();
+    loop_body_(node->block().get());
+    assembler_.jump_to(top);
+    end_loop_();
+}
+void Compiler::visit(const ast::WhileStatement* node) {
+    auto top = assembler_.here();
+    condition_(node->cond().get(), true);
+    auto exit = assembler_.jump_if(Condition::EQUAL);
+    loop_body_(node->block().get());
+    assembler_.jump_to(top);
+    assembler_.patch_jump(exit, assembler_.here());
+    end_loop_();
+}
+void Compiler::visit(const ast::DoWhileStatement* node) {
+    auto top = assembler_.here();
+    loop_body_(node->block().get());
+    condition_(node->cond().get(), true);
+    assembler_.jump_if_to(Condition::NOT_EQUAL, top);
+    end_loop_();
+}
+void Compiler::visit(const ast::ForStatement* node) {
+    // initの変数はループ全体で一つのスコープに置く
+    push_scope_(node->frame_size());
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+    }
+    auto top = assembler_.here();
+    std::optional<Assembler::Patch> exit;
+    if (node->cond().has_value()) {
+        condition_(node->cond().value().get(), true);
+        exit = assembler_.jump_if(Condition::EQUAL);
+    }
+    loop_body_(node->block().get());
+    if (node->update().has_value()) {
+        evaluate_(node->update().value().get());
+    }
+    assembler_.jump_to(top);
+    if (exit.has_value()) {
+        assembler_.patch_jump(*exit, assembler_.here());
+    }
+    end_loop_();
+    pop_scope_();
+}
+void Compiler::visit(const ast::BreakStatement*) {
+    if (break_patches_.empty()) {
+        throw Unsupported{};
+    }
+    break_patches_.back().push_back(assembler_.jump());
+}
+void Compiler::visit(const ast::IfStatement* node) {
+    std::vector<Assembler::Patch> ends;
+    for (const auto& [cond, block] : node->cond_blocks()) {
+        if (cond.use_count() == 0) {
+            block->accept(*this);
+            break;
+        }
+        condition_(cond.get(), false);
+        auto next = assembler_.jump_if(Condition::EQUAL);
+        block->accept(*this);
+        ends.push_back(assembler_.jump());
+        assembler_.patch_jump(next, assembler_.here());
+    }
+    for (auto end : ends) {
+        assembler_.patch_jump(end, assembler_.here());
+    }
+}
+void Compiler::visit(const ast::AssertStatement*) { throw Unsupported{}; }
+}  // namespace Garnet::interpreter::jit
@@ -0,0 +1,174 @@
+#ifndef GARNET_INTERPRETER_JIT_COMPILER
+#define GARNET_INTERPRETER_JIT_COMPILER
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../semantics.hpp"
+#include "assembler.hpp"
+#include "flyweight.hpp"
+#include "native_value.hpp"
+#include "visitor/visitor.hpp"
+namespace Garnet::interpreter::jit {
+struct NativeResult;
+// 実引数はargs[0]から順に、native_value.hppの表現で置く
+using NativeFunction = NativeResult (*)(const std::uint64_t* args);
+// 末尾呼び出しでは、呼び出し先をnextに、実引数を受け渡し場所に置いて戻る
+// 呼び出した側がnextを続けて呼ぶので、末尾呼び出しが続いてもネイティブのスタックは伸びない
+struct NativeResult {
+    std::uint64_t value;
+    NativeFunction next;
+};
+
+// 引数、局所変数、戻り値が全て数値の型の関数を、x86-64の機械語に変換する
+// 本体に使えるのは数値の演算と代入、制御構文、同じ条件を満たす関数の呼び出しだけで、
+// それ以外(グローバル変数、文字列、組み込み関数、assertなど)を含む関数はインタプリタで実行する
+// 結果はインタプリタ(semantics.hppの規則)と一致させる。インタプリタは変数を参照のまま持ち回って
+// 演算の直前に値を読むので、変数の値を読む時点もそれに合わせる
+// Resolverの束縛とTypeCheckerの型を使うので、それらの後に使うこと
+class Compiler : public ast::Visitor {
+    using TypeKey = SimpleFlyWeight::id_type;
+    using Slot = std::uint32_t;
+    static constexpr std::size_t UNKNOWN = semantics::TypeRules::NONE;
+    static constexpr std::size_t MAX_ARGS = 64;
+
+    const semantics::TypeRules& rules_;
+    std::unordered_map<TypeKey, std::size_t> type_indices_;
+    std::vector<NumericType> numeric_types_;
+    // 名前で直接呼び出せる(再代入されない)グローバルな関数
+    std::unordered_map<Slot, const ast::FunctionDef*> functions_;
+
+    std::unordered_map<const ast::FunctionDef*, NativeFunction> compiled_;
+    std::unordered_set<const ast::FunctionDef*> rejected_;
+    // 機械語を置いた実行可能な領域
+    std::vector<std::pair<void*, std::size_t>> regions_;
+    // 末尾呼び出しの実引数の受け渡し場所
+    std::array<std::uint64_t, MAX_ARGS> tail_args_{};
+
+    // 変換できない構文に出会ったら投げ、その関数をインタプリタに任せる
+    struct Unsupported {};
+    // x86-64の命令一つで済まない変換や演算は、C++の関数を呼んで行う
+    using Helper = std::uint64_t (*)(std::uint64_t, std::uint64_t);
+
+    struct Signature {
+        std::vector<std::size_t> args;
+        std::size_t result;
+    };
+    // 呼び出し先の関数の番地を、全ての関数を置いてから書き込む
+    struct CallPatch {
+        Assembler::Patch patch;
+        const ast::FunctionDef* callee;
+    };
+    struct Function {
+        std::vector<std::uint8_t> code;
+        std::vector<CallPatch> calls;
+    };
+
+    // 変換中の関数の状態
+    Assembler assembler_;
+    // 各スコープの変数の型。まだ宣言を実行していない変数はUNKNOWN
+    struct Scope {
+        std::int32_t base;
+        std::vector<std::size_t> types;
+    };
+    std::vector<Scope> scopes_;
+    std::int32_t next_slot_ = 0;
+    std::int32_t max_slots_ = 0;
+    // 局所変数の領域より下に積んだ8バイトの数。呼び出しの前にrspを16バイト境界に揃えるのに使う
+    std::int32_t depth_ = 0;
+    std::size_t result_type_ = UNKNOWN;
+    std::vector<std::vector<Assembler::Patch>> break_patches_;
+    std::vector<CallPatch> calls_;
+
+    // 式を変換した結果。localがあれば値はまだ読んでおらず、その変数を指している
+    struct Operand {
+        std::size_t type = UNKNOWN;
+        std::optional<std::int32_t> local = std::nullopt;
+    };
+    Operand result_;
+
+    std::optional<Signature> signature_(const ast::FunctionDef* node) const;
+    const NumericType& numeric_(std::size_t type) const { return numeric_types_[type]; }
+    static std::int32_t disp_(std::int32_t slot) { return -8 * (slot + 1); }
+
+    void push_scope_(std::size_t size);
+    void pop_scope_();
+    Operand local_(const ast::Expression* expr) const;
+    const ast::FunctionDef* callee_(const ast::FunctionCall* node) const;
+
+    Operand evaluate_(const ast::Expression* expr);
+    void load_(const Operand& operand);
+    void push_(bool is_rcx);
+    void pop_(bool is_rcx);
+    void call_helper_(Helper helper);
+    void normalize_(std::size_t type);
+    void convert_(std::size_t from, std::size_t to);
+    // 条件式を評価して、結果をraxの0/1と比べた状態にする
+    // is_loopなら、ループの条件式やand/orの被演算子と同じくboolでなければならない
+    void condition_(const ast::Expression* cond, bool is_loop);
+    // 演算の前に左辺と右辺を変換する型
+    std::pair<std::size_t, std::size_t> operand_types_(ast::BinaryOperator::OperatorType op, std::size_t left,
+                                                       std::size_t right, std::size_t result) const;
+    // raxとrcxの、typeに変換済みの値を演算する
+    void binary_(ast::BinaryOperator::OperatorType op, std::size_t type, std::size_t result);
+    // 実引数をrspから順に置き、確保したバイト数を返す
+    std::int32_t arguments_(const ast::FunctionCall* node, const Signature& signature);
+    void loop_body_(const ast::Block* block);
+    // breakの分岐先を現在の位置に決める
+    void end_loop_();
+
+    Function compile_function_(const ast::FunctionDef* node);
+    bool place_(std::unordered_map<const ast::FunctionDef*, Function>& functions);
+
+   public:
+    Compiler(const semantics::TypeRules& rules, std::unordered_map<TypeKey, std::size_t> type_indices,
+             std::vector<NumericType> numeric_types, std::unordered_map<Slot, const ast::FunctionDef*> functions);
+    Compiler(const Compiler&) = delete;
+    ~Compiler();
+
+    // このプラットフォームで機械語を生成できるか
+    static bool is_supported();
+    // nodeと、そこから呼び出す関数をまとめて変換する。nodeを変換できなければnullptr
+    NativeFunction compile(const ast::FunctionDef* node);
+    // 変換した関数を呼び、末尾呼び出しの連なりを最後までたどった戻り値を返す
+    std::uint64_t run(NativeFunction function, const std::uint64_t* args);
+    std::size_t compiled_count() const { return compiled_.size(); }
+
+    virtual void visit(const ast::VariableDecl*) override;
+    virtual void visit(const ast::TypeDecl*) override;
+    virtual void visit(const ast::ErrorNode*) override;
+    virtual void visit(const ast::ErrorSentence*) override;
+    virtual void visit(const ast::ErrorExpression*) override;
+    virtual void visit(const ast::ErrorStatement*) override;
+    virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
+    virtual void visit(const ast::UnaryOperator*) override;
+    virtual void visit(const ast::VariableReference*) override;
+    virtual void visit(const ast::SignedIntegerLiteral*) override;
+    virtual void visit(const ast::UnsignedIntegerLiteral*) override;
+    virtual void visit(const ast::FloatingPointLiteral*) override;
+    virtual void visit(const ast::StringLiteral*) override;
+    virtual void visit(const ast::FunctionCall*) override;
+    virtual void visit(const ast::CompilationUnit*) override;
+    virtual void visit(const ast::FunctionDef*) override;
+    virtual void visit(const ast::VariableDeclStatement*) override;
+    virtual void visit(const ast::ReturnStatement*) override;
+    virtual void visit(const ast::Block*) override;
+    virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
+    virtual void visit(const ast::BreakStatement*) override;
+    virtual void visit(const ast::IfStatement*) override;
+    virtual void visit(const ast::AssertStatement*) override;
+    virtual void visit(const ast::BooleanLiteral*) override;
+    virtual void visit(const ast::NilLiteral*) override;
+};
+}  // namespace Garnet::interpreter::jit
+#endif
@@ -0,0 +1,90 @@
+#ifndef GARNET_INTERPRETER_JIT_NATIVE_VALUE
+#define GARNET_INTERPRETER_JIT_NATIVE_VALUE
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+namespace Garnet::interpreter::jit {
+// 機械語の中では、数値を全て64ビットのビット列で持つ
+// 整数は型の幅から64ビットへ符号拡張(符号なしならゼロ拡張)した値、boolは0か1、
+// doubleはそのビット列、floatは下位32ビットにビット列を置き上位を0にした値
+struct NumericType {
+    enum class Kind : std::uint8_t { NONE, SIGNED, UNSIGNED, BOOLEAN, FLOAT };
+    Kind kind = Kind::NONE;
+    std::uint8_t bits = 0;
+
+    bool is_numeric() const { return kind != Kind::NONE; }
+    bool is_integral() const { return kind == Kind::SIGNED || kind == Kind::UNSIGNED || kind == Kind::BOOLEAN; }
+    bool is_float() const { return kind == Kind::FLOAT; }
+};
+
+// Valueの各alternativeの機械語での表現。数値でない型はKind::NONE
+template <typename Value>
+std::vector<NumericType> numeric_types() {
+    return []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::vector<NumericType>{[]<typename T>() -> NumericType {
+            constexpr auto bits = static_cast<std::uint8_t>(sizeof(T) * 8);
+            if constexpr (std::is_same_v<T, bool>) {
+                return {.kind = NumericType::Kind::BOOLEAN, .bits = 1};
+            } else if constexpr (std::is_floating_point_v<T>) {
+                return {.kind = NumericType::Kind::FLOAT, .bits = bits};
+            } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                return {.kind = NumericType::Kind::SIGNED, .bits = bits};
+            } else if constexpr (std::is_integral_v<T>) {
+                return {.kind = NumericType::Kind::UNSIGNED, .bits = bits};
+            } else {
+                return {};
+            }
+        }.template operator()<std::variant_alternative_t<I, Value>>()...};
+    }(std::make_index_sequence<std::variant_size_v<Value>>());
+}
+
+// 数値でない値は0になる
+template <typename Value>
+std::uint64_t to_native(const Value& value) {
+    return std::visit(
+        [](const auto& value) -> std::uint64_t {
+            using T = std::remove_cvref_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, double>) {
+                return std::bit_cast<std::uint64_t>(value);
+            } else if constexpr (std::is_same_v<T, float>) {
+                return std::bit_cast<std::uint32_t>(value);
+            } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                return static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+            } else if constexpr (std::is_integral_v<T>) {
+                return static_cast<std::uint64_t>(value);
+            } else {
+                return 0;
+            }
+        },
+        value);
+}
+
+// to_nativeの逆。typeはValueのalternativeの番号で、数値の型でなければその型の既定値を返す
+template <typename Value>
+Value from_native(std::size_t type, std::uint64_t bits) {
+    using Converter = Value (*)(std::uint64_t);
+    static constexpr auto converters = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<Converter, sizeof...(I)>{[](std::uint64_t bits) -> Value {
+            using T = std::variant_alternative_t<I, Value>;
+            if constexpr (std::is_same_v<T, double>) {
+                return Value(std::in_place_index<I>, std::bit_cast<double>(bits));
+            } else if constexpr (std::is_same_v<T, float>) {
+                return Value(std::in_place_index<I>, std::bit_cast<float>(static_cast<std::uint32_t>(bits)));
+            } else if constexpr (std::is_same_v<T, bool>) {
+                return Value(std::in_place_index<I>, bits != 0);
+            } else if constexpr (std::is_integral_v<T>) {
+                return Value(std::in_place_index<I>, static_cast<T>(bits));
+            } else {
+                return Value(std::in_place_index<I>);
+            }
+        }...};
+    }(std::make_index_sequence<std::variant_size_v<Value>>());
+    return converters[type](bits);
+}
+}  // namespace Garnet::interpreter::jit
+#endif
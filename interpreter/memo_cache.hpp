@@ -0,0 +1,131 @@
+#ifndef GARNET_INTERPRETER_MEMO_CACHE
+#define GARNET_INTERPRETER_MEMO_CACHE
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+namespace Garnet::interpreter {
+// 純粋な関数の呼び出し結果を、実引数の値をキーにして覚えておく
+// 大きさは固定で、キーのハッシュ値で決まる場所に置く。衝突したら古い結果を捨てるので、メモリは増えない
+// 数値、文字列、nil以外の値を含む実引数は覚えない
+template <typename Value>
+class MemoCache {
+    struct Entry {
+        bool used = false;
+        std::size_t hash = 0;
+        // 置き換えても容量は再利用されるので、埋まった後は確保しない
+        std::vector<Value> args;
+        Value result;
+    };
+    std::vector<Entry> entries_;
+    std::size_t hits_ = 0;
+    std::size_t misses_ = 0;
+
+    static std::optional<std::size_t> hash_(std::span<const Value> args) {
+        std::size_t result = args.size();
+        for (const auto& arg : args) {
+            auto element = std::visit(
+                [](const auto& value) -> std::optional<std::size_t> {
+                    using T = std::remove_cvref_t<decltype(value)>;
+                    if constexpr (std::is_floating_point_v<T>) {
+                        // 0.0と-0.0は結果が異なりうるので、ビット列で区別する
+                        return std::hash<std::uint64_t>()(std::bit_cast<std::uint64_t>(static_cast<double>(value)));
+                    } else if constexpr (std::is_arithmetic_v<T>) {
+                        return std::hash<T>()(value);
+                    } else if constexpr (requires { value.view(); }) {
+                        return std::hash<std::string_view>()(value.view());
+                    } else if constexpr (std::is_empty_v<T>) {
+                        return 0;
+                    } else {
+                        return std::nullopt;
+                    }
+                },
+                arg);
+            if (not element.has_value()) {
+                return std::nullopt;
+            }
+            result = (result ^ (*element + arg.index())) * 0x9e3779b97f4a7c15;
+        }
+        // 場所は下位のビットで決めるので、上位のビットも混ぜておく
+        result ^= result >> 33;
+        result *= 0xff51afd7ed558ccd;
+        result ^= result >> 33;
+        return result;
+    }
+    static bool equal_(std::span<const Value> lhs, std::span<const Value> rhs) {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < lhs.size(); i++) {
+            if (lhs[i].index() != rhs[i].index()) {
+                return false;
+            }
+            bool equal = std::visit(
+                [&rhs = rhs[i]](const auto& left) {
+                    using T = std::remove_cvref_t<decltype(left)>;
+                    const auto& right = std::get<T>(rhs);
+                    if constexpr (std::is_floating_point_v<T>) {
+                        return std::bit_cast<std::uint64_t>(static_cast<double>(left)) ==
+                               std::bit_cast<std::uint64_t>(static_cast<double>(right));
+                    } else if constexpr (std::is_arithmetic_v<T>) {
+                        return left == right;
+                    } else if constexpr (requires { left.view(); }) {
+                        return left.view() == right.view();
+                    } else {
+                        return std::is_empty_v<T>;
+                    }
+                },
+                lhs[i]);
+            if (not equal) {
+                return false;
+            }
+        }
+        return true;
+    }
+    Entry& entry_(std::size_t hash) { return entries_[hash & (entries_.size() - 1)]; }
+
+   public:
+    // 大きさは2の冪に切り上げる
+    explicit MemoCache(std::size_t capacity) : entries_(std::bit_ceil(std::max<std::size_t>(capacity, 1))) {}
+
+    // 覚えている結果を返す。なければnullptr
+    const Value* find(std::span<const Value> args) {
+        auto hash = hash_(args);
+        if (hash.has_value()) {
+            auto& entry = entry_(*hash);
+            if (entry.used && entry.hash == *hash && equal_(entry.args, args)) {
+                hits_++;
+                return &entry.result;
+            }
+        }
+        misses_++;
+        return nullptr;
+    }
+    void insert(std::span<const Value> args, const Value& result) {
+        auto hash = hash_(args);
+        if (not hash.has_value()) {
+            return;
+        }
+        auto& entry = entry_(*hash);
+        entry.used = true;
+        entry.hash = *hash;
+        entry.args.assign(args.begin(), args.end());
+        entry.result = result;
+    }
+
+    std::size_t hits() const { return hits_; }
+    std::size_t misses() const { return misses_; }
+    std::size_t capacity() const { return entries_.size(); }
+    std::size_t size() const {
+        return std::ranges::count_if(entries_, [](const Entry& entry) { return entry.used; });
+    }
+};
+}  // namespace Garnet::interpreter
+#endif
@@ -0,0 +1,352 @@
+#include "optimizer.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "concrete_decls.hpp"
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_statements.hpp"
+#include "error_nodes.hpp"
+#include "semantics.hpp"
+#include "shared_string.hpp"
+namespace Garnet::interpreter {
+namespace {
+// リテラルの値。型は実行時にリテラルが評価される型と一致させる
+struct NilConstant : public std::monostate {
+    using std::monostate::monostate;
+};
+using Constant = std::variant<NilConstant, std::int64_t, std::uint64_t, double, bool, SharedString>;
+
+std::optional<Constant> to_constant(const ast::Base* node) {
+    if (const auto* literal = dynamic_cast<const ast::SignedIntegerLiteral*>(node); literal != nullptr) {
+        return literal->value();
+    }
+    if (const auto* literal = dynamic_cast<const ast::UnsignedIntegerLiteral*>(node); literal != nullptr) {
+        return literal->value();
+    }
+    if (const auto* literal = dynamic_cast<const ast::FloatingPointLiteral*>(node); literal != nullptr) {
+        return literal->value();
+    }
+    if (const auto* literal = dynamic_cast<const ast::BooleanLiteral*>(node); literal != nullptr) {
+        return literal->value();
+    }
+    if (const auto* literal = dynamic_cast<const ast::StringLiteral*>(node); literal != nullptr) {
+        return SharedString(literal->value());
+    }
+    if (dynamic_cast<const ast::NilLiteral*>(node) != nullptr) {
+        return NilConstant{};
+    }
+    return std::nullopt;
+}
+std::shared_ptr<ast::Expression> to_literal(const Constant& value, location::SourceRegion location) {
+    return std::visit(
+        [&location](const auto& value) -> std::shared_ptr<ast::Expression> {
+            using Type = std::remove_cvref_t<decltype(value)>;
+            if constexpr (std::is_same_v<Type, NilConstant>) {
+                return std::make_shared<ast::NilLiteral>(location);
+            } else if constexpr (std::is_same_v<Type, std::int64_t>) {
+                return std::make_shared<ast::SignedIntegerLiteral>(value, location);
+            } else if constexpr (std::is_same_v<Type, std::uint64_t>) {
+                return std::make_shared<ast::UnsignedIntegerLiteral>(value, location);
+            } else if constexpr (std::is_same_v<Type, double>) {
+                return std::make_shared<ast::FloatingPointLiteral>(value, location);
+            } else if constexpr (std::is_same_v<Type, bool>) {
+                return std::make_shared<ast::BooleanLiteral>(value, location);
+            } else {
+                return std::make_shared<ast::StringLiteral>(std::string(value.view()), location);
+            }
+        },
+        value);
+}
+// 実行時に未定義動作になる演算は、畳み込まずに実行時に任せる
+bool is_undefined(ast::BinaryOperator::OperatorType op, const Constant& left, const Constant& right) {
+    return std::visit(
+        [op](const auto& left, const auto& right) {
+            using LeftType = std::remove_cvref_t<decltype(left)>;
+            using RightType = std::remove_cvref_t<decltype(right)>;
+            using enum ast::BinaryOperator::OperatorType;
+            if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
+                // シフト量はsemantics::shift_countで常に定まるので、畳み込める
+                if (op == MOD) {
+                    return right == 0 || (std::is_signed_v<RightType> && right == static_cast<RightType>(-1));
+                }
+            }
+            return false;
+        },
+        left, right);
+}
+// 宣言された型とリテラルの型が一致するときだけ伝播する(変数は宣言された型に変換されるため)
+bool has_literal_type(const ast::VariableDecl* decl, const ast::Base* literal) {
+    auto type = decl->type().source_name();
+    return (type == "i64" && dynamic_cast<const ast::SignedIntegerLiteral*>(literal) != nullptr) ||
+           (type == "u64" && dynamic_cast<const ast::UnsignedIntegerLiteral*>(literal) != nullptr) ||
+           (type == "f64" && dynamic_cast<const ast::FloatingPointLiteral*>(literal) != nullptr) ||
+           (type == "str" && dynamic_cast<const ast::StringLiteral*>(literal) != nullptr) ||
+           (type == "NilType" && dynamic_cast<const ast::NilLiteral*>(literal) != nullptr);
+}
+}  // namespace
+
+std::shared_ptr<ast::CompilationUnit> Optimizer::optimize(const std::shared_ptr<ast::CompilationUnit>& unit) {
+    collecting_ = true;
+    transform_(unit);
+    collecting_ = false;
+    return transform_(unit);
+}
+const ast::VariableDecl* Optimizer::lookup_(NameType name) const {
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope) {
+        if (auto pos = scope->find(name); pos != scope->end()) {
+            return pos->second;
+        }
+    }
+    return nullptr;
+}
+std::shared_ptr<ast::Expression> Optimizer::transform_condition_(const std::shared_ptr<ast::Expression>& cond) {
+    keep_reference_ = true;
+    auto result = transform_(cond);
+    keep_reference_ = false;
+    return result;
+}
+void Optimizer::visit(const ast::VariableDecl* node) {
+    auto init = node->init();
+    if (init.has_value()) {
+        init = transform_(init.value());
+        if (init != node->init()) {
+            result_ = std::make_shared<ast::VariableDecl>(node->name(), node->type(), init, node->location(),
+                                                          node->is_const());
+        }
+        if (node->is_const() && not collecting_ && not assigned_.contains(node) &&
+            has_literal_type(node, init.value().get())) {
+            constants_[node] = init.value();
+        }
+    }
+    // グローバル変数は関数本体から参照されるが、初期化式を持てないので定数にはならない
+    if (not scopes_.empty()) {
+        scopes_.back()[node->name().source_id()] = node;
+    }
+}
+void Optimizer::visit(const ast::TypeDecl*) {}
+void Optimizer::visit(const ast::ErrorNode*) {}
+void Optimizer::visit(const ast::ErrorSentence*) {}
+void Optimizer::visit(const ast::ErrorExpression*) {}
+void Optimizer::visit(const ast::ErrorStatement*) {}
+void Optimizer::visit(const ast::BinaryOperator* node) {
+    bool keep_reference = std::exchange(keep_reference_, false);
+    std::shared_ptr<ast::Expression> left, right;
+    if (node->op() == ast::BinaryOperator::OperatorType::ASSIGN) {
+        bool in_assign_target = std::exchange(in_assign_target_, true);
+        left = transform_(node->left());
+        in_assign_target_ = in_assign_target;
+        // 代入式の値は右辺の値そのものなので、右辺が条件式の値になる
+        keep_reference_ = keep_reference;
+        right = transform_(node->right());
+        keep_reference_ = false;
+    } else {
+        left = transform_(node->left());
+        right = transform_(node->right());
+    }
+    auto lhs = to_constant(left.get());
+    auto rhs = to_constant(right.get());
+    if (lhs.has_value() && rhs.has_value() && not is_undefined(node->op(), *lhs, *rhs)) {
+        if (auto handler = semantics::BinaryDispatchTable<Constant>::find(node->op(), lhs->index(), rhs->index());
+            handler != nullptr) {
+            result_ = to_literal(handler(*lhs, *rhs), node->location());
+            return;
+        }
+    }
+    if (left != node->left() || right != node->right()) {
+        result_ = std::make_shared<ast::BinaryOperator>(node->op(), left, right, node->location());
+    }
+}
+void Optimizer::visit(const ast::CompoundAssign* node) {
+    keep_reference_ = false;
+    bool in_assign_target = std::exchange(in_assign_target_, true);
+    auto target = transform_(node->target());
+    in_assign_target_ = in_assign_target;
+    auto value = transform_(node->value());
+    if (target != node->target() || value != node->value()) {
+        result_ = std::make_shared<ast::CompoundAssign>(node->op(), target, value, node->location());
+    }
+}
+void Optimizer::visit(const ast::LogicalOperator* node) {
+    keep_reference_ = false;
+    auto left = transform_(node->left());
+    auto right = transform_(node->right());
+    const auto* lhs = dynamic_cast<const ast::BooleanLiteral*>(left.get());
+    const auto* rhs = dynamic_cast<const ast::BooleanLiteral*>(right.get());
+    if (lhs != nullptr && rhs != nullptr) {
+        bool value = node->op() == ast::LogicalOperator::OperatorType::AND ? lhs->value() && rhs->value()
+                                                                           : lhs->value() || rhs->value();
+        result_ = std::make_shared<ast::BooleanLiteral>(value, node->location());
+        return;
+    }
+    if (left != node->left() || right != node->right()) {
+        result_ = std::make_shared<ast::LogicalOperator>(node->op(), left, right, node->location());
+    }
+}
+void Optimizer::visit(const ast::UnaryOperator* node) {
+    keep_reference_ = false;
+    auto operand = transform_(node->operand());
+    if (auto value = to_constant(operand.get()); value.has_value()) {
+        if (auto handler = semantics::UnaryDispatchTable<Constant>::find(node->op(), value->index());
+            handler != nullptr) {
+            result_ = to_literal(handler(*value), node->location());
+            return;
+        }
+    }
+    if (operand != node->operand()) {
+        result_ = std::make_shared<ast::UnaryOperator>(node->op(), operand, node->location());
+    }
+}
+void Optimizer::visit(const ast::VariableReference* node) {
+    const auto* decl = lookup_(node->name().source_id());
+    if (decl == nullptr) {
+        return;
+    }
+    if (in_assign_target_) {
+        assigned_.insert(decl);
+        return;
+    }
+    if (keep_reference_ || node->valref() == ValRef::REFERENCE) {
+        return;
+    }
+    if (auto pos = constants_.find(decl); pos != constants_.end()) {
+        result_ = to_literal(to_constant(pos->second.get()).value(), node->location());
+    }
+}
+void Optimizer::visit(const ast::SignedIntegerLiteral*) {}
+void Optimizer::visit(const ast::UnsignedIntegerLiteral*) {}
+void Optimizer::visit(const ast::FloatingPointLiteral*) {}
+void Optimizer::visit(const ast::StringLiteral*) {}
+void Optimizer::visit(const ast::BooleanLiteral*) {}
+void Optimizer::visit(const ast::NilLiteral*) {}
+void Optimizer::visit(const ast::FunctionCall* node) {
+    keep_reference_ = false;
+    auto callee = transform_(node->callee());
+    bool changed = callee != node->callee();
+    std::vector<std::shared_ptr<ast::Expression>> args;
+    for (const auto& arg : node->args()) {
+        args.push_back(transform_(arg));
+        changed = changed || args.back() != arg;
+    }
+    if (changed) {
+        result_ = std::make_shared<ast::FunctionCall>(callee, std::move(args), node->location());
+    }
+}
+void Optimizer::visit(const ast::CompilationUnit* node) {
+    auto unit = std::make_shared<ast::CompilationUnit>(node->location());
+    for (const auto& child : node->children()) {
+        unit->add_child(transform_(child));
+    }
+    result_ = unit;
+}
+void Optimizer::visit(const ast::FunctionDef* node) {
+    // 引数のスコープの親はグローバルスコープ
+    scopes_.emplace_back();
+    for (const auto& arginfo : node->info().args()) {
+        scopes_.back()[arginfo.name().source_id()] = nullptr;
+    }
+    auto block = transform_(node->block());
+    scopes_.pop_back();
+    if (block != node->block()) {
+        result_ = std::make_shared<ast::FunctionDef>(node->info(), block, node->location());
+    }
+}
+void Optimizer::visit(const ast::VariableDeclStatement* node) {
+    auto decl = transform_(node->decl());
+    if (decl != node->decl()) {
+        result_ = std::make_shared<ast::VariableDeclStatement>(decl, node->location());
+    }
+}
+void Optimizer::visit(const ast::ReturnStatement* node) {
+    auto retval = transform_(node->retval());
+    if (retval != node->retval()) {
+        result_ = std::make_shared<ast::ReturnStatement>(retval, node->location());
+    }
+}
+void Optimizer::visit(const ast::Block* node) {
+    scopes_.emplace_back();
+    bool changed = false;
+    std::vector<std::shared_ptr<ast::Sentence>> sentences;
+    for (const auto& sentence : node->sentences()) {
+        sentences.push_back(transform_(sentence));
+        changed = changed || sentences.back() != sentence;
+    }
+    scopes_.pop_back();
+    if (changed) {
+        result_ = std::make_shared<ast::Block>(std::move(sentences), node->location());
+    }
+}
+void Optimizer::visit(const ast::LoopStatement* node) {
+    auto block = transform_(node->block());
+    if (block != node->block()) {
+        result_ = std::make_shared<ast::LoopStatement>(block, node->location());
+    }
+}
+void Optimizer::visit(const ast::WhileStatement* node) {
+    auto cond = transform_(node->cond());
+    auto block = transform_(node->block());
+    if (cond != node->cond() || block != node->block()) {
+        result_ = std::make_shared<ast::WhileStatement>(cond, block, node->location());
+    }
+}
+void Optimizer::visit(const ast::DoWhileStatement* node) {
+    auto block = transform_(node->block());
+    auto cond = transform_(node->cond());
+    if (block != node->block() || cond != node->cond()) {
+        result_ = std::make_shared<ast::DoWhileStatement>(block, cond, node->location());
+    }
+}
+void Optimizer::visit(const ast::ForStatement* node) {
+    scopes_.emplace_back();
+    auto init = node->init();
+    if (init.has_value()) {
+        init = transform_(init.value());
+    }
+    auto cond = node->cond();
+    if (cond.has_value()) {
+        cond = transform_(cond.value());
+    }
+    auto update = node->update();
+    if (update.has_value()) {
+        update = transform_(update.value());
+    }
+    auto block = transform_(node->block());
+    scopes_.pop_back();
+    if (init != node->init() || cond != node->cond() || update != node->update() || block != node->block()) {
+        result_ = std::make_shared<ast::ForStatement>(init, cond, update, block, node->location());
+    }
+}
+void Optimizer::visit(const ast::BreakStatement*) {}
+void Optimizer::visit(const ast::IfStatement* node) {
+    bool changed = false;
+    auto cond_blocks = node->cond_blocks();
+    for (auto& [cond, block] : cond_blocks) {
+        if (cond.use_count() != 0) {
+            auto new_cond = transform_condition_(cond);
+            changed = changed || new_cond != cond;
+            cond = new_cond;
+        }
+        auto new_block = transform_(block);
+        changed = changed || new_block != block;
+        block = new_block;
+    }
+    if (changed) {
+        result_ = std::make_shared<ast::IfStatement>(std::move(cond_blocks), node->location());
+    }
+}
+void Optimizer::visit(const ast::AssertStatement* node) {
+    auto cond = transform_condition_(node->cond());
+    auto msg = node->msg();
+    if (msg.has_value()) {
+        msg = transform_(msg.value());
+    }
+    if (cond != node->cond() || msg != node->msg()) {
+        result_ = std::make_shared<ast::AssertStatement>(cond, msg, node->location());
+    }
+}
+}  // namespace Garnet::interpreter
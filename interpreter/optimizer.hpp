@@ -0,0 +1,85 @@
+#ifndef GARNET_INTERPRETER_OPTIMIZER
+#define GARNET_INTERPRETER_OPTIMIZER
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+#include "compilation_unit.hpp"
+#include "expression.hpp"
+#include "flyweight.hpp"
+#include "visitor/visitor.hpp"
+namespace Garnet::interpreter {
+// 実行前にASTを書き換える
+// リテラルだけからなる演算子の部分木をリテラルに畳み込み、
+// リテラルで初期化されて一度も代入されないlet変数への参照を、そのリテラルで置き換える
+// 節は不変なので、子が変わった節だけを作り直し、変わらない部分木は元の節を共有する
+// 実行時の型や、条件式の変数を値に変換しないといった振る舞いは変えない
+class Optimizer : public ast::Visitor {
+    using NameType = SimpleFlyWeight::id_type;
+
+    // 名前から、その名前を宣言したVariableDecl(引数ならnullptr)を引く
+    std::vector<std::unordered_map<NameType, const ast::VariableDecl*>> scopes_;
+    // 伝播できる定数
+    std::unordered_map<const ast::VariableDecl*, std::shared_ptr<ast::Expression>> constants_;
+    // ASSIGNの左辺に現れる変数
+    std::unordered_set<const ast::VariableDecl*> assigned_;
+
+    // 一度目の走査の結果は捨て、代入される変数を集めるためだけに使う
+    bool collecting_ = false;
+    bool in_assign_target_ = false;
+    // 条件式の値になる変数参照は、参照のまま残す
+    bool keep_reference_ = false;
+
+    // visitが書き換え後の節をここに置く。書き換えなければnullptrのまま
+    std::shared_ptr<ast::Base> result_;
+    template <typename T>
+    std::shared_ptr<T> transform_(const std::shared_ptr<T>& node) {
+        result_ = nullptr;
+        node->accept(*this);
+        if (result_ == nullptr) {
+            return node;
+        }
+        return std::dynamic_pointer_cast<T>(std::exchange(result_, nullptr));
+    }
+    std::shared_ptr<ast::Expression> transform_condition_(const std::shared_ptr<ast::Expression>& cond);
+    const ast::VariableDecl* lookup_(NameType name) const;
+
+   public:
+    std::shared_ptr<ast::CompilationUnit> optimize(const std::shared_ptr<ast::CompilationUnit>& unit);
+
+    virtual void visit(const ast::VariableDecl*) override;
+    virtual void visit(const ast::TypeDecl*) override;
+    virtual void visit(const ast::ErrorNode*) override;
+    virtual void visit(const ast::ErrorSentence*) override;
+    virtual void visit(const ast::ErrorExpression*) override;
+    virtual void visit(const ast::ErrorStatement*) override;
+    virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
+    virtual void visit(const ast::UnaryOperator*) override;
+    virtual void visit(const ast::VariableReference*) override;
+    virtual void visit(const ast::SignedIntegerLiteral*) override;
+    virtual void visit(const ast::UnsignedIntegerLiteral*) override;
+    virtual void visit(const ast::FloatingPointLiteral*) override;
+    virtual void visit(const ast::StringLiteral*) override;
+    virtual void visit(const ast::FunctionCall*) override;
+    virtual void visit(const ast::CompilationUnit*) override;
+    virtual void visit(const ast::FunctionDef*) override;
+    virtual void visit(const ast::VariableDeclStatement*) override;
+    virtual void visit(const ast::ReturnStatement*) override;
+    virtual void visit(const ast::Block*) override;
+    virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
+    virtual void visit(const ast::BreakStatement*) override;
+    virtual void visit(const ast::IfStatement*) override;
+    virtual void visit(const ast::AssertStatement*) override;
+    virtual void visit(const ast::BooleanLiteral*) override;
+    virtual void visit(const ast::NilLiteral*) override;
+};
+}  // namespace Garnet::interpreter
+#endif
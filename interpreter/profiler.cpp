@@ -0,0 +1,124 @@
+#include "profiler.hpp"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#if defined(__unix__)
+#include <csignal>
+#include <sys/time.h>
+#endif
+namespace Garnet::interpreter {
+namespace {
+// 標本は既定の間隔(1ms)で15分強、呼び出し列は全標本を合わせて400万段まで記録できる
+constexpr std::size_t SAMPLE_CAPACITY = 1 << 20;
+constexpr std::size_t BUFFER_CAPACITY = 1 << 22;
+
+Profiler* active = nullptr;
+#if defined(__unix__)
+struct sigaction previous_action;
+#endif
+
+std::string frame_name(const Profiler::Frame& frame, const Profiler::Frame* callee) {
+    // 位置は、次の関数を呼んでいる式か、最も内側なら関数定義
+    auto location = callee != nullptr && callee->call_site != nullptr ? callee->call_site->location()
+                                                                      : frame.function->location();
+    return fmt::format("{} ({}:{})", frame.function->info().name().source_name(), location.begin.source_file(),
+                       location.begin.line);
+}
+}  // namespace
+
+Profiler::Profiler(std::chrono::microseconds interval)
+    : interval_(interval), frames_(std::make_unique<Frame[]>(MAX_DEPTH)) {}
+Profiler::~Profiler() { stop(); }
+
+bool Profiler::is_supported() {
+#if defined(__unix__)
+    return true;
+#else
+    return false;
+#endif
+}
+void Profiler::handle_signal_(int) {
+    if (active != nullptr) {
+        active->sample_();
+    }
+}
+// シグナルハンドラから呼ばれるので、確保済みの領域への書き込みだけを行う
+void Profiler::sample_() {
+    auto depth = std::min(depth_.load(std::memory_order_relaxed), MAX_DEPTH);
+    std::atomic_signal_fence(std::memory_order_acquire);
+    if (sample_count_ == SAMPLE_CAPACITY || buffer_used_ + depth > BUFFER_CAPACITY) {
+        dropped_++;
+        return;
+    }
+    for (std::size_t i = 0; i < depth; i++) {
+        buffer_[buffer_used_ + i] = frames_[i];
+    }
+    buffer_used_ += depth;
+    samples_[sample_count_++] = buffer_used_;
+}
+void Profiler::start() {
+    if (is_running_ || not is_supported() || active != nullptr) {
+        return;
+    }
+    if (buffer_ == nullptr) {
+        buffer_ = std::make_unique_for_overwrite<Frame[]>(BUFFER_CAPACITY);
+        samples_ = std::make_unique_for_overwrite<std::size_t[]>(SAMPLE_CAPACITY);
+    }
+    active = this;
+    is_running_ = true;
+#if defined(__unix__)
+    struct sigaction action = {};
+    action.sa_handler = handle_signal_;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &previous_action);
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(interval_);
+    struct itimerval timer = {};
+    timer.it_interval.tv_sec = static_cast<time_t>(seconds.count());
+    timer.it_interval.tv_usec = static_cast<suseconds_t>((interval_ - seconds).count());
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+}
+void Profiler::stop() {
+    if (not is_running_) {
+        return;
+    }
+#if defined(__unix__)
+    struct itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &previous_action, nullptr);
+#endif
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    active = nullptr;
+    is_running_ = false;
+}
+void Profiler::write_folded(std::ostream& out) const {
+    // 同じ呼び出し列の標本をまとめる。mapなので出力は呼び出し列の辞書順になる
+    std::map<std::string, std::size_t> stacks;
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < sample_count_; i++) {
+        auto end = samples_[i];
+        std::string stack;
+        for (auto j = begin; j < end; j++) {
+            if (j != begin) {
+                stack += ';';
+            }
+            stack += frame_name(buffer_[j], j + 1 < end ? &buffer_[j + 1] : nullptr);
+        }
+        // 関数の外(グローバル変数の初期化など)で取った標本
+        stacks[stack.empty() ? "(global)" : stack]++;
+        begin = end;
+    }
+    for (const auto& [stack, count] : stacks) {
+        fmt::print(out, "{} {}\n", stack, count);
+    }
+}
+}  // namespace Garnet::interpreter
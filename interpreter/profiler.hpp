@@ -0,0 +1,85 @@
+#ifndef GARNET_INTERPRETER_PROFILER
+#define GARNET_INTERPRETER_PROFILER
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <utility>
+namespace Garnet::ast {
+class FunctionDef;
+class FunctionCall;
+}  // namespace Garnet::ast
+namespace Garnet::interpreter {
+// 実行中のGarnetの関数の呼び出し列を一定のCPU時間ごと(SIGPROF)に標本化し、
+// flamegraphなどで読めるfolded stacks形式(`main (a.grn:10);fib (a.grn:5) 42`)で書き出す
+// インタプリタは関数に入る/出るたびに影のスタックを積み降ろしする。シグナルハンドラはそれを確保済みの領域へ
+// 写すだけで、名前や位置への変換と集計は標本化を止めた後に行う
+// 各関数の位置は、そこから次の関数を呼んでいる式の行(最も内側の関数では関数定義の行)
+class Profiler {
+   public:
+    struct Frame {
+        const ast::FunctionDef* function;
+        // この関数を呼び出した式。mainや組み込み関数から呼ばれたならnullptr
+        const ast::FunctionCall* call_site;
+    };
+
+   private:
+    static constexpr std::size_t MAX_DEPTH = 4096;
+
+    std::chrono::microseconds interval_;
+    // 影のスタック。MAX_DEPTHより深い呼び出しは数えるだけで記録しない
+    std::unique_ptr<Frame[]> frames_;
+    std::atomic<std::size_t> depth_ = 0;
+    const ast::FunctionCall* call_site_ = nullptr;
+
+    // 標本。samples_[i]はi番目の標本の、buffer_上での終わりの位置
+    // 領域は初期化せずに確保するので、実際に書き込んだ分だけがメモリを使う
+    std::unique_ptr<Frame[]> buffer_;
+    std::unique_ptr<std::size_t[]> samples_;
+    std::size_t buffer_used_ = 0;
+    std::size_t sample_count_ = 0;
+    std::size_t dropped_ = 0;
+    bool is_running_ = false;
+
+    static void handle_signal_(int);
+    void sample_();
+
+   public:
+    explicit Profiler(std::chrono::microseconds interval);
+    Profiler(const Profiler&) = delete;
+    ~Profiler();
+
+    // このプラットフォームで標本化できるか
+    static bool is_supported();
+    void start();
+    void stop();
+
+    // 次に入る関数を呼び出す式を記録する
+    void call_from(const ast::FunctionCall* call_site) { call_site_ = call_site; }
+    void enter(const ast::FunctionDef* function) {
+        auto depth = depth_.load(std::memory_order_relaxed);
+        if (depth < MAX_DEPTH) {
+            frames_[depth] = {.function = function, .call_site = std::exchange(call_site_, nullptr)};
+        }
+        // 要素を書き終えてから深さを増やす。シグナルハンドラは増えた深さまでしか読まない
+        std::atomic_signal_fence(std::memory_order_release);
+        depth_.store(depth + 1, std::memory_order_relaxed);
+    }
+    // 末尾呼び出しでは、呼び出し元の要素の関数を呼び出し先で置き換える
+    // 呼び出した式は、末尾呼び出しの連なりを始めた元の式のままにする
+    void replace(const ast::FunctionDef* function) {
+        auto depth = depth_.load(std::memory_order_relaxed);
+        if (depth <= MAX_DEPTH) {
+            frames_[depth - 1].function = function;
+        }
+    }
+    void leave() { depth_.store(depth_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed); }
+
+    std::size_t sample_count() const { return sample_count_; }
+    // 領域が足りずに捨てた標本の数
+    std::size_t dropped_count() const { return dropped_; }
+    void write_folded(std::ostream& out) const;
+};
+}  // namespace Garnet::interpreter
+#endif
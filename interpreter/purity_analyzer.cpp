@@ -0,0 +1,174 @@
+#include "purity_analyzer.hpp"
+
+#include <algorithm>
+
+#include "compilation_unit.hpp"
+#include "concrete_decls.hpp"
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_statements.hpp"
+#include "error_nodes.hpp"
+namespace Garnet::interpreter {
+std::unordered_set<const ast::FunctionDef*> PurityAnalyzer::analyze(const ast::CompilationUnit& unit) {
+    unit.accept(*this);
+    std::unordered_set<const ast::FunctionDef*> pure;
+    for (const auto& [slot, function] : functions_) {
+        if (not summaries_.at(function).impure) {
+            pure.insert(function);
+        }
+    }
+    // 純粋でない関数を呼ぶ関数も純粋でない。再帰呼び出しは純粋さを妨げない
+    auto is_pure_callee = [this, &pure](Slot slot) {
+        return not assigned_globals_.contains(slot) && not global_variables_.contains(slot) &&
+               functions_.contains(slot) && pure.contains(functions_.at(slot));
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto iter = pure.begin(); iter != pure.end();) {
+            if (std::ranges::all_of(summaries_.at(*iter).callees, is_pure_callee)) {
+                ++iter;
+            } else {
+                iter = pure.erase(iter);
+                changed = true;
+            }
+        }
+    }
+    return pure;
+}
+std::unordered_map<PurityAnalyzer::Slot, const ast::FunctionDef*> PurityAnalyzer::fixed_functions() const {
+    std::unordered_map<Slot, const ast::FunctionDef*> fixed;
+    for (const auto& [slot, function] : functions_) {
+        if (not assigned_globals_.contains(slot) && not global_variables_.contains(slot)) {
+            fixed.emplace(slot, function);
+        }
+    }
+    return fixed;
+}
+bool PurityAnalyzer::is_global_(const ast::VariableReference* node) const {
+    // 未定義の名前は実行時に解決されるので、グローバル変数と同じく扱う
+    auto binding = node->binding();
+    return not binding.has_value() || binding->depth == depth_;
+}
+void PurityAnalyzer::assign_to_(const ast::Expression* target) {
+    const auto* reference = dynamic_cast<const ast::VariableReference*>(target);
+    if (reference == nullptr) {
+        target->accept(*this);
+        return;
+    }
+    if (is_global_(reference)) {
+        if (reference->binding().has_value()) {
+            assigned_globals_.insert(reference->binding()->slot);
+        }
+        current_->impure = true;
+    }
+}
+void PurityAnalyzer::visit_scope_(const ast::Base* node) {
+    depth_++;
+    for (const auto& child : node->children()) {
+        child->accept(*this);
+    }
+    depth_--;
+}
+void PurityAnalyzer::visit(const ast::VariableDecl* node) {
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+    }
+}
+void PurityAnalyzer::visit(const ast::TypeDecl*) {}
+void PurityAnalyzer::visit(const ast::ErrorNode*) {}
+void PurityAnalyzer::visit(const ast::ErrorSentence*) {}
+void PurityAnalyzer::visit(const ast::ErrorExpression*) {}
+void PurityAnalyzer::visit(const ast::ErrorStatement*) {}
+void PurityAnalyzer::visit(const ast::BinaryOperator* node) {
+    if (node->op() == ast::BinaryOperator::OperatorType::ASSIGN) {
+        assign_to_(node->left().get());
+    } else {
+        node->left()->accept(*this);
+    }
+    node->right()->accept(*this);
+}
+void PurityAnalyzer::visit(const ast::CompoundAssign* node) {
+    assign_to_(node->target().get());
+    node->value()->accept(*this);
+}
+void PurityAnalyzer::visit(const ast::LogicalOperator* node) {
+    node->left()->accept(*this);
+    node->right()->accept(*this);
+}
+void PurityAnalyzer::visit(const ast::UnaryOperator* node) { node->operand()->accept(*this); }
+void PurityAnalyzer::visit(const ast::VariableReference* node) {
+    if (is_global_(node)) {
+        current_->impure = true;
+    }
+}
+void PurityAnalyzer::visit(const ast::SignedIntegerLiteral*) {}
+void PurityAnalyzer::visit(const ast::UnsignedIntegerLiteral*) {}
+void PurityAnalyzer::visit(const ast::FloatingPointLiteral*) {}
+void PurityAnalyzer::visit(const ast::StringLiteral*) {}
+void PurityAnalyzer::visit(const ast::BooleanLiteral*) {}
+void PurityAnalyzer::visit(const ast::NilLiteral*) {}
+void PurityAnalyzer::visit(const ast::FunctionCall* node) {
+    const auto* callee = dynamic_cast<const ast::VariableReference*>(node->callee().get());
+    if (callee != nullptr && callee->binding().has_value() && is_global_(callee) &&
+        functions_.contains(callee->binding()->slot)) {
+        // 呼び出し先が純粋かどうかは、全ての関数を調べてから決める
+        current_->callees.insert(callee->binding()->slot);
+    } else {
+        // 組み込み関数や、実行時に決まる呼び出し先
+        current_->impure = true;
+        node->callee()->accept(*this);
+    }
+    for (const auto& arg : node->args()) {
+        arg->accept(*this);
+    }
+}
+void PurityAnalyzer::visit(const ast::CompilationUnit* node) {
+    for (const auto& child : node->children()) {
+        if (const auto* function = dynamic_cast<const ast::FunctionDef*>(child.get()); function != nullptr) {
+            functions_[function->slot().value()] = function;
+        } else if (const auto* decl = dynamic_cast<const ast::VariableDecl*>(child.get()); decl != nullptr) {
+            global_variables_.insert(decl->slot().value());
+        }
+    }
+    for (const auto& child : node->children()) {
+        if (const auto* function = dynamic_cast<const ast::FunctionDef*>(child.get()); function != nullptr) {
+            function->accept(*this);
+        }
+    }
+}
+void PurityAnalyzer::visit(const ast::FunctionDef* node) {
+    current_ = &summaries_[node];
+    depth_ = 1;
+    node->block()->accept(*this);
+    depth_ = 0;
+    current_ = nullptr;
+}
+void PurityAnalyzer::visit(const ast::VariableDeclStatement* node) { node->decl()->accept(*this); }
+void PurityAnalyzer::visit(const ast::ReturnStatement* node) { node->retval()->accept(*this); }
+void PurityAnalyzer::visit(const ast::Block* node) { visit_scope_(node); }
+void PurityAnalyzer::visit(const ast::LoopStatement* node) { node->block()->accept(*this); }
+void PurityAnalyzer::visit(const ast::WhileStatement* node) {
+    node->cond()->accept(*this);
+    node->block()->accept(*this);
+}
+void PurityAnalyzer::visit(const ast::DoWhileStatement* node) {
+    node->block()->accept(*this);
+    node->cond()->accept(*this);
+}
+void PurityAnalyzer::visit(const ast::ForStatement* node) { visit_scope_(node); }
+void PurityAnalyzer::visit(const ast::BreakStatement*) {}
+void PurityAnalyzer::visit(const ast::IfStatement* node) {
+    for (const auto& [cond, block] : node->cond_blocks()) {
+        if (cond.use_count() != 0) {
+            cond->accept(*this);
+        }
+        block->accept(*this);
+    }
+}
+void PurityAnalyzer::visit(const ast::AssertStatement* node) {
+    node->cond()->accept(*this);
+    if (node->msg().has_value()) {
+        node->msg().value()->accept(*this);
+    }
+}
+}  // namespace Garnet::interpreter
@@ -0,0 +1,78 @@
+#ifndef GARNET_INTERPRETER_PURITY_ANALYZER
+#define GARNET_INTERPRETER_PURITY_ANALYZER
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "base.hpp"
+#include "expression.hpp"
+#include "visitor/visitor.hpp"
+namespace Garnet::interpreter {
+// 結果が実引数の値だけで決まり、副作用のない(純粋な)関数を探す
+// 純粋な関数は、グローバル変数を読み書きせず、組み込み関数(print, println)を呼ばず、
+// 呼び出すのは再代入されないグローバルな純粋関数だけである
+// Resolverの結果(変数の束縛)を使うので、Resolverの後に実行すること
+class PurityAnalyzer : public ast::Visitor {
+    using Slot = std::uint32_t;
+
+    struct Summary {
+        bool impure = false;
+        // 名前で直接呼び出すグローバルな関数
+        std::unordered_set<Slot> callees;
+    };
+    std::unordered_map<const ast::FunctionDef*, Summary> summaries_;
+    Summary* current_ = nullptr;
+    // 関数の引数のスコープを1とした、現在のスコープの深さ。束縛の深さがこれに等しければグローバル変数
+    std::uint32_t depth_ = 0;
+
+    std::unordered_set<Slot> builtins_;
+    // 関数の再定義は最後の定義が有効になる
+    std::unordered_map<Slot, const ast::FunctionDef*> functions_;
+    std::unordered_set<Slot> global_variables_;
+    // どこかで代入されるグローバル変数(関数を含む)
+    std::unordered_set<Slot> assigned_globals_;
+
+    bool is_global_(const ast::VariableReference* node) const;
+    void assign_to_(const ast::Expression* target);
+    void visit_scope_(const ast::Base* node);
+
+   public:
+    // 組み込み関数のグローバルな番号を、analyze()より先に登録する
+    void declare_builtin(Slot slot) { builtins_.insert(slot); }
+    std::unordered_set<const ast::FunctionDef*> analyze(const ast::CompilationUnit& unit);
+    // analyze()の後に使う。再代入されず、名前で直接呼び出せるグローバルな関数
+    std::unordered_map<Slot, const ast::FunctionDef*> fixed_functions() const;
+
+    virtual void visit(const ast::VariableDecl*) override;
+    virtual void visit(const ast::TypeDecl*) override;
+    virtual void visit(const ast::ErrorNode*) override;
+    virtual void visit(const ast::ErrorSentence*) override;
+    virtual void visit(const ast::ErrorExpression*) override;
+    virtual void visit(const ast::ErrorStatement*) override;
+    virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
+    virtual void visit(const ast::UnaryOperator*) override;
+    virtual void visit(const ast::VariableReference*) override;
+    virtual void visit(const ast::SignedIntegerLiteral*) override;
+    virtual void visit(const ast::UnsignedIntegerLiteral*) override;
+    virtual void visit(const ast::FloatingPointLiteral*) override;
+    virtual void visit(const ast::StringLiteral*) override;
+    virtual void visit(const ast::FunctionCall*) override;
+    virtual void visit(const ast::CompilationUnit*) override;
+    virtual void visit(const ast::FunctionDef*) override;
+    virtual void visit(const ast::VariableDeclStatement*) override;
+    virtual void visit(const ast::ReturnStatement*) override;
+    virtual void visit(const ast::Block*) override;
+    virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
+    virtual void visit(const ast::BreakStatement*) override;
+    virtual void visit(const ast::IfStatement*) override;
+    virtual void visit(const ast::AssertStatement*) override;
+    virtual void visit(const ast::BooleanLiteral*) override;
+    virtual void visit(const ast::NilLiteral*) override;
+};
+}  // namespace Garnet::interpreter
+#endif
@@ -0,0 +1,160 @@
+#include "resolver.hpp"
+
+#include <typeinfo>
+#include <utility>
+
+#include "compilation_unit.hpp"
+#include "concrete_decls.hpp"
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_statements.hpp"
+#include "error_nodes.hpp"
+namespace Garnet::interpreter {
+Resolver::Resolver() { scopes_.emplace_back(); }
+Resolver::Slot Resolver::declare_global(NameType name) {
+    auto& global = scopes_.front();
+    auto [iter, inserted] = global.names.try_emplace(name, global.next_slot);
+    if (inserted) {
+        global.next_slot++;
+    }
+    return iter->second;
+}
+Resolver::Slot Resolver::declare_(NameType name) {
+    auto& scope = scopes_.back();
+    auto [iter, inserted] = scope.names.try_emplace(name, scope.next_slot);
+    if (inserted) {
+        scope.next_slot++;
+    }
+    return iter->second;
+}
+void Resolver::visit(const ast::VariableDecl* node) {
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+    }
+    node->bind_slot(declare_(node->name().source_id()));
+}
+void Resolver::visit(const ast::TypeDecl*) {}
+void Resolver::visit(const ast::ErrorNode*) {}
+void Resolver::visit(const ast::ErrorSentence*) {}
+void Resolver::visit(const ast::ErrorExpression*) {}
+void Resolver::visit(const ast::ErrorStatement*) {}
+void Resolver::visit(const ast::BinaryOperator* node) {
+    node->left()->accept(*this);
+    node->right()->accept(*this);
+}
+void Resolver::visit(const ast::CompoundAssign* node) {
+    node->target()->accept(*this);
+    node->value()->accept(*this);
+}
+void Resolver::visit(const ast::LogicalOperator* node) {
+    node->left()->accept(*this);
+    node->right()->accept(*this);
+}
+void Resolver::visit(const ast::UnaryOperator* node) { node->operand()->accept(*this); }
+void Resolver::visit(const ast::VariableReference* node) {
+    auto name = node->name().source_id();
+    for (std::size_t i = scopes_.size(); i-- > 0;) {
+        auto iter = scopes_[i].names.find(name);
+        if (iter != scopes_[i].names.end()) {
+            node->bind({.depth = static_cast<std::uint32_t>(scopes_.size() - 1 - i), .slot = iter->second});
+            return;
+        }
+    }
+}
+void Resolver::visit(const ast::SignedIntegerLiteral*) {}
+void Resolver::visit(const ast::UnsignedIntegerLiteral*) {}
+void Resolver::visit(const ast::FloatingPointLiteral*) {}
+void Resolver::visit(const ast::StringLiteral*) {}
+void Resolver::visit(const ast::BooleanLiteral*) {}
+void Resolver::visit(const ast::NilLiteral*) {}
+void Resolver::visit(const ast::FunctionCall* node) {
+    node->callee()->accept(*this);
+    if (const auto* callee = dynamic_cast<const ast::VariableReference*>(node->callee().get()); callee != nullptr) {
+        // 束縛の深さが現在のスコープの数より一つ少なければ、グローバルスコープまでたどっている
+        if (auto binding = callee->binding(); binding.has_value() && binding->depth == scopes_.size() - 1) {
+            node->bind_call_site({.site = call_sites_++, .slot = binding->slot});
+        }
+    }
+    for (const auto& arg : node->args()) {
+        arg->accept(*this);
+    }
+}
+void Resolver::visit(const ast::CompilationUnit* node) {
+    for (const auto& child : node->children()) {
+        const auto& raw = *child;
+        if (typeid(raw) == typeid(ast::FunctionDef)) {
+            child->accept(*this);
+        } else if (typeid(raw) == typeid(ast::VariableDecl)) {
+            child->accept(*this);
+        }
+    }
+    // 関数本体はmainの呼び出し後に実行されるので、グローバルな宣言が出揃ってから解決する
+    for (const auto* function : pending_functions_) {
+        resolve_function_body_(function);
+    }
+    pending_functions_.clear();
+}
+void Resolver::visit(const ast::FunctionDef* node) {
+    // 関数の再定義は同じ変数への上書きとして扱う
+    node->bind_slot(declare_global(node->info().name().source_id()));
+    pending_functions_.push_back(node);
+}
+void Resolver::resolve_function_body_(const ast::FunctionDef* node) {
+    // 引数のスコープの親はグローバルスコープ
+    scopes_.emplace_back();
+    std::vector<Slot> arg_slots;
+    for (const auto& arginfo : node->info().args()) {
+        arg_slots.push_back(declare_(arginfo.name().source_id()));
+    }
+    node->bind_arg_slots(std::move(arg_slots));
+    node->bind_arg_frame_size(scopes_.back().next_slot);
+    node->block()->accept(*this);
+    scopes_.pop_back();
+}
+void Resolver::visit(const ast::VariableDeclStatement* node) {
+    for (const auto& child : node->children()) {
+        child->accept(*this);
+    }
+}
+void Resolver::visit(const ast::ReturnStatement* node) { node->retval()->accept(*this); }
+void Resolver::visit(const ast::Block* node) {
+    scopes_.emplace_back();
+    for (const auto& sentence : node->sentences()) {
+        sentence->accept(*this);
+    }
+    node->bind_frame_size(scopes_.back().next_slot);
+    scopes_.pop_back();
+}
+void Resolver::visit(const ast::LoopStatement* node) { node->block()->accept(*this); }
+void Resolver::visit(const ast::WhileStatement* node) {
+    node->cond()->accept(*this);
+    node->block()->accept(*this);
+}
+void Resolver::visit(const ast::DoWhileStatement* node) {
+    node->block()->accept(*this);
+    node->cond()->accept(*this);
+}
+void Resolver::visit(const ast::ForStatement* node) {
+    scopes_.emplace_back();
+    for (const auto& child : node->children()) {
+        child->accept(*this);
+    }
+    node->bind_frame_size(scopes_.back().next_slot);
+    scopes_.pop_back();
+}
+void Resolver::visit(const ast::BreakStatement*) {}
+void Resolver::visit(const ast::IfStatement* node) {
+    for (const auto& [cond, block] : node->cond_blocks()) {
+        if (cond.use_count() != 0) {
+            cond->accept(*this);
+        }
+        block->accept(*this);
+    }
+}
+void Resolver::visit(const ast::AssertStatement* node) {
+    node->cond()->accept(*this);
+    if (node->msg().has_value()) {
+        node->msg().value()->accept(*this);
+    }
+}
+}  // namespace Garnet::interpreter
@@ -0,0 +1,69 @@
+#ifndef GARNET_INTERPRETER_RESOLVER
+#define GARNET_INTERPRETER_RESOLVER
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "flyweight.hpp"
+#include "visitor/visitor.hpp"
+namespace Garnet::interpreter {
+// 実行前にASTをたどり、各変数参照を(スコープの深さ, スコープ内の番号)に束縛する
+// スコープの入れ子はInterpreterの実行時のScopeと一致させる
+// 未定義の名前や再宣言は報告せず、実行時にその箇所へ到達したときにInterpreterが報告する
+class Resolver : public ast::Visitor {
+    using NameType = SimpleFlyWeight::id_type;
+    using Slot = std::uint32_t;
+
+    struct Scope {
+        std::unordered_map<NameType, Slot> names;
+        Slot next_slot = 0;
+    };
+    std::vector<Scope> scopes_;
+    std::vector<const ast::FunctionDef*> pending_functions_;
+    std::uint32_t call_sites_ = 0;
+
+    // 同じスコープで宣言済みの名前なら既存の番号を返す
+    Slot declare_(NameType name);
+    void resolve_function_body_(const ast::FunctionDef* node);
+
+   public:
+    Resolver();
+    // 組み込み関数などのグローバルな名前を、CompilationUnitより先に宣言する
+    Slot declare_global(NameType name);
+    Slot global_frame_size() const { return scopes_.front().next_slot; }
+    // グローバル変数を直接呼び出す箇所の数
+    std::uint32_t call_site_count() const { return call_sites_; }
+
+    virtual void visit(const ast::VariableDecl*) override;
+    virtual void visit(const ast::TypeDecl*) override;
+    virtual void visit(const ast::ErrorNode*) override;
+    virtual void visit(const ast::ErrorSentence*) override;
+    virtual void visit(const ast::ErrorExpression*) override;
+    virtual void visit(const ast::ErrorStatement*) override;
+    virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
+    virtual void visit(const ast::UnaryOperator*) override;
+    virtual void visit(const ast::VariableReference*) override;
+    virtual void visit(const ast::SignedIntegerLiteral*) override;
+    virtual void visit(const ast::UnsignedIntegerLiteral*) override;
+    virtual void visit(const ast::FloatingPointLiteral*) override;
+    virtual void visit(const ast::StringLiteral*) override;
+    virtual void visit(const ast::FunctionCall*) override;
+    virtual void visit(const ast::CompilationUnit*) override;
+    virtual void visit(const ast::FunctionDef*) override;
+    virtual void visit(const ast::VariableDeclStatement*) override;
+    virtual void visit(const ast::ReturnStatement*) override;
+    virtual void visit(const ast::Block*) override;
+    virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
+    virtual void visit(const ast::BreakStatement*) override;
+    virtual void visit(const ast::IfStatement*) override;
+    virtual void visit(const ast::AssertStatement*) override;
+    virtual void visit(const ast::BooleanLiteral*) override;
+    virtual void visit(const ast::NilLiteral*) override;
+};
+}  // namespace Garnet::interpreter
+#endif
@@ -0,0 +1,442 @@
+#ifndef GARNET_INTERPRETER_SEMANTICS
+#define GARNET_INTERPRETER_SEMANTICS
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <magic_enum.hpp>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "concrete_expressions.hpp"
+#include "shared_string.hpp"
+namespace Garnet::interpreter::semantics {
+// 実行エンジン(tree-walking interpreter と bytecode VM)で共有する演算の意味論
+// 値の表現には依存せず、C++の型だけで適用可否と結果を決める
+
+template <typename From, typename To>
+concept StaticConvertible = requires(From a, To b) {
+    { static_cast<To>(a) } -> std::convertible_to<To>;
+};
+template <typename T, typename U>
+concept LessComparable = requires(T a, U b) {
+    { a < b } -> std::convertible_to<bool>;
+};
+template <typename T, typename U>
+concept LessEqualComparable = requires(T a, U b) {
+    { a <= b } -> std::convertible_to<bool>;
+};
+template <typename T, typename U>
+concept GreaterComparable = requires(T a, U b) {
+    { a > b } -> std::convertible_to<bool>;
+};
+template <typename T, typename U>
+concept GreaterEqualComparable = requires(T a, U b) {
+    { a >= b } -> std::convertible_to<bool>;
+};
+template <typename T, typename U>
+concept EqualComparable = requires(T a, U b) {
+    { a == b } -> std::convertible_to<bool>;
+};
+template <typename T, typename U>
+concept NotEqualComparable = requires(T a, U b) {
+    { a != b } -> std::convertible_to<bool>;
+};
+template <typename T, typename U>
+concept SignednessMatch =
+    (std::signed_integral<T> && std::signed_integral<U>) || (std::unsigned_integral<T> && std::unsigned_integral<U>);
+template <typename T, typename U>
+concept BothFloat = (std::is_floating_point_v<T> && std::is_floating_point_v<U>);
+template <typename T, typename U>
+concept StrictComparable = BothFloat<T, U> || SignednessMatch<T, U>;
+
+// 演算が定義されていない組み合わせに対する結果型
+struct Inapplicable {};
+
+using BinaryOp = ast::BinaryOperator::OperatorType;
+using UnaryOp = ast::UnaryOperator::OperatorType;
+
+// シフト量は、左辺を汎整数拡張した型のビット幅で剰余を取る(x86-64のシフト命令と同じ)
+// 負の量や幅以上の量でも未定義動作にならず、どの実行エンジンでも同じ結果になる
+template <typename LeftType, typename RightType>
+constexpr int shift_count(RightType right) {
+    using Promoted = decltype(+std::declval<LeftType>());
+    constexpr std::uint64_t width = std::numeric_limits<std::make_unsigned_t<Promoted>>::digits;
+    return static_cast<int>(static_cast<std::uint64_t>(right) & (width - 1));
+}
+
+template <BinaryOp op, typename LeftType, typename RightType>
+constexpr auto apply_binary(LeftType left, RightType right) {
+    using enum ast::BinaryOperator::OperatorType;
+    using Left = std::numeric_limits<LeftType>;
+    using Right = std::numeric_limits<RightType>;
+    if constexpr (op == ADD || op == SUB || op == MUL) {
+        auto calc = [](auto a, auto b) {
+            if constexpr (op == ADD) {
+                return a + b;
+            } else if constexpr (op == SUB) {
+                return a - b;
+            } else {
+                return a * b;
+            }
+        };
+        if constexpr (Left::is_specialized && Right::is_specialized) {
+            if constexpr (Left::is_integer && (not Right::is_integer)) {
+                return static_cast<RightType>(calc(static_cast<RightType>(left), right));
+            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
+                return static_cast<LeftType>(calc(left, static_cast<LeftType>(right)));
+            } else if constexpr (Left::digits >= Right::digits) {
+                return static_cast<LeftType>(calc(left, static_cast<LeftType>(right)));
+            } else {
+                return static_cast<RightType>(calc(static_cast<RightType>(left), right));
+            }
+        } else if constexpr (op == ADD && std::is_same_v<LeftType, SharedString> &&
+                             std::is_same_v<RightType, SharedString>) {
+            return SharedString(left + right);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == DIV) {
+        if constexpr (Left::is_specialized && Right::is_specialized) {
+            if constexpr (Left::is_integer && Right::is_integer) {
+                return static_cast<double>(static_cast<double>(left) / static_cast<double>(right));
+            } else if constexpr (Left::is_integer && (not Right::is_integer)) {
+                return static_cast<RightType>(static_cast<RightType>(left) / right);
+            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
+                return static_cast<LeftType>(left / static_cast<LeftType>(right));
+            } else if constexpr (Left::digits >= Right::digits) {
+                return static_cast<LeftType>(left / static_cast<LeftType>(right));
+            } else {
+                return static_cast<RightType>(static_cast<RightType>(left) / right);
+            }
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == MOD) {
+        if constexpr (Left::is_specialized && Right::is_specialized) {
+            if constexpr (Left::is_integer && (not Right::is_integer)) {
+                return static_cast<RightType>(std::fmod(static_cast<RightType>(left), right));
+            } else if constexpr ((not Left::is_integer) && Right::is_integer) {
+                return static_cast<LeftType>(std::fmod(left, static_cast<LeftType>(right)));
+            } else if constexpr (Left::is_integer && Right::is_integer) {
+                if constexpr (Left::digits >= Right::digits) {
+                    return static_cast<LeftType>(left % static_cast<LeftType>(right));
+                } else {
+                    return static_cast<RightType>(static_cast<RightType>(left) % right);
+                }
+            } else if constexpr (Left::digits >= Right::digits) {
+                return static_cast<LeftType>(std::fmod(left, static_cast<LeftType>(right)));
+            } else {
+                return static_cast<RightType>(std::fmod(static_cast<RightType>(left), right));
+            }
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == LESS) {
+        if constexpr (LessComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
+            return static_cast<bool>(left < right);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == LESS_EQUAL) {
+        if constexpr (LessEqualComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
+            return static_cast<bool>(left <= right);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == GREATER) {
+        if constexpr (GreaterComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
+            return static_cast<bool>(left > right);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == GREATER_EQUAL) {
+        if constexpr (GreaterEqualComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
+            return static_cast<bool>(left >= right);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == EQUAL) {
+        if constexpr (EqualComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
+            return static_cast<bool>(left == right);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == NOT_EQUAL) {
+        if constexpr (NotEqualComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
+            return static_cast<bool>(left != right);
+        } else if constexpr (EqualComparable<LeftType, RightType> && StrictComparable<LeftType, RightType>) {
+            return static_cast<bool>(not(left == right));
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == BIT_AND || op == BIT_OR || op == BIT_XOR) {
+        auto calc = [](auto a, auto b) {
+            if constexpr (op == BIT_AND) {
+                return a & b;
+            } else if constexpr (op == BIT_OR) {
+                return a | b;
+            } else {
+                return a ^ b;
+            }
+        };
+        if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
+            if constexpr (Left::digits > Right::digits) {
+                return static_cast<LeftType>(calc(left, static_cast<LeftType>(right)));
+            } else {
+                return static_cast<RightType>(calc(static_cast<RightType>(left), right));
+            }
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == LEFT_SHIFT || op == RIGHT_SHIFT) {
+        if constexpr (std::is_integral_v<LeftType> && std::is_integral_v<RightType>) {
+            if constexpr (op == LEFT_SHIFT) {
+                return static_cast<LeftType>(left << shift_count<LeftType>(right));
+            } else {
+                return static_cast<LeftType>(left >> shift_count<LeftType>(right));
+            }
+        } else {
+            return Inapplicable{};
+        }
+    } else {
+        // ASSIGNは左辺値を必要とするので、各実行エンジンが個別に扱う
+        return Inapplicable{};
+    }
+}
+
+template <UnaryOp op, typename OperandType>
+constexpr auto apply_unary(OperandType operand) {
+    using enum ast::UnaryOperator::OperatorType;
+    using Operand = std::numeric_limits<OperandType>;
+    if constexpr (op == PLUS) {
+        if constexpr (Operand::is_specialized) {
+            return static_cast<OperandType>(+operand);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == MINUS) {
+        if constexpr (Operand::is_specialized) {
+            return static_cast<OperandType>(-operand);
+        } else {
+            return Inapplicable{};
+        }
+    } else if constexpr (op == BOOL_NOT) {
+        if constexpr (std::is_same_v<OperandType, bool>) {
+            return static_cast<bool>(not operand);
+        } else {
+            return Inapplicable{};
+        }
+    } else {
+        if constexpr (Operand::is_specialized && Operand::is_integer) {
+            if constexpr (not std::is_same_v<OperandType, bool>) {
+                return static_cast<OperandType>(~operand);
+            } else {
+                return static_cast<bool>(!operand);
+            }
+        } else {
+            return Inapplicable{};
+        }
+    }
+}
+
+template <BinaryOp op, typename LeftType, typename RightType>
+using binary_result_t = decltype(apply_binary<op>(std::declval<LeftType>(), std::declval<RightType>()));
+template <BinaryOp op, typename LeftType, typename RightType>
+constexpr bool is_binary_applicable_v = not std::is_same_v<binary_result_t<op, LeftType, RightType>, Inapplicable>;
+
+template <UnaryOp op, typename OperandType>
+using unary_result_t = decltype(apply_unary<op>(std::declval<OperandType>()));
+template <UnaryOp op, typename OperandType>
+constexpr bool is_unary_applicable_v = not std::is_same_v<unary_result_t<op, OperandType>, Inapplicable>;
+
+// (演算子, 左辺の型, 右辺の型)ごとの処理関数の表
+// Valueはstd::variantで、alternativeの番号を型の番号として使う
+// 表はコンパイル時に作られ、評価は表引き一回と間接呼び出し一回で済む
+template <typename Value>
+class BinaryDispatchTable {
+   public:
+    using Handler = Value (*)(const Value&, const Value&);
+    static constexpr std::size_t TYPE_COUNT = std::variant_size_v<Value>;
+    static constexpr std::size_t OP_COUNT = magic_enum::enum_count<BinaryOp>();
+
+    // 適用できない組み合わせならnullptr
+    static Handler find(BinaryOp op, std::size_t left, std::size_t right) {
+        return table_[static_cast<std::size_t>(op)][left * TYPE_COUNT + right];
+    }
+
+   private:
+    using OpTable = std::array<Handler, TYPE_COUNT * TYPE_COUNT>;
+
+    template <BinaryOp op, std::size_t L, std::size_t R>
+    static Value handler_(const Value& left, const Value& right) {
+        return apply_binary<op>(*std::get_if<L>(&left), *std::get_if<R>(&right));
+    }
+    template <BinaryOp op, std::size_t I>
+    static constexpr Handler entry_() {
+        constexpr std::size_t L = I / TYPE_COUNT, R = I % TYPE_COUNT;
+        if constexpr (is_binary_applicable_v<op, std::variant_alternative_t<L, Value>,
+                                             std::variant_alternative_t<R, Value>>) {
+            return &handler_<op, L, R>;
+        } else {
+            return nullptr;
+        }
+    }
+    template <BinaryOp op, std::size_t... I>
+    static constexpr OpTable make_op_table_(std::index_sequence<I...>) {
+        return {entry_<op, I>()...};
+    }
+    template <std::size_t... O>
+    static constexpr auto make_table_(std::index_sequence<O...>) {
+        static_assert(((static_cast<std::size_t>(magic_enum::enum_value<BinaryOp>(O)) == O) && ...),
+                      "BinaryOperator::OperatorType must be numbered from 0 without gaps");
+        return std::array<OpTable, OP_COUNT>{
+            make_op_table_<magic_enum::enum_value<BinaryOp>(O)>(std::make_index_sequence<TYPE_COUNT * TYPE_COUNT>())...};
+    }
+    static constexpr auto table_ = make_table_(std::make_index_sequence<OP_COUNT>());
+};
+
+// (演算子, 被演算子の型)ごとの処理関数の表
+template <typename Value>
+class UnaryDispatchTable {
+   public:
+    using Handler = Value (*)(const Value&);
+    static constexpr std::size_t TYPE_COUNT = std::variant_size_v<Value>;
+    static constexpr std::size_t OP_COUNT = magic_enum::enum_count<UnaryOp>();
+
+    // 適用できない組み合わせならnullptr
+    static Handler find(UnaryOp op, std::size_t operand) { return table_[static_cast<std::size_t>(op)][operand]; }
+
+   private:
+    using OpTable = std::array<Handler, TYPE_COUNT>;
+
+    template <UnaryOp op, std::size_t I>
+    static Value handler_(const Value& operand) {
+        return apply_unary<op>(*std::get_if<I>(&operand));
+    }
+    template <UnaryOp op, std::size_t I>
+    static constexpr Handler entry_() {
+        if constexpr (is_unary_applicable_v<op, std::variant_alternative_t<I, Value>>) {
+            return &handler_<op, I>;
+        } else {
+            return nullptr;
+        }
+    }
+    template <UnaryOp op, std::size_t... I>
+    static constexpr OpTable make_op_table_(std::index_sequence<I...>) {
+        return {entry_<op, I>()...};
+    }
+    template <std::size_t... O>
+    static constexpr auto make_table_(std::index_sequence<O...>) {
+        static_assert(((static_cast<std::size_t>(magic_enum::enum_value<UnaryOp>(O)) == O) && ...),
+                      "UnaryOperator::OperatorType must be numbered from 0 without gaps");
+        return std::array<OpTable, OP_COUNT>{
+            make_op_table_<magic_enum::enum_value<UnaryOp>(O)>(std::make_index_sequence<TYPE_COUNT>())...};
+    }
+    static constexpr auto table_ = make_table_(std::make_index_sequence<OP_COUNT>());
+};
+
+// Valueのalternativeのうち、Tの番号
+template <typename T, typename Value>
+constexpr std::size_t variant_index_v = []<std::size_t... I>(std::index_sequence<I...>) {
+    std::size_t result = std::variant_size_v<Value>;
+    ((std::is_same_v<T, std::variant_alternative_t<I, Value>> ? (result = I, true) : false) || ...);
+    return result;
+}(std::make_index_sequence<std::variant_size_v<Value>>());
+
+// 型の番号(Valueのalternativeの番号)だけで、演算や変換の可否と結果の型を引く表
+// 静的な型検査(TypeChecker)が、実行エンジンと同じ規則で型を決めるために使う
+struct TypeRules {
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    std::size_t type_count = 0;
+    std::vector<const std::type_info*> type_infos;
+    // 適用できない組み合わせはNONE
+    std::vector<std::size_t> binary_results;
+    std::vector<std::size_t> unary_results;
+    // [from * type_count + to]
+    std::vector<bool> convertible;
+    std::vector<bool> bool_convertible;
+
+    std::size_t nil;
+    std::size_t boolean;
+    std::size_t i64;
+    std::size_t u64;
+    std::size_t f64;
+    std::size_t string;
+    std::size_t function;
+    // 条件式の参照を値に変換せずに評価する実行エンジンでは、その参照の型
+    const std::type_info* reference = nullptr;
+
+    std::size_t binary_result(BinaryOp op, std::size_t left, std::size_t right) const {
+        return binary_results[(static_cast<std::size_t>(op) * type_count + left) * type_count + right];
+    }
+    std::size_t unary_result(UnaryOp op, std::size_t operand) const {
+        return unary_results[static_cast<std::size_t>(op) * type_count + operand];
+    }
+    bool is_convertible(std::size_t from, std::size_t to) const { return convertible[from * type_count + to]; }
+    const std::type_info& type_info(std::size_t type) const { return *type_infos[type]; }
+};
+
+template <typename Value, typename NilType, typename FunctionReference>
+TypeRules make_type_rules() {
+    constexpr std::size_t N = std::variant_size_v<Value>;
+    TypeRules rules;
+    rules.type_count = N;
+    rules.nil = variant_index_v<NilType, Value>;
+    rules.boolean = variant_index_v<bool, Value>;
+    rules.i64 = variant_index_v<std::int64_t, Value>;
+    rules.u64 = variant_index_v<std::uint64_t, Value>;
+    rules.f64 = variant_index_v<double, Value>;
+    rules.string = variant_index_v<SharedString, Value>;
+    rules.function = variant_index_v<FunctionReference, Value>;
+    auto result_index = []<typename Result>() {
+        if constexpr (std::is_same_v<Result, Inapplicable>) {
+            return TypeRules::NONE;
+        } else if constexpr (variant_index_v<Result, Value> != N) {
+            return variant_index_v<Result, Value>;
+        } else {
+            // 整数の昇格などでalternativeと一致しない結果は、Valueに変換したときの型
+            return Value(Result{}).index();
+        }
+    };
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        rules.type_infos = {&typeid(std::variant_alternative_t<I, Value>)...};
+        rules.bool_convertible = {std::is_convertible_v<std::variant_alternative_t<I, Value>, bool>...};
+    }(std::make_index_sequence<N>());
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        rules.convertible = {StaticConvertible<std::variant_alternative_t<I / N, Value>,
+                                               std::variant_alternative_t<I % N, Value>>...};
+    }(std::make_index_sequence<N * N>());
+    [&]<std::size_t... O>(std::index_sequence<O...>) {
+        (
+            [&]<BinaryOp op>() {
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    (rules.binary_results.push_back(
+                         result_index.template operator()<binary_result_t<op, std::variant_alternative_t<I / N, Value>,
+                                                                          std::variant_alternative_t<I % N, Value>>>()),
+                     ...);
+                }(std::make_index_sequence<N * N>());
+            }.template operator()<magic_enum::enum_value<BinaryOp>(O)>(),
+            ...);
+    }(std::make_index_sequence<magic_enum::enum_count<BinaryOp>()>());
+    [&]<std::size_t... O>(std::index_sequence<O...>) {
+        (
+            [&]<UnaryOp op>() {
+                [&]<std::size_t... I>(std::index_sequence<I...>) {
+                    (rules.unary_results.push_back(
+                         result_index.template operator()<unary_result_t<op, std::variant_alternative_t<I, Value>>>()),
+                     ...);
+                }(std::make_index_sequence<N>());
+            }.template operator()<magic_enum::enum_value<UnaryOp>(O)>(),
+            ...);
+    }(std::make_index_sequence<magic_enum::enum_count<UnaryOp>()>());
+    return rules;
+}
+}  // namespace Garnet::interpreter::semantics
+#endif
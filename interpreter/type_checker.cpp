@@ -0,0 +1,364 @@
+#include "type_checker.hpp"
+
+#include <fmt/core.h>
+#include <fmt/std.h>
+
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "compilation_unit.hpp"
+#include "concrete_decls.hpp"
+#include "concrete_defs.hpp"
+#include "concrete_expressions.hpp"
+#include "concrete_infos.hpp"
+#include "concrete_statements.hpp"
+#include "error_nodes.hpp"
+#include "exceptions.hpp"
+#include "format.hpp"  // NOLINT
+namespace Garnet::interpreter {
+std::size_t TypeChecker::lookup_type_(ast::SourceTypeIdentifier name) const {
+    auto pos = type_indices_.find(name.source_id());
+    if (pos == type_indices_.end()) {
+        return UNKNOWN;
+    }
+    return pos->second;
+}
+std::size_t TypeChecker::result_type_of_(const ast::FunctionDef* node) const {
+    using namespace ast::operators;
+    static const ast::SourceTypeIdentifier void_type{"void"};
+    auto result_type = node->info().result()->type().name();
+    if (result_type == void_type) {
+        return rules_.nil;
+    }
+    return lookup_type_(result_type);
+}
+void TypeChecker::declare_(Scope& scope, Slot slot, StaticType type) {
+    if (scope.size() <= slot) {
+        scope.resize(slot + 1);
+    }
+    // 再宣言(実行時に報告される)や、グローバル変数と関数の名前の衝突では型を決めない
+    if (scope[slot].has_value()) {
+        scope[slot] = StaticType{};
+        return;
+    }
+    scope[slot] = type;
+}
+void TypeChecker::report_(std::string message, location::SourceRegion location) const {
+    if (not dry_run_) {
+        throw TypeError(std::move(message), location);
+    }
+}
+void TypeChecker::check(const ast::CompilationUnit& unit) {
+    for (const auto& child : unit.children()) {
+        if (const auto* function = dynamic_cast<const ast::FunctionDef*>(child.get()); function != nullptr) {
+            global_functions_[function->slot().value()] = function;
+        }
+    }
+    dry_run_ = true;
+    unit.accept(*this);
+    dry_run_ = false;
+    unit.accept(*this);
+}
+void TypeChecker::visit(const ast::VariableDecl* node) {
+    std::size_t init = UNKNOWN;
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+        init = result_.type;
+    }
+    auto& scope = scopes_.back();
+    auto slot = node->slot().value();
+    auto type = lookup_type_(node->type());
+    bool is_redeclared = slot < scope.size() && scope[slot].has_value();
+    // Interpreterは変数宣言の位置を持たないので、位置なしで報告する
+    if (not is_redeclared && init != UNKNOWN && type != UNKNOWN && not rules_.is_convertible(init, type)) {
+        report_(fmt::format("cannot convert {} to {}", rules_.type_info(init), rules_.type_info(type)), {});
+    }
+    declare_(scope, slot, {.type = type});
+}
+void TypeChecker::visit(const ast::TypeDecl*) {}
+void TypeChecker::visit(const ast::ErrorNode*) { result_ = {}; }
+void TypeChecker::visit(const ast::ErrorSentence*) { result_ = {}; }
+void TypeChecker::visit(const ast::ErrorExpression*) { result_ = {}; }
+void TypeChecker::visit(const ast::ErrorStatement*) { result_ = {}; }
+void TypeChecker::visit(const ast::BinaryOperator* node) {
+    node->left()->accept(*this);
+    auto lhs = result_;
+    node->right()->accept(*this);
+    auto rhs = result_;
+    if (not dry_run_) {
+        node->bind_operand_types(std::nullopt);
+    }
+    if (node->op() == ast::BinaryOperator::OperatorType::ASSIGN) {
+        if (lhs.type != UNKNOWN && not lhs.is_lvalue) {
+            report_("cannot assign to rvalue", node->location());
+        }
+        if (lhs.type == rules_.function && lhs.global_slot.has_value()) {
+            reassigned_functions_.insert(*lhs.global_slot);
+        }
+        if (lhs.type != UNKNOWN && rhs.type != UNKNOWN && not rules_.is_convertible(rhs.type, lhs.type)) {
+            report_(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
+                                rules_.type_info(rhs.type), rules_.type_info(lhs.type)),
+                    node->location());
+        }
+        // 代入式の値は右辺の値そのもの
+        result_ = rhs;
+        return;
+    }
+    result_ = {};
+    if (lhs.type == UNKNOWN || rhs.type == UNKNOWN) {
+        return;
+    }
+    auto type = rules_.binary_result(node->op(), lhs.type, rhs.type);
+    if (type == UNKNOWN) {
+        report_(fmt::format("cannot apply {} operator to {} and {}", node->op(), rules_.type_info(lhs.type),
+                            rules_.type_info(rhs.type)),
+                node->location());
+        return;
+    }
+    if (not dry_run_) {
+        node->bind_operand_types(
+            std::array{static_cast<std::uint8_t>(lhs.type), static_cast<std::uint8_t>(rhs.type)});
+    }
+    result_ = {.type = type};
+}
+void TypeChecker::visit(const ast::CompoundAssign* node) {
+    node->target()->accept(*this);
+    auto target = result_;
+    node->value()->accept(*this);
+    auto value = result_;
+    if (not dry_run_) {
+        node->bind_operand_types(std::nullopt);
+    }
+    result_ = {};
+    if (target.type == rules_.function && target.global_slot.has_value()) {
+        reassigned_functions_.insert(*target.global_slot);
+    }
+    if (target.type == UNKNOWN || value.type == UNKNOWN) {
+        return;
+    }
+    auto type = rules_.binary_result(node->op(), target.type, value.type);
+    if (type == UNKNOWN) {
+        report_(fmt::format("cannot apply {} operator to {} and {}", node->op(), rules_.type_info(target.type),
+                            rules_.type_info(value.type)),
+                node->location());
+        return;
+    }
+    if (not target.is_lvalue) {
+        report_("cannot assign to rvalue", node->location());
+    }
+    if (not rules_.is_convertible(type, target.type)) {
+        report_(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}", rules_.type_info(type),
+                            rules_.type_info(target.type)),
+                node->location());
+    }
+    if (not dry_run_) {
+        node->bind_operand_types(
+            std::array{static_cast<std::uint8_t>(target.type), static_cast<std::uint8_t>(value.type)});
+    }
+    // 代入式の値は演算の結果そのもの
+    result_ = {.type = type};
+}
+void TypeChecker::visit(const ast::LogicalOperator* node) {
+    check_bool_(node->left().get());
+    check_bool_(node->right().get());
+    result_ = {.type = rules_.boolean};
+}
+void TypeChecker::visit(const ast::UnaryOperator* node) {
+    node->operand()->accept(*this);
+    auto operand = result_;
+    if (not dry_run_) {
+        node->bind_operand_type(std::nullopt);
+    }
+    result_ = {};
+    if (operand.type == UNKNOWN) {
+        return;
+    }
+    auto type = rules_.unary_result(node->op(), operand.type);
+    if (type == UNKNOWN) {
+        report_(fmt::format("cannot apply {} operator to {}", node->op(), rules_.type_info(operand.type)),
+                node->location());
+        return;
+    }
+    if (not dry_run_) {
+        node->bind_operand_type(static_cast<std::uint8_t>(operand.type));
+    }
+    result_ = {.type = type};
+}
+void TypeChecker::visit(const ast::VariableReference* node) {
+    result_ = {};
+    auto binding = node->binding();
+    if (not binding.has_value()) {
+        return;
+    }
+    auto scope_index = scopes_.size() - 1 - binding->depth;
+    const auto& scope = scopes_[scope_index];
+    if (binding->slot >= scope.size() || not scope[binding->slot].has_value()) {
+        return;
+    }
+    result_ = *scope[binding->slot];
+    result_.is_lvalue = true;
+    if (scope_index == 0) {
+        result_.global_slot = binding->slot;
+    }
+}
+void TypeChecker::visit(const ast::SignedIntegerLiteral*) { result_ = {.type = rules_.i64}; }
+void TypeChecker::visit(const ast::UnsignedIntegerLiteral*) { result_ = {.type = rules_.u64}; }
+void TypeChecker::visit(const ast::FloatingPointLiteral*) { result_ = {.type = rules_.f64}; }
+void TypeChecker::visit(const ast::StringLiteral*) { result_ = {.type = rules_.string}; }
+void TypeChecker::visit(const ast::BooleanLiteral*) { result_ = {.type = rules_.boolean}; }
+void TypeChecker::visit(const ast::NilLiteral*) { result_ = {.type = rules_.nil}; }
+void TypeChecker::visit(const ast::FunctionCall* node) {
+    node->callee()->accept(*this);
+    auto callee = result_;
+    if (callee.type != UNKNOWN && callee.type != rules_.function) {
+        report_(fmt::format("{} cannot be called", rules_.type_info(callee.type)), node->location());
+        callee = {};
+    }
+    const ast::FunctionDef* function = callee.type == rules_.function ? callee.function : nullptr;
+    std::vector<ast::VariableInfo> arginfos;
+    if (function != nullptr) {
+        arginfos = function->info().args();
+    }
+    const auto args = node->args();
+    for (std::size_t i = 0; i < args.size(); i++) {
+        args[i]->accept(*this);
+        if (i >= arginfos.size()) {
+            continue;
+        }
+        const auto& arginfo = arginfos[i];
+        auto type = lookup_type_(arginfo.type().name());
+        if (result_.type != UNKNOWN && type != UNKNOWN && not rules_.is_convertible(result_.type, type)) {
+            report_(fmt::format("cannot convert {} to {}", rules_.type_info(result_.type), rules_.type_info(type)),
+                    arginfo.location());
+        }
+    }
+    if (callee.type == rules_.function && callee.is_builtin) {
+        result_ = {.type = rules_.nil};
+    } else if (function != nullptr) {
+        result_ = {.type = result_type_of_(function)};
+    } else {
+        result_ = {};
+    }
+}
+void TypeChecker::visit(const ast::CompilationUnit* node) {
+    scopes_.assign(1, {});
+    for (auto slot : builtins_) {
+        declare_(scopes_.front(), slot, {.type = rules_.function, .is_builtin = true});
+    }
+    for (const auto& child : node->children()) {
+        const auto& raw = *child;
+        if (typeid(raw) == typeid(ast::FunctionDef)) {
+            child->accept(*this);
+        } else if (typeid(raw) == typeid(ast::VariableDecl)) {
+            child->accept(*this);
+        }
+    }
+    // 関数本体はmainの呼び出し後に実行されるので、グローバルな宣言が出揃ってから検査する
+    for (const auto* function : pending_functions_) {
+        check_function_body_(function);
+    }
+    pending_functions_.clear();
+}
+void TypeChecker::visit(const ast::FunctionDef* node) {
+    auto slot = node->slot().value();
+    auto& global = scopes_.front();
+    pending_functions_.push_back(node);
+    // 関数の再定義と、組み込み関数の上書きは許される
+    if (slot < global.size() && global[slot].has_value() && global[slot]->type == rules_.function) {
+        global[slot].reset();
+    }
+    const ast::FunctionDef* function = reassigned_functions_.contains(slot) ? nullptr : global_functions_.at(slot);
+    declare_(global, slot, {.type = rules_.function, .function = function});
+}
+void TypeChecker::check_function_body_(const ast::FunctionDef* node) {
+    // 引数のスコープの親はグローバルスコープ
+    scopes_.emplace_back();
+    const auto args = node->info().args();
+    for (std::size_t i = 0; i < args.size(); i++) {
+        declare_(scopes_.back(), node->arg_slots()[i], {.type = lookup_type_(args[i].type().name())});
+    }
+    return_type_ = result_type_of_(node);
+    node->block()->accept(*this);
+    return_type_ = UNKNOWN;
+    scopes_.pop_back();
+}
+void TypeChecker::visit(const ast::VariableDeclStatement* node) {
+    for (const auto& child : node->children()) {
+        child->accept(*this);
+    }
+}
+void TypeChecker::visit(const ast::ReturnStatement* node) {
+    node->retval()->accept(*this);
+    if (result_.type != UNKNOWN && return_type_ != UNKNOWN && not rules_.is_convertible(result_.type, return_type_)) {
+        report_(fmt::format("cannot ASSIGN a value with type {} into a variable with type {}",
+                            rules_.type_info(result_.type), rules_.type_info(return_type_)),
+                node->location());
+    }
+}
+void TypeChecker::visit(const ast::Block* node) {
+    scopes_.emplace_back();
+    for (const auto& sentence : node->sentences()) {
+        sentence->accept(*this);
+    }
+    scopes_.pop_back();
+}
+void TypeChecker::visit(const ast::LoopStatement* node) { node->block()->accept(*this); }
+void TypeChecker::check_bool_(const ast::Expression* expr) {
+    expr->accept(*this);
+    // ループの条件式やand/orの被演算子は、変数を値に変換してから真偽を問う
+    if (result_.type != UNKNOWN && result_.type != rules_.boolean) {
+        report_(fmt::format("{} is not bool", rules_.type_info(result_.type)), expr->location());
+    }
+}
+void TypeChecker::visit(const ast::WhileStatement* node) {
+    check_bool_(node->cond().get());
+    node->block()->accept(*this);
+}
+void TypeChecker::visit(const ast::DoWhileStatement* node) {
+    node->block()->accept(*this);
+    check_bool_(node->cond().get());
+}
+void TypeChecker::visit(const ast::ForStatement* node) {
+    scopes_.emplace_back();
+    if (node->init().has_value()) {
+        node->init().value()->accept(*this);
+    }
+    if (node->cond().has_value()) {
+        check_bool_(node->cond().value().get());
+    }
+    if (node->update().has_value()) {
+        node->update().value()->accept(*this);
+    }
+    node->block()->accept(*this);
+    scopes_.pop_back();
+}
+void TypeChecker::visit(const ast::BreakStatement*) {}
+void TypeChecker::visit(const ast::IfStatement* node) {
+    for (const auto& [cond, block] : node->cond_blocks()) {
+        if (cond.use_count() != 0) {
+            cond->accept(*this);
+            // 実行エンジンによっては、条件式の変数を値に変換せずに真偽を問う
+            if (result_.is_lvalue && rules_.reference != nullptr) {
+                report_(fmt::format("{} cannot be converted to bool", *rules_.reference), cond->location());
+            } else if (result_.type != UNKNOWN && not rules_.bool_convertible[result_.type]) {
+                report_(fmt::format("{} cannot be converted to bool", rules_.type_info(result_.type)),
+                        cond->location());
+            }
+        }
+        block->accept(*this);
+    }
+}
+void TypeChecker::visit(const ast::AssertStatement* node) {
+    node->cond()->accept(*this);
+    auto cond_loc = node->cond()->location();
+    if (result_.is_lvalue && rules_.reference != nullptr) {
+        report_(fmt::format("{} is not bool", *rules_.reference), cond_loc);
+    } else if (result_.type != UNKNOWN && result_.type != rules_.boolean) {
+        report_(fmt::format("{} is not bool", rules_.type_info(result_.type)), cond_loc);
+    }
+    if (node->msg().has_value()) {
+        node->msg().value()->accept(*this);
+    }
+}
+}  // namespace Garnet::interpreter
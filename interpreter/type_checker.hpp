@@ -0,0 +1,101 @@
+#ifndef GARNET_INTERPRETER_TYPE_CHECKER
+#define GARNET_INTERPRETER_TYPE_CHECKER
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "concrete_source_identifiers.hpp"
+#include "flyweight.hpp"
+#include "location.hpp"
+#include "semantics.hpp"
+#include "visitor/visitor.hpp"
+namespace Garnet::interpreter {
+// 実行前にASTをたどり、各式の型を静的に決めて、型の誤りを実行前に報告する
+// 型の決まった演算子には被演算子の型を書き込み、実行時の型の振り分けを省けるようにする
+// Resolverの結果(変数の束縛と番号)を使うので、Resolverの後に実行すること
+// 未定義の名前や再宣言、引数の不足は報告せず、それらに関わる式の型は不明として扱う
+class TypeChecker : public ast::Visitor {
+    using Slot = std::uint32_t;
+    using TypeKey = SimpleFlyWeight::id_type;
+    static constexpr std::size_t UNKNOWN = semantics::TypeRules::NONE;
+
+    struct StaticType {
+        std::size_t type = UNKNOWN;
+        // 関数の型の値が指す関数。組み込み関数や、再代入されて決まらない場合はnullptr
+        const ast::FunctionDef* function = nullptr;
+        bool is_builtin = false;
+        // 変数を指す式(ASSIGNの左辺になれる)
+        bool is_lvalue = false;
+        // グローバル変数を指す場合、その番号
+        std::optional<Slot> global_slot = std::nullopt;
+    };
+    using Scope = std::vector<std::optional<StaticType>>;
+
+    const semantics::TypeRules& rules_;
+    const std::unordered_map<TypeKey, std::size_t>& type_indices_;
+
+    std::vector<Scope> scopes_;
+    std::vector<Slot> builtins_;
+    StaticType result_;
+    std::size_t return_type_ = UNKNOWN;
+    std::vector<const ast::FunctionDef*> pending_functions_;
+
+    // 関数の再定義は最後の定義が有効になる
+    std::unordered_map<Slot, const ast::FunctionDef*> global_functions_;
+    // ASSIGNで別の関数が代入されうるグローバル変数
+    std::unordered_set<Slot> reassigned_functions_;
+    // 一度目の走査では報告も書き込みもせず、再代入される関数だけを集める
+    bool dry_run_ = false;
+
+    std::size_t lookup_type_(ast::SourceTypeIdentifier name) const;
+    std::size_t result_type_of_(const ast::FunctionDef* node) const;
+    void declare_(Scope& scope, Slot slot, StaticType type);
+    void report_(std::string message, location::SourceRegion location) const;
+    void check_function_body_(const ast::FunctionDef* node);
+    void check_bool_(const ast::Expression* expr);
+
+   public:
+    TypeChecker(const semantics::TypeRules& rules, const std::unordered_map<TypeKey, std::size_t>& type_indices)
+        : rules_(rules), type_indices_(type_indices) {}
+    // 組み込み関数のグローバルな番号を、check()より先に登録する
+    void declare_builtin(Slot slot) { builtins_.push_back(slot); }
+    // 型の誤りがあればTypeErrorを投げる
+    void check(const ast::CompilationUnit& unit);
+
+    virtual void visit(const ast::VariableDecl*) override;
+    virtual void visit(const ast::TypeDecl*) override;
+    virtual void visit(const ast::ErrorNode*) override;
+    virtual void visit(const ast::ErrorSentence*) override;
+    virtual void visit(const ast::ErrorExpression*) override;
+    virtual void visit(const ast::ErrorStatement*) override;
+    virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
+    virtual void visit(const ast::UnaryOperator*) override;
+    virtual void visit(const ast::VariableReference*) override;
+    virtual void visit(const ast::SignedIntegerLiteral*) override;
+    virtual void visit(const ast::UnsignedIntegerLiteral*) override;
+    virtual void visit(const ast::FloatingPointLiteral*) override;
+    virtual void visit(const ast::StringLiteral*) override;
+    virtual void visit(const ast::FunctionCall*) override;
+    virtual void visit(const ast::CompilationUnit*) override;
+    virtual void visit(const ast::FunctionDef*) override;
+    virtual void visit(const ast::VariableDeclStatement*) override;
+    virtual void visit(const ast::ReturnStatement*) override;
+    virtual void visit(const ast::Block*) override;
+    virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
+    virtual void visit(const ast::BreakStatement*) override;
+    virtual void visit(const ast::IfStatement*) override;
+    virtual void visit(const ast::AssertStatement*) override;
+    virtual void visit(const ast::BooleanLiteral*) override;
+    virtual void visit(const ast::NilLiteral*) override;
+};
+}  // namespace Garnet::interpreter
+#endif
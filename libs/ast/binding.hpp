@@ -0,0 +1,18 @@
+#ifndef GARNET_LIBS_AST_BINDING
+#define GARNET_LIBS_AST_BINDING
+#include <cstdint>
+namespace Garnet::ast {
+// 名前解決の結果
+// 参照しているスコープから宣言したスコープまで親を何段たどるか(depth)と、そのスコープ内での番号(slot)
+struct VariableBinding {
+    std::uint32_t depth;
+    std::uint32_t slot;
+};
+// 呼び出し先がグローバル変数を直接指す関数呼び出しの、名前解決の結果
+// siteは呼び出し箇所の通し番号で、実行エンジンが呼び出し箇所ごとの情報を置くのに使う
+struct CallSiteBinding {
+    std::uint32_t site;
+    std::uint32_t slot;
+};
+}  // namespace Garnet::ast
+#endif
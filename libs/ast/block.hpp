@@ -1,5 +1,6 @@
 #ifndef GARNET_LIBS_AST_BLOCK
 #define GARNET_LIBS_AST_BLOCK
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -19,8 +20,13 @@ class Block : public Statement {
     void add_sentences(std::vector<std::shared_ptr<Sentence>>&& sentences);
     const std::vector<std::shared_ptr<Sentence>>& sentences() const { return sentences_; };
 
+    // このブロックのスコープで宣言される変数の数。名前解決の結果
+    std::uint32_t frame_size() const { return frame_size_; }
+    void bind_frame_size(std::uint32_t size) const { frame_size_ = size; }
+
    private:
     std::vector<std::shared_ptr<Sentence>> sentences_;
+    mutable std::uint32_t frame_size_ = 0;
 };
 }  // namespace Garnet::ast
 #endif
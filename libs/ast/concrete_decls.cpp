@@ -9,15 +9,16 @@
 namespace Garnet::ast {
 
 VariableDecl::VariableDecl(SourceVariableIdentifier name, SourceTypeIdentifier type,
-                           std::optional<std::shared_ptr<Expression>> init, location::SourceRegion location)
-    : DeclBase(location), name_(name), type_(type), init_(init) {}
+                           std::optional<std::shared_ptr<Expression>> init, location::SourceRegion location,
+                           bool is_const)
+    : DeclBase(location), name_(name), type_(type), init_(init), is_const_(is_const) {}
 std::vector<std::shared_ptr<Base>> VariableDecl::children() const { return {}; }
-std::string VariableDecl::mangled_name() {
+std::string VariableDecl::mangled_name() const {
     return fmt::format("_V{}{}_T{}{}", name_.length(), name_, type_.length(), type_);
 }
 
 TypeDecl::TypeDecl(SourceTypeIdentifier name, location::SourceRegion location) : DeclBase(location), name_(name) {}
 std::vector<std::shared_ptr<Base>> TypeDecl::children() const { return {}; }
-std::string TypeDecl::mangled_name() { return fmt::format("_T{}{}", name_.length(), name_); }
+std::string TypeDecl::mangled_name() const { return fmt::format("_T{}{}", name_.length(), name_); }
 
 }  // namespace Garnet::ast
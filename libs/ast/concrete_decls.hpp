@@ -1,5 +1,6 @@
 #ifndef GARNET_LIBS_AST_CONCRETE_DECLS
 #define GARNET_LIBS_AST_CONCRETE_DECLS
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -13,24 +14,33 @@ class Sentence;
 class VariableDecl : public DeclBase {
    public:
     VariableDecl(SourceVariableIdentifier name, SourceTypeIdentifier type,
-                 std::optional<std::shared_ptr<Expression>> init = std::nullopt, location::SourceRegion location = {});
+                 std::optional<std::shared_ptr<Expression>> init = std::nullopt, location::SourceRegion location = {},
+                 bool is_const = false);
     virtual std::vector<std::shared_ptr<Base>> children() const override;
-    std::string mangled_name();
+    std::string mangled_name() const;
     SourceVariableIdentifier name() const { return name_; }
     SourceTypeIdentifier type() const { return type_; }
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
     std::optional<std::shared_ptr<Expression>> init() const { return init_; };
+    // letで宣言されたか(varならfalse)
+    bool is_const() const { return is_const_; }
+
+    // 宣言されるスコープ内での番号。名前解決の結果
+    std::optional<std::uint32_t> slot() const { return slot_; }
+    void bind_slot(std::uint32_t slot) const { slot_ = slot; }
 
    protected:
     SourceVariableIdentifier name_;
     SourceTypeIdentifier type_;
     std::optional<std::shared_ptr<Expression>> init_;
+    bool is_const_;
+    mutable std::optional<std::uint32_t> slot_;
 };
 class TypeDecl : public DeclBase {
    public:
     TypeDecl(SourceTypeIdentifier name, location::SourceRegion location = {});
     virtual std::vector<std::shared_ptr<Base>> children() const override;
-    std::string mangled_name();
+    std::string mangled_name() const;
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
     SourceTypeIdentifier name() const { return name_; }
 
@@ -1,6 +1,9 @@
 #ifndef GARNET_COMPILER_LIBS_AST_CONCRETE_DEFS
 #define GARNET_COMPILER_LIBS_AST_CONCRETE_DEFS
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "block.hpp"
@@ -17,9 +20,21 @@ class FunctionDef : public DefBase {
     std::shared_ptr<Block> block() const { return block_; }
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
 
+    // 名前解決の結果。関数名のグローバルスコープ内での番号と、各引数の引数スコープ内での番号
+    std::optional<std::uint32_t> slot() const { return slot_; }
+    void bind_slot(std::uint32_t slot) const { slot_ = slot; }
+    const std::vector<std::uint32_t>& arg_slots() const { return arg_slots_; }
+    void bind_arg_slots(std::vector<std::uint32_t> slots) const { arg_slots_ = std::move(slots); }
+    // 引数のスコープで宣言される変数の数
+    std::uint32_t arg_frame_size() const { return arg_frame_size_; }
+    void bind_arg_frame_size(std::uint32_t size) const { arg_frame_size_ = size; }
+
    private:
     FunctionInfo info_;
     std::shared_ptr<Block> block_;
+    mutable std::optional<std::uint32_t> slot_;
+    mutable std::vector<std::uint32_t> arg_slots_;
+    mutable std::uint32_t arg_frame_size_ = 0;
 };
 }  // namespace Garnet::ast
 #endif
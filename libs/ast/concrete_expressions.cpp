@@ -4,6 +4,8 @@
 
 namespace Garnet::ast {
 std::vector<std::shared_ptr<Base>> BinaryOperator::children() const { return {left_, right_}; }
+std::vector<std::shared_ptr<Base>> CompoundAssign::children() const { return {target_, value_}; }
+std::vector<std::shared_ptr<Base>> LogicalOperator::children() const { return {left_, right_}; }
 std::vector<std::shared_ptr<Base>> UnaryOperator::children() const { return {operand_}; }
 std::vector<std::shared_ptr<Base>> VariableReference::children() const { return {}; }
 std::vector<std::shared_ptr<Base>> SignedIntegerLiteral::children() const { return {}; }
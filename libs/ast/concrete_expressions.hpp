@@ -1,11 +1,15 @@
 #ifndef GARNET_LIBS_AST_CONCRETE_EXPRESSIONS
 #define GARNET_LIBS_AST_CONCRETE_EXPRESSIONS
 
+#include <array>
+#include <cstdint>
 #include <magic_enum.hpp>
 #include <magic_enum_format.hpp>
 #include <memory>
+#include <optional>
 #include <vector>
 
+#include "binding.hpp"
 #include "concrete_source_identifiers.hpp"
 #include "enums.hpp"
 #include "expression.hpp"
@@ -24,9 +28,7 @@ class BinaryOperator : public Expression {
         LESS_EQUAL,
         GREATER_EQUAL,
         EQUAL,
-        BOOL_AND,
         BIT_AND,
-        BOOL_OR,
         BIT_OR,
         BIT_XOR,
         NOT_EQUAL,
@@ -42,6 +44,55 @@ class BinaryOperator : public Expression {
     const std::shared_ptr<Expression> right() const { return right_; }
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
 
+    // 型検査で静的に決まった左右の被演算子の型(実行エンジンの値の型番号)。決まらなければnullopt
+    std::optional<std::array<std::uint8_t, 2>> operand_types() const { return operand_types_; }
+    void bind_operand_types(std::optional<std::array<std::uint8_t, 2>> types) const { operand_types_ = types; }
+
+   private:
+    OperatorType op_;
+    std::shared_ptr<Expression> left_;
+    std::shared_ptr<Expression> right_;
+    mutable std::optional<std::array<std::uint8_t, 2>> operand_types_;
+};
+// `target op= value`。targetは一度だけ評価し、その変数をその場で更新する
+class CompoundAssign : public Expression {
+   public:
+    using OperatorType = BinaryOperator::OperatorType;
+    CompoundAssign(OperatorType op, std::shared_ptr<Expression> target, std::shared_ptr<Expression> value,
+                   location::SourceRegion location = {})
+        : Expression(location), op_(op), target_(target), value_(value) {}
+    virtual std::vector<std::shared_ptr<Base>> children() const override;
+    OperatorType op() const { return op_; }
+    const std::shared_ptr<Expression> target() const { return target_; }
+    const std::shared_ptr<Expression> value() const { return value_; }
+    virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
+
+    // 型検査で静的に決まった変数と右辺の型(実行エンジンの値の型番号)。決まらなければnullopt
+    std::optional<std::array<std::uint8_t, 2>> operand_types() const { return operand_types_; }
+    void bind_operand_types(std::optional<std::array<std::uint8_t, 2>> types) const { operand_types_ = types; }
+
+   private:
+    OperatorType op_;
+    std::shared_ptr<Expression> target_;
+    std::shared_ptr<Expression> value_;
+    mutable std::optional<std::array<std::uint8_t, 2>> operand_types_;
+};
+// `left and right` / `left or right`。rightはleftだけで結果が決まらないときに限り評価する
+class LogicalOperator : public Expression {
+   public:
+    enum class OperatorType {
+        AND,
+        OR,
+    };
+    LogicalOperator(OperatorType op, std::shared_ptr<Expression> left, std::shared_ptr<Expression> right,
+                    location::SourceRegion location = {})
+        : Expression(location), op_(op), left_(left), right_(right) {}
+    virtual std::vector<std::shared_ptr<Base>> children() const override;
+    OperatorType op() const { return op_; }
+    const std::shared_ptr<Expression> left() const { return left_; }
+    const std::shared_ptr<Expression> right() const { return right_; }
+    virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
+
    private:
     OperatorType op_;
     std::shared_ptr<Expression> left_;
@@ -62,9 +113,14 @@ class UnaryOperator : public Expression {
     const std::shared_ptr<Expression> operand() const { return operand_; }
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
 
+    // 型検査で静的に決まった被演算子の型(実行エンジンの値の型番号)。決まらなければnullopt
+    std::optional<std::uint8_t> operand_type() const { return operand_type_; }
+    void bind_operand_type(std::optional<std::uint8_t> type) const { operand_type_ = type; }
+
    private:
     OperatorType op_;
     std::shared_ptr<Expression> operand_;
+    mutable std::optional<std::uint8_t> operand_type_;
 };
 class VariableReference : public Expression {
    public:
@@ -76,9 +132,14 @@ class VariableReference : public Expression {
     SourceVariableIdentifier name() const { return name_; }
     ValRef valref() const { return valref_; }
 
+    // 名前解決の結果。未解決の名前ならnullopt
+    std::optional<VariableBinding> binding() const { return binding_; }
+    void bind(VariableBinding binding) const { binding_ = binding; }
+
    private:
     SourceVariableIdentifier name_;
     ValRef valref_;
+    mutable std::optional<VariableBinding> binding_;
 };
 class SignedIntegerLiteral : public Expression {
    public:
@@ -144,14 +205,19 @@ class FunctionCall : public Expression {
     FunctionCall(std::shared_ptr<Expression> callee, std::vector<std::shared_ptr<Expression>>&& args,
                  location::SourceRegion location = {})
         : Expression(location), callee_(callee), args_(args) {}
-    std::vector<std::shared_ptr<Expression>> args() const { return args_; }
+    const std::vector<std::shared_ptr<Expression>>& args() const { return args_; }
     std::shared_ptr<Expression> callee() const { return callee_; }
     virtual std::vector<std::shared_ptr<Base>> children() const override;
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
 
+    // 名前解決の結果。calleeがグローバル変数を直接指さなければnullopt
+    std::optional<CallSiteBinding> call_site() const { return call_site_; }
+    void bind_call_site(CallSiteBinding binding) const { call_site_ = binding; }
+
    private:
     std::shared_ptr<Expression> callee_;
     std::vector<std::shared_ptr<Expression>> args_;
+    mutable std::optional<CallSiteBinding> call_site_;
 };
 }  // namespace Garnet::ast
 #endif
@@ -2,10 +2,30 @@
 
 #include <fmt/core.h>
 
+#include "concrete_expressions.hpp"
+
 namespace Garnet::ast {
 std::vector<std::shared_ptr<Base>> VariableDeclStatement::children() const { return {decl_}; }
+ReturnStatement::ReturnStatement(std::shared_ptr<Expression> retval, location::SourceRegion location)
+    : Statement(location), retval_(retval), tail_call_(dynamic_cast<const FunctionCall*>(retval.get())) {}
 std::vector<std::shared_ptr<Base>> ReturnStatement::children() const { return {retval_}; }
 std::vector<std::shared_ptr<Base>> LoopStatement::children() const { return {block_}; }
+std::vector<std::shared_ptr<Base>> WhileStatement::children() const { return {cond_, block_}; }
+std::vector<std::shared_ptr<Base>> DoWhileStatement::children() const { return {block_, cond_}; }
+std::vector<std::shared_ptr<Base>> ForStatement::children() const {
+    std::vector<std::shared_ptr<Base>> result;
+    if (init_.has_value()) {
+        result.push_back(init_.value());
+    }
+    if (cond_.has_value()) {
+        result.push_back(cond_.value());
+    }
+    if (update_.has_value()) {
+        result.push_back(update_.value());
+    }
+    result.push_back(block_);
+    return result;
+}
 std::vector<std::shared_ptr<Base>> BreakStatement::children() const { return {}; }
 std::vector<std::shared_ptr<Base>> IfStatement::children() const { return {}; }
 std::vector<std::shared_ptr<Base>> AssertStatement::children() const { return {cond_}; }
@@ -1,7 +1,9 @@
 #ifndef GARNET_COMPILER_LIBS_AST_CONCRETE_STATEMENTS
 #define GARNET_COMPILER_LIBS_AST_CONCRETE_STATEMENTS
+#include <cstdint>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "block.hpp"
@@ -10,26 +12,30 @@
 #include "statement.hpp"
 
 namespace Garnet::ast {
+class FunctionCall;
 class VariableDeclStatement : public Statement {
    public:
     VariableDeclStatement(std::shared_ptr<VariableDecl> decl, location::SourceRegion location = {})
         : Statement(location), decl_(decl) {}
     virtual std::vector<std::shared_ptr<Base>> children() const override;
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
+    std::shared_ptr<VariableDecl> decl() const { return decl_; }
 
    protected:
     std::shared_ptr<VariableDecl> decl_;
 };
 class ReturnStatement : public Statement {
    public:
-    ReturnStatement(std::shared_ptr<Expression> retval, location::SourceRegion location = {})
-        : Statement(location), retval_(retval) {}
+    ReturnStatement(std::shared_ptr<Expression> retval, location::SourceRegion location = {});
     virtual std::vector<std::shared_ptr<Base>> children() const override;
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
     std::shared_ptr<Expression> retval() const { return retval_; }
+    // 戻り値が関数呼び出しそのもの(末尾呼び出し)なら、その呼び出し。そうでなければnullptr
+    const FunctionCall* tail_call() const { return tail_call_; }
 
    protected:
     std::shared_ptr<Expression> retval_;
+    const FunctionCall* tail_call_;
 };
 class LoopStatement : public Statement {
    public:
@@ -42,6 +48,58 @@ class LoopStatement : public Statement {
    protected:
     std::shared_ptr<Block> block_;
 };
+class WhileStatement : public Statement {
+   public:
+    WhileStatement(std::shared_ptr<Expression> cond, std::shared_ptr<Block> block, location::SourceRegion location = {})
+        : Statement(location), cond_(cond), block_(block) {}
+    virtual std::vector<std::shared_ptr<Base>> children() const override;
+    virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
+    std::shared_ptr<Expression> cond() const { return cond_; }
+    std::shared_ptr<Block> block() const { return block_; }
+
+   protected:
+    std::shared_ptr<Expression> cond_;
+    std::shared_ptr<Block> block_;
+};
+class DoWhileStatement : public Statement {
+   public:
+    DoWhileStatement(std::shared_ptr<Block> block, std::shared_ptr<Expression> cond,
+                     location::SourceRegion location = {})
+        : Statement(location), block_(block), cond_(cond) {}
+    virtual std::vector<std::shared_ptr<Base>> children() const override;
+    virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
+    std::shared_ptr<Block> block() const { return block_; }
+    std::shared_ptr<Expression> cond() const { return cond_; }
+
+   protected:
+    std::shared_ptr<Block> block_;
+    std::shared_ptr<Expression> cond_;
+};
+// initで宣言した変数はループ全体で一つのスコープに置き、blockは毎回新しいスコープで実行する
+class ForStatement : public Statement {
+   public:
+    ForStatement(std::optional<std::shared_ptr<VariableDeclStatement>> init,
+                 std::optional<std::shared_ptr<Expression>> cond, std::optional<std::shared_ptr<Expression>> update,
+                 std::shared_ptr<Block> block, location::SourceRegion location = {})
+        : Statement(location), init_(init), cond_(cond), update_(update), block_(block) {}
+    virtual std::vector<std::shared_ptr<Base>> children() const override;
+    virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
+    std::optional<std::shared_ptr<VariableDeclStatement>> init() const { return init_; }
+    std::optional<std::shared_ptr<Expression>> cond() const { return cond_; }
+    std::optional<std::shared_ptr<Expression>> update() const { return update_; }
+    std::shared_ptr<Block> block() const { return block_; }
+
+    // initのスコープで宣言される変数の数。名前解決の結果
+    std::uint32_t frame_size() const { return frame_size_; }
+    void bind_frame_size(std::uint32_t size) const { frame_size_ = size; }
+
+   protected:
+    std::optional<std::shared_ptr<VariableDeclStatement>> init_;
+    std::optional<std::shared_ptr<Expression>> cond_;
+    std::optional<std::shared_ptr<Expression>> update_;
+    std::shared_ptr<Block> block_;
+    mutable std::uint32_t frame_size_ = 0;
+};
 class IfStatement : public Statement {
    public:
     struct CondBlock {
@@ -52,7 +110,7 @@ class IfStatement : public Statement {
         : Statement(location), cond_blocks_{cond_blocks} {}
     virtual std::vector<std::shared_ptr<Base>> children() const override;
     virtual void accept(Visitor& visitor) const override { visitor.visit(this); }
-    std::vector<CondBlock> cond_blocks() const { return cond_blocks_; };
+    const std::vector<CondBlock>& cond_blocks() const { return cond_blocks_; };
     void add_cond_block(CondBlock cond_block) { cond_blocks_.push_back(cond_block); }
     void add_cond_blocks(std::vector<CondBlock>&& cond_blocks) {
         std::ranges::copy(cond_blocks, std::back_inserter(cond_blocks_));
@@ -17,7 +17,7 @@ void PrettyPrinter::visit(const ast::VariableDecl* node) {
     auto name = node->name();
     auto type = node->type();
     auto init = node->init();
-    println_with_indent_("VariableDecl {}: {}", name, type);
+    println_with_indent_("VariableDecl {}: {} {}", name, type, node->is_const() ? "const" : "mut");
     {
         AutoIndent ind(indent_);
         println_with_indent_("init:");
@@ -48,6 +48,26 @@ void PrettyPrinter::visit(const ast::BinaryOperator* node) {
         force_line_beginning_();
     }
 }
+void PrettyPrinter::visit(const ast::CompoundAssign* node) {
+    println_with_indent_("CompoundAssign {}", node->op());
+    {
+        AutoIndent ind(indent_);
+        node->target()->accept(*this);
+        force_line_beginning_();
+        node->value()->accept(*this);
+        force_line_beginning_();
+    }
+}
+void PrettyPrinter::visit(const ast::LogicalOperator* node) {
+    println_with_indent_("LogicalOperator {}", node->op());
+    {
+        AutoIndent ind(indent_);
+        node->left()->accept(*this);
+        force_line_beginning_();
+        node->right()->accept(*this);
+        force_line_beginning_();
+    }
+}
 void PrettyPrinter::visit(const ast::UnaryOperator* node) {
     println_with_indent_("UnaryOperator {}", node->op());
     {
@@ -135,6 +155,69 @@ void PrettyPrinter::visit(const ast::LoopStatement* node) {
         }
     }
 }
+void PrettyPrinter::visit(const ast::WhileStatement* node) {
+    println_with_indent_("WhileStatement");
+    {
+        AutoIndent ind(indent_);
+        println_with_indent_("cond:");
+        {
+            AutoIndent ind(indent_);
+            node->cond()->accept(*this);
+            force_line_beginning_();
+        }
+        println_with_indent_("block:");
+        {
+            AutoIndent ind(indent_);
+            node->block()->accept(*this);
+        }
+    }
+}
+void PrettyPrinter::visit(const ast::DoWhileStatement* node) {
+    println_with_indent_("DoWhileStatement");
+    {
+        AutoIndent ind(indent_);
+        println_with_indent_("block:");
+        {
+            AutoIndent ind(indent_);
+            node->block()->accept(*this);
+        }
+        println_with_indent_("cond:");
+        {
+            AutoIndent ind(indent_);
+            node->cond()->accept(*this);
+            force_line_beginning_();
+        }
+    }
+}
+void PrettyPrinter::visit(const ast::ForStatement* node) {
+    println_with_indent_("ForStatement");
+    {
+        AutoIndent ind(indent_);
+        println_with_indent_("init:");
+        if (node->init().has_value()) {
+            AutoIndent ind(indent_);
+            node->init().value()->accept(*this);
+            force_line_beginning_();
+        }
+        println_with_indent_("cond:");
+        if (node->cond().has_value()) {
+            AutoIndent ind(indent_);
+            node->cond().value()->accept(*this);
+            force_line_beginning_();
+        }
+        println_with_indent_("update:");
+        if (node->update().has_value()) {
+            AutoIndent ind(indent_);
+            node->update().value()->accept(*this);
+            force_line_beginning_();
+        }
+        println_with_indent_("block:");
+        {
+            AutoIndent ind(indent_);
+            node->block()->accept(*this);
+        }
+    }
+}
 void PrettyPrinter::visit(const ast::BreakStatement*) { println_with_indent_("BreakStatement"); }
 void PrettyPrinter::visit(const ast::IfStatement* node) {
     println_with_indent_("IfStatement");
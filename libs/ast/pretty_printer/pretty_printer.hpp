@@ -38,6 +38,8 @@ class PrettyPrinter : public ast::Visitor {
     virtual void visit(const ast::ErrorExpression*) override;
     virtual void visit(const ast::ErrorStatement*) override;
     virtual void visit(const ast::BinaryOperator*) override;
+    virtual void visit(const ast::CompoundAssign*) override;
+    virtual void visit(const ast::LogicalOperator*) override;
     virtual void visit(const ast::UnaryOperator*) override;
     virtual void visit(const ast::VariableReference*) override;
     virtual void visit(const ast::SignedIntegerLiteral*) override;
@@ -51,6 +53,9 @@ class PrettyPrinter : public ast::Visitor {
     virtual void visit(const ast::ReturnStatement*) override;
     virtual void visit(const ast::Block*) override;
     virtual void visit(const ast::LoopStatement*) override;
+    virtual void visit(const ast::WhileStatement*) override;
+    virtual void visit(const ast::DoWhileStatement*) override;
+    virtual void visit(const ast::ForStatement*) override;
     virtual void visit(const ast::BreakStatement*) override;
     virtual void visit(const ast::IfStatement*) override;
     virtual void visit(const ast::AssertStatement*) override;
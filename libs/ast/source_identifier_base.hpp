@@ -1,14 +1,15 @@
 #ifndef GARNET_LIBS_AST_SOURCE_TYPE
 #define GARNET_LIBS_AST_SOURCE_TYPE
 #include <string>
+#include <string_view>
 
 #include "flyweight.hpp"
 namespace Garnet::ast {
 class SourceIdentifierBase {
    public:
     SourceIdentifierBase() : SourceIdentifierBase("__unspecified__") {}
-    SourceIdentifierBase(std::string name) : name_id_(SimpleFlyWeight::instance().id(name)) {}
-    const std::string source_name() const { return SimpleFlyWeight::instance().value(name_id_); }
+    SourceIdentifierBase(std::string_view name) : name_id_(SimpleFlyWeight::instance().id(name)) {}
+    const std::string& source_name() const { return SimpleFlyWeight::instance().value(name_id_); }
     SimpleFlyWeight::id_type source_id() const { return name_id_; }
     const std::string to_string() const { return source_name(); }
     size_t length() const { return source_name().length(); }
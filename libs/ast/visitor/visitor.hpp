@@ -10,6 +10,8 @@ class ErrorSentence;
 class ErrorExpression;
 class ErrorStatement;
 class BinaryOperator;
+class CompoundAssign;
+class LogicalOperator;
 class UnaryOperator;
 class VariableReference;
 class SignedIntegerLiteral;
@@ -26,6 +28,9 @@ class VariableDeclStatement;
 class ReturnStatement;
 class Block;
 class LoopStatement;
+class WhileStatement;
+class DoWhileStatement;
+class ForStatement;
 class BreakStatement;
 class IfStatement;
 class AssertStatement;
@@ -42,6 +47,8 @@ class Visitor {
     virtual void visit(const ast::ErrorExpression*) = 0;
     virtual void visit(const ast::ErrorStatement*) = 0;
     virtual void visit(const ast::BinaryOperator*) = 0;
+    virtual void visit(const ast::CompoundAssign*) = 0;
+    virtual void visit(const ast::LogicalOperator*) = 0;
     virtual void visit(const ast::UnaryOperator*) = 0;
     virtual void visit(const ast::VariableReference*) = 0;
     virtual void visit(const ast::SignedIntegerLiteral*) = 0;
@@ -55,6 +62,9 @@ class Visitor {
     virtual void visit(const ast::ReturnStatement*) = 0;
     virtual void visit(const ast::Block*) = 0;
     virtual void visit(const ast::LoopStatement*) = 0;
+    virtual void visit(const ast::WhileStatement*) = 0;
+    virtual void visit(const ast::DoWhileStatement*) = 0;
+    virtual void visit(const ast::ForStatement*) = 0;
     virtual void visit(const ast::BreakStatement*) = 0;
     virtual void visit(const ast::IfStatement*) = 0;
     virtual void visit(const ast::AssertStatement*) = 0;
@@ -0,0 +1,27 @@
+#include "identifier_mangler.hpp"
+
+#include <fmt/core.h>
+
+#include "../utils/format.hpp"
+namespace Garnet::emit {
+std::string IndentifilerMangler::mangle_function_name(ast::SourceFunctionIdentifier name,
+                                                      ast::FunctionInfo signature) {
+    auto result = fmt::format("_F{}{}", name.length(), name);
+    for (const auto& arg : signature.args()) {
+        result += mangle_type_name(arg.type().name());
+    }
+    result += "_R";
+    if (signature.result().has_value()) {
+        result += mangle_type_name(signature.result()->type().name());
+    } else {
+        result += mangle_type_name({"void"});
+    }
+    return result;
+}
+std::string IndentifilerMangler::mangle_variable_name(ast::VariableInfo variable) {
+    return fmt::format("_V{}{}{}", variable.name().length(), variable.name(), mangle_type_name(variable.type().name()));
+}
+std::string IndentifilerMangler::mangle_type_name(ast::SourceTypeIdentifier name) {
+    return fmt::format("_T{}{}", name.length(), name);
+}
+}  // namespace Garnet::emit
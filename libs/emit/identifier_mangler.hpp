@@ -1,11 +1,19 @@
 #ifndef GARNET_LIBS_EMIT_IDENTIFIERMANGLER
 #define GARNET_LIBS_EMIT_IDENTIFIERMANGLER
+#include <string>
+
 #include "concrete_infos.hpp"
 #include "concrete_source_identifiers.hpp"
 namespace Garnet::emit {
+// 名前と型から、出力先の言語で使える識別子を作る
+// 規則はVariableDecl::mangled_name()、TypeDecl::mangled_name()と揃えてある
 class IndentifilerMangler {
    public:
+    // _F{名前の長さ}{名前}に、引数の型と、_Rに続けて戻り値の型を並べる
     static std::string mangle_function_name(ast::SourceFunctionIdentifier name, ast::FunctionInfo signature);
+    // 関数の引数のように、VariableDeclを持たない変数の名前
+    static std::string mangle_variable_name(ast::VariableInfo variable);
+    static std::string mangle_type_name(ast::SourceTypeIdentifier name);
 };
 }  // namespace Garnet::emit
 #endif
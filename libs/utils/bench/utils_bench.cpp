@@ -0,0 +1,373 @@
+// libs/utilsの小さな部品(SimpleFlyWeight、InstancePool、SourcePosition、mudigの変換)のマイクロベンチマーク
+// 各部品を、異なる識別子などの数(size)を10から10^6まで変えて測り、一行に一つのJSONとして標準出力に書く
+// スループットは計時を挟まずに連続して実行した平均、遅延の分布は一回ずつ計時した値の百分位数
+// SimpleFlyWeightは唯一のインスタンスを空に戻せないので、sizeの小さい順に識別子を足しながら測る
+
+#include <fmt/core.h>
+#include <fmt/ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <latch>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "flyweight.hpp"
+#include "instance_pool.hpp"
+#include "location.hpp"
+#include "mudig_converter.hpp"
+
+namespace {
+namespace bpo = boost::program_options;
+using Clock = std::chrono::steady_clock;
+
+// 結果を捨てられないように、ここへ畳み込む
+volatile std::uint64_t sink = 0;
+template <typename T>
+void keep(const T& value) {
+    sink = sink + static_cast<std::uint64_t>(value);
+}
+
+struct Options {
+    std::vector<std::size_t> sizes;
+    // スループットを測るのに、少なくともこれだけ実行する
+    std::chrono::milliseconds min_time;
+    // 一回ずつ計時する回数
+    std::size_t latency_samples;
+    // 一つのsizeの準備と計測にかけてよい時間。超えたら、それより大きいsizeは測らない
+    std::chrono::milliseconds budget;
+    // 複数のスレッドから登録するときの、異なる名前の数
+    std::size_t concurrent_names;
+};
+
+// 検証に失敗したものがあれば、終了コードを1にする
+bool failed = false;
+
+double to_ns(Clock::duration duration) { return std::chrono::duration<double, std::nano>(duration).count(); }
+
+// 百分位数は最も近い順位の値
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    auto rank = static_cast<std::size_t>(p / 100 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+void print_skipped(std::string_view benchmark, std::size_t size, std::string_view reason) {
+    fmt::println("{{\"benchmark\": \"{}\", \"size\": {}, \"skipped\": \"{}\"}}", benchmark, size, reason);
+}
+
+// opに0から順に番号を渡して実行し、結果を一行書く。時間を使い切ったらfalse
+// 実行すると状態の変わる操作は、max_opsで回数を抑える。その半分ずつをスループットと遅延の計測に使う
+template <typename Op>
+bool measure(std::string_view benchmark, std::size_t size, const Options& options, Op&& op,
+             std::size_t max_ops = std::numeric_limits<std::size_t>::max()) {
+    auto deadline = Clock::now() + options.budget;
+    auto max_half = std::max<std::size_t>(max_ops / 2, 1);
+    // 実行する回数を倍々に増やし、min_time以上かかった回をスループットとする
+    std::size_t ops = 1;
+    std::size_t index = 0;
+    Clock::duration elapsed{};
+    for (;;) {
+        auto begin = Clock::now();
+        for (std::size_t i = 0; i < ops; i++) {
+            op(index++);
+        }
+        elapsed = Clock::now() - begin;
+        if (elapsed >= options.min_time || Clock::now() + elapsed * 2 > deadline || ops * 2 > max_half) {
+            break;
+        }
+        ops *= 2;
+    }
+    std::vector<double> samples;
+    auto sample_count = std::min(options.latency_samples, max_half);
+    samples.reserve(sample_count);
+    while (samples.size() < sample_count && Clock::now() < deadline) {
+        auto begin = Clock::now();
+        op(index++);
+        samples.push_back(to_ns(Clock::now() - begin));
+    }
+    std::ranges::sort(samples);
+    auto ns_per_op = to_ns(elapsed) / static_cast<double>(ops);
+    fmt::println(
+        "{{\"benchmark\": \"{}\", \"size\": {}, \"ops\": {}, \"ns_per_op\": {:.3f}, \"ops_per_sec\": {:.0f}, "
+        "\"samples\": {}, \"p50_ns\": {:.1f}, \"p90_ns\": {:.1f}, \"p99_ns\": {:.1f}, \"max_ns\": {:.1f}}}",
+        benchmark, size, ops, ns_per_op, 1e9 / ns_per_op, samples.size(), percentile(samples, 50),
+        percentile(samples, 90), percentile(samples, 99), samples.empty() ? 0.0 : samples.back());
+    std::cout.flush();
+    return Clock::now() < deadline;
+}
+
+// 識別子らしい名前。長さを揃えないように、番号をそのまま付ける
+std::string identifier(std::size_t i) { return fmt::format("ident_{}", i); }
+
+// 0以上のnを、子音で表した12進数のmudigにする
+std::string to_mudig(std::uint64_t n) {
+    constexpr std::string_view CONS = "KGSZTDNHMRPB";
+    std::string result;
+    do {
+        result.insert(result.begin(), CONS[n % 12]);
+        n /= 12;
+    } while (n != 0);
+    return result;
+}
+
+// 無作為だが毎回同じ順番で、[0, size)の番号を選ぶ
+std::vector<std::size_t> random_indices(std::size_t size, std::size_t count) {
+    std::mt19937_64 engine(size);
+    std::uniform_int_distribution<std::size_t> dist(0, size - 1);
+    std::vector<std::size_t> result(count);
+    for (auto& index : result) {
+        index = dist(engine);
+    }
+    return result;
+}
+
+void bench_flyweight(const Options& options) {
+    auto& flyweight = Garnet::SimpleFlyWeight::instance();
+    // 登録済みの識別子の数と、それ以外も含めた全体の数
+    std::size_t interned = 0;
+    std::size_t pool_size = flyweight.id("") + 1;
+    std::size_t fresh = 0;
+    for (auto size : options.sizes) {
+        // 全体がsizeになるまで識別子を足す
+        auto deadline = Clock::now() + options.budget;
+        while (pool_size < size && Clock::now() < deadline) {
+            pool_size = flyweight.id(identifier(interned++)) + 1;
+        }
+        if (pool_size < size) {
+            for (auto benchmark : {"flyweight.id.hit", "flyweight.value", "flyweight.id.miss"}) {
+                print_skipped(benchmark, size, "setup exceeded budget");
+            }
+            return;
+        }
+        auto indices = random_indices(interned, 1 << 16);
+        std::vector<std::string> names;
+        names.reserve(indices.size());
+        for (auto index : indices) {
+            names.push_back(identifier(index));
+        }
+        bool in_budget = measure("flyweight.id.hit", size, options,
+                                 [&](std::size_t i) { keep(flyweight.id(names[i % names.size()])); });
+        in_budget &= measure("flyweight.value", size, options,
+                             [&](std::size_t i) { keep(flyweight.value(indices[i % indices.size()]).size()); });
+        // 登録されていない識別子。測るたびに登録されて全体が増えるので、sizeの1割までにする
+        in_budget &= measure(
+            "flyweight.id.miss", size, options,
+            [&](std::size_t) { pool_size = flyweight.id(fmt::format("fresh_{}", fresh++)) + 1; },
+            std::max<std::size_t>(size / 10, 2));
+        if (not in_budget) {
+            return;
+        }
+    }
+}
+
+void bench_location(const Options& options) {
+    // 実際のプログラムと同じく、ソースファイルの数は少ない
+    std::vector<std::string> files;
+    for (std::size_t i = 0; i < 8; i++) {
+        files.push_back(fmt::format("src/module_{}.grn", i));
+    }
+    for (auto size : options.sizes) {
+        // sizeは位置の数。行と列を無作為に選ぶ
+        auto indices = random_indices(size, std::min<std::size_t>(size, 1 << 16));
+        std::vector<Garnet::location::SourcePosition> positions;
+        positions.reserve(indices.size());
+        for (auto index : indices) {
+            positions.emplace_back(files[index % files.size()], static_cast<int>(index / 80 + 1),
+                                   static_cast<int>(index % 80 + 1));
+        }
+        bool in_budget = measure("location.construct", size, options, [&](std::size_t i) {
+            auto index = indices[i % indices.size()];
+            Garnet::location::SourcePosition position(files[index % files.size()],
+                                                      static_cast<int>(index / 80 + 1),
+                                                      static_cast<int>(index % 80 + 1));
+            keep(position.line);
+        });
+        in_budget &= measure("location.source_file", size, options,
+                             [&](std::size_t i) { keep(positions[i % positions.size()].source_file().size()); });
+        if (not in_budget) {
+            return;
+        }
+    }
+}
+
+void bench_instance_pool(const Options& options) {
+    // Scopeの変数表に当たる型
+    using Map = std::unordered_map<std::size_t, std::size_t>;
+    using Pool = Garnet::InstancePool<Map>;
+    std::vector<Map*> held;
+    for (auto size : options.sizes) {
+        // sizeは同時に借りている数(スコープの深さ)。一度借りて返し、プールにsize個溜めておく
+        while (held.size() < size) {
+            held.push_back(Pool::aquire());
+        }
+        for (auto instance : held) {
+            Pool::return_instance(instance);
+        }
+        held.clear();
+        // sizeまで借りてから全て返すのを繰り返す。一回の操作は一つを借りるか返すか
+        std::size_t depth = 0;
+        bool is_acquiring = true;
+        held.reserve(size);
+        bool in_budget = measure("instance_pool.aquire_return", size, options, [&](std::size_t) {
+            if (is_acquiring) {
+                held.push_back(Pool::aquire());
+                is_acquiring = ++depth < size;
+            } else {
+                Pool::return_instance(held.back());
+                held.pop_back();
+                is_acquiring = --depth == 0;
+            }
+        });
+        for (auto instance : held) {
+            Pool::return_instance(instance);
+        }
+        held.clear();
+        if (not in_budget) {
+            return;
+        }
+    }
+}
+
+void bench_mudig(const Options& options) {
+    for (auto size : options.sizes) {
+        // sizeは異なる数の数。整数は0から、小数は整数部と小数部を組み合わせて作る
+        auto count = std::min<std::size_t>(size, 1 << 16);
+        auto indices = random_indices(size, count);
+        std::vector<std::string> integers, floats;
+        integers.reserve(count);
+        floats.reserve(count);
+        for (auto index : indices) {
+            integers.push_back(to_mudig(index));
+            // U+0323(下の点)の付いた桁から小数部
+            floats.push_back(to_mudig(index / 144) + "\u0323" + to_mudig(index % 144));
+        }
+        bool in_budget = measure("mudig.to_int", size, options,
+                                 [&](std::size_t i) { keep(Garnet::mudig_to_int(integers[i % integers.size()])); });
+        in_budget &= measure("mudig.to_float", size, options,
+                             [&](std::size_t i) { keep(Garnet::mudig_to_float(floats[i % floats.size()]) * 1024); });
+        if (not in_budget) {
+            return;
+        }
+    }
+}
+
+// 同じ名前の組を、スレッドごとに異なる順番で全スレッドから同時に登録する
+// 全てのスレッドが同じ名前に同じidを得て、異なる名前のidが重ならず、idから元の名前を引けることを確かめる
+void bench_flyweight_concurrent(const Options& options) {
+    auto& flyweight = Garnet::SimpleFlyWeight::instance();
+    auto count = options.concurrent_names;
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t threads = 1; threads <= std::max(std::thread::hardware_concurrency(), 4u); threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    for (auto threads : thread_counts) {
+        // 前の回と重ならない名前にして、最初に登録するスレッドが必ずいるようにする
+        std::vector<std::string> names(count);
+        for (std::size_t i = 0; i < count; i++) {
+            names[i] = fmt::format("threads{}_{}", threads, i);
+        }
+        std::vector<std::vector<std::size_t>> ids(threads, std::vector<std::size_t>(count));
+        std::atomic<std::size_t> mismatches = 0;
+        std::latch ready(static_cast<std::ptrdiff_t>(threads));
+        Clock::time_point begin;
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < threads; t++) {
+                workers.emplace_back([&, t] {
+                    std::vector<std::size_t> order(count);
+                    std::iota(order.begin(), order.end(), 0);
+                    std::ranges::shuffle(order, std::mt19937_64(t));
+                    ready.arrive_and_wait();
+                    if (t == 0) {
+                        begin = Clock::now();
+                    }
+                    std::size_t local_mismatches = 0;
+                    for (auto i : order) {
+                        auto id = flyweight.id(names[i]);
+                        local_mismatches += flyweight.value(id) != names[i];
+                        ids[t][i] = id;
+                    }
+                    mismatches.fetch_add(local_mismatches);
+                });
+            }
+        }
+        auto elapsed = Clock::now() - begin;
+        std::unordered_map<std::size_t, std::size_t> owners;
+        for (std::size_t i = 0; i < count; i++) {
+            for (std::size_t t = 1; t < threads; t++) {
+                mismatches += ids[t][i] != ids[0][i];
+            }
+            mismatches += not owners.emplace(ids[0][i], i).second;
+        }
+        bool consistent = mismatches == 0;
+        failed |= not consistent;
+        auto ops = threads * count;
+        auto ns_per_op = to_ns(elapsed) / static_cast<double>(ops);
+        fmt::println(
+            "{{\"benchmark\": \"flyweight.concurrent\", \"size\": {}, \"threads\": {}, \"ops\": {}, "
+            "\"ns_per_op\": {:.3f}, \"ops_per_sec\": {:.0f}, \"consistent\": {}}}",
+            count, threads, ops, ns_per_op, 1e9 / ns_per_op, consistent);
+        std::cout.flush();
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    bpo::options_description opt;
+    opt.add_options()("help,h", "show this help")(
+        "sizes", bpo::value<std::vector<std::size_t>>()->multitoken(),
+        "numbers of distinct identifiers to measure with (default 10 100 ... 1000000)")(
+        "min-time", bpo::value<std::size_t>()->default_value(200),
+        "minimum time of the throughput run in milliseconds")(
+        "samples", bpo::value<std::size_t>()->default_value(10000), "number of individually timed operations")(
+        "budget", bpo::value<std::size_t>()->default_value(20000),
+        "time limit for setting up and measuring one size in milliseconds; larger sizes are skipped after it")(
+        "concurrent-names", bpo::value<std::size_t>()->default_value(100000),
+        "number of distinct names interned from several threads at once")(
+        "filter", bpo::value<std::string>()->default_value(""),
+        "only run groups whose name contains this (flyweight, location, instance_pool, mudig, flyweight_concurrent)");
+    bpo::variables_map varmap;
+    bpo::store(bpo::parse_command_line(argc, argv, opt), varmap);
+    if (varmap.contains("help")) {
+        std::cout << opt;
+        return 0;
+    }
+    bpo::notify(varmap);
+    Options options{
+        .sizes = varmap.contains("sizes") ? varmap["sizes"].as<std::vector<std::size_t>>()
+                                          : std::vector<std::size_t>{10, 100, 1000, 10000, 100000, 1000000},
+        .min_time = std::chrono::milliseconds(varmap["min-time"].as<std::size_t>()),
+        .latency_samples = varmap["samples"].as<std::size_t>(),
+        .budget = std::chrono::milliseconds(varmap["budget"].as<std::size_t>()),
+        .concurrent_names = std::max<std::size_t>(varmap["concurrent-names"].as<std::size_t>(), 1),
+    };
+    std::erase(options.sizes, 0);
+    std::ranges::sort(options.sizes);
+    const auto& filter = varmap["filter"].as<std::string>();
+    for (auto [name, bench] : {
+             // SourcePositionはソースファイルの名前を登録するので、識別子を多く登録する前に測る
+             std::pair{"location", &bench_location},
+             std::pair{"instance_pool", &bench_instance_pool},
+             std::pair{"mudig", &bench_mudig},
+             std::pair{"flyweight", &bench_flyweight},
+             std::pair{"flyweight_concurrent", &bench_flyweight_concurrent},
+         }) {
+        if (std::string_view(name).find(filter) != std::string_view::npos) {
+            bench(options);
+        }
+    }
+    return failed ? 1 : 0;
+}
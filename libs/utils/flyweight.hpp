@@ -1,18 +1,62 @@
 #ifndef GARNET_LIBS_UTILS_FLYWEIGHT
 #define GARNET_LIBS_UTILS_FLYWEIGHT
-#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cstddef>
-#include <iterator>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <unordered_map>
 namespace Garnet {
+// 複数のスレッドから同時に使える
+// idから文字列を引くのはロックを取らずに済み、登録は文字列のハッシュで分けたシャードごとにロックを取る
 class SimpleFlyWeight {
-    SimpleFlyWeight() = default;
-    std::vector<std::string> pool_;
+    // 文字列本体は、大きさを倍々にしたセグメントに登録順に置き、一度置いたら動かさない
+    // セグメントkは[FIRST_SEGMENT * (2^k - 1), FIRST_SEGMENT * (2^(k+1) - 1))のidを持つ
+    static constexpr std::size_t FIRST_SEGMENT = 1024;
+    static constexpr std::size_t SEGMENT_COUNT = 48;
+    std::array<std::atomic<std::string*>, SEGMENT_COUNT> segments_{};
+    std::atomic<std::size_t> size_ = 0;
+
+    // セグメントの文字列を指すstring_viewからidを引く索引
+    static constexpr std::size_t SHARD_COUNT = 64;
+    struct alignas(64) Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string_view, std::size_t> index;
+    };
+    std::array<Shard, SHARD_COUNT> shards_;
 
+    SimpleFlyWeight() = default;
+    ~SimpleFlyWeight() {
+        for (auto& segment : segments_) {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
+    }
     SimpleFlyWeight(SimpleFlyWeight&) = delete;
     SimpleFlyWeight(SimpleFlyWeight&&) = delete;
 
+    static std::size_t segment_of_(std::size_t id) { return std::bit_width(id / FIRST_SEGMENT + 1) - 1; }
+    static std::size_t offset_in_(std::size_t id, std::size_t segment) {
+        return id - FIRST_SEGMENT * ((std::size_t{1} << segment) - 1);
+    }
+    // idの置き場所を用意する。セグメントが無ければ作り、他のスレッドと競ったら先に置かれた方を使う
+    std::string& slot_(std::size_t id) {
+        auto segment = segment_of_(id);
+        auto* storage = segments_[segment].load(std::memory_order_acquire);
+        if (storage == nullptr) {
+            auto* created = new std::string[FIRST_SEGMENT << segment];
+            if (segments_[segment].compare_exchange_strong(storage, created, std::memory_order_acq_rel)) {
+                storage = created;
+            } else {
+                delete[] created;
+            }
+        }
+        return storage[offset_in_(id, segment)];
+    }
+
    public:
     static SimpleFlyWeight& instance() {
         static SimpleFlyWeight a;
@@ -21,18 +65,33 @@ class SimpleFlyWeight {
     using value_type = std::string;
     using id_type = std::size_t;
 
-    id_type id(const std::string& value) {
-        // とりあえずシンプルに線形探索
-        // ソースファイルを保存するだけなら、構築よりも参照のほうが圧倒的に
-        // 多いので、構築が多少非効率でも参照が爆速なほうが良い
-        auto pos = std::ranges::find(pool_, value);
-        if (pos == pool_.end()) {
-            pool_.push_back(value);
-            return pool_.size() - 1;
+    // 登録済みの文字列なら、文字列を確保せずに引ける。idは登録した順の連番で、変わらない
+    id_type id(std::string_view value) {
+        auto& shard = shards_[std::hash<std::string_view>()(value) % SHARD_COUNT];
+        {
+            std::shared_lock lock(shard.mutex);
+            if (auto pos = shard.index.find(value); pos != shard.index.end()) {
+                return pos->second;
+            }
         }
-        return std::distance(pool_.begin(), pos);
+        std::unique_lock lock(shard.mutex);
+        // ロックを取り直す間に、他のスレッドが同じ文字列を登録したかもしれない
+        if (auto pos = shard.index.find(value); pos != shard.index.end()) {
+            return pos->second;
+        }
+        id_type result = size_.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = slot_(result);
+        slot = value;
+        shard.index.emplace(slot, result);
+        return result;
+    }
+    // idを受け取ったスレッドからは、ロックを取らずに引ける
+    const std::string& value(id_type id) const {
+        auto segment = segment_of_(id);
+        return segments_[segment].load(std::memory_order_acquire)[offset_in_(id, segment)];
     }
-    std::string& value(id_type id) { return pool_[id]; }
+    // 登録した文字列の数。他のスレッドが登録している最中なら、まだ引けないidを含むことがある
+    std::size_t size() const { return size_.load(std::memory_order_relaxed); }
 };
 }  // namespace Garnet
 #endif
@@ -2,6 +2,7 @@
 #define GARNET_LIBS_DEFS_LOCATION
 // #include <filesystem>
 #include <string>
+#include <string_view>
 
 #include "flyweight.hpp"
 namespace Garnet::location {
@@ -11,10 +12,10 @@ struct SourcePosition {
     int line;
     int column;
     SourcePosition() : SourcePosition("", -1, -1) {}
-    SourcePosition(const PathType &source_file, int line, int column) : line(line), column(column) {
+    SourcePosition(std::string_view source_file, int line, int column) : line(line), column(column) {
         source_file_id_ = SimpleFlyWeight::instance().id(source_file);
     }
-    PathType source_file() const { return SimpleFlyWeight::instance().value(source_file_id_); }
+    const PathType &source_file() const { return SimpleFlyWeight::instance().value(source_file_id_); }
 
    private:
     SimpleFlyWeight::id_type source_file_id_;
@@ -0,0 +1,68 @@
+#include "mapped_file.hpp"
+
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+namespace Garnet {
+MappedFile::MappedFile(const std::string& path) {
+#if defined(__unix__)
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat status;
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        auto size = static_cast<std::size_t>(status.st_size);
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            // 字句解析は先頭から順に一度だけ読む
+            madvise(address, size, MADV_SEQUENTIAL);
+            close(fd);
+            data_ = static_cast<const char*>(address);
+            size_ = size;
+            is_mapped_ = true;
+            return;
+        }
+    }
+    char buffer[1 << 16];
+    for (;;) {
+        auto count = read(fd, buffer, sizeof(buffer));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+        if (count == 0) {
+            break;
+        }
+        contents_.append(buffer, static_cast<std::size_t>(count));
+    }
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (not file) {
+        throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory), path);
+    }
+    contents_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+#endif
+    data_ = contents_.data();
+    size_ = contents_.size();
+}
+MappedFile::~MappedFile() {
+#if defined(__unix__)
+    if (is_mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+}  // namespace Garnet
@@ -0,0 +1,27 @@
+#ifndef GARNET_LIBS_UTILS_MAPPED_FILE
+#define GARNET_LIBS_UTILS_MAPPED_FILE
+#include <cstddef>
+#include <string>
+#include <string_view>
+namespace Garnet {
+// ファイルの内容を読み取り専用でメモリに写像する
+// 写像できない環境や、パイプなど大きさの分からないファイルでは、代わりに内容を読み込んで持つ
+// 開けなければstd::system_errorを投げる
+class MappedFile {
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool is_mapped_ = false;
+    std::string contents_;
+
+   public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+    bool is_mapped() const { return is_mapped_; }
+};
+}  // namespace Garnet
+#endif
@@ -0,0 +1,93 @@
+#ifndef GARNET_LIBS_UTILS_SHARED_STRING
+#define GARNET_LIBS_UTILS_SHARED_STRING
+#include <fmt/base.h>
+#include <fmt/format.h>
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+namespace Garnet {
+// 不変な文字列を参照カウントで共有する
+// ポインタ一つ分の大きさで、コピーは参照カウントの増減だけで済む
+// 参照カウントはアトミックではないので、スレッドをまたいで共有してはならない
+class SharedString {
+    struct Header {
+        std::size_t refcount;
+        std::size_t size;
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+    // 空文字列はnullptrで表し、確保しない
+    Header* header_ = nullptr;
+
+    static Header* allocate_(std::size_t size) {
+        auto* header = static_cast<Header*>(::operator new(sizeof(Header) + size));
+        header->refcount = 1;
+        header->size = size;
+        return header;
+    }
+    void release_() noexcept {
+        if (header_ != nullptr && --header_->refcount == 0) {
+            ::operator delete(header_);
+        }
+    }
+
+   public:
+    SharedString() = default;
+    explicit SharedString(std::string_view str) {
+        if (not str.empty()) {
+            header_ = allocate_(str.size());
+            std::memcpy(header_->data(), str.data(), str.size());
+        }
+    }
+    SharedString(const SharedString& other) noexcept : header_(other.header_) {
+        if (header_ != nullptr) {
+            header_->refcount++;
+        }
+    }
+    SharedString(SharedString&& other) noexcept : header_(std::exchange(other.header_, nullptr)) {}
+    SharedString& operator=(const SharedString& other) noexcept {
+        SharedString(other).swap(*this);
+        return *this;
+    }
+    SharedString& operator=(SharedString&& other) noexcept {
+        SharedString(std::move(other)).swap(*this);
+        return *this;
+    }
+    ~SharedString() { release_(); }
+
+    void swap(SharedString& other) noexcept { std::swap(header_, other.header_); }
+
+    std::string_view view() const noexcept {
+        return header_ == nullptr ? std::string_view() : std::string_view(header_->data(), header_->size);
+    }
+    std::size_t size() const noexcept { return header_ == nullptr ? 0 : header_->size; }
+    bool empty() const noexcept { return header_ == nullptr; }
+
+    friend SharedString operator+(const SharedString& lhs, const SharedString& rhs) {
+        if (lhs.empty()) {
+            return rhs;
+        }
+        if (rhs.empty()) {
+            return lhs;
+        }
+        SharedString result;
+        result.header_ = allocate_(lhs.size() + rhs.size());
+        std::memcpy(result.header_->data(), lhs.header_->data(), lhs.size());
+        std::memcpy(result.header_->data() + lhs.size(), rhs.header_->data(), rhs.size());
+        return result;
+    }
+    friend bool operator==(const SharedString& lhs, const SharedString& rhs) noexcept {
+        return lhs.view() == rhs.view();
+    }
+};
+static_assert(sizeof(SharedString) == sizeof(void*));
+}  // namespace Garnet
+template <>
+struct fmt::formatter<Garnet::SharedString> : public fmt::formatter<std::string_view> {
+    auto format(const Garnet::SharedString& str, fmt::format_context& ctx) const {
+        return fmt::formatter<std::string_view>::format(str.view(), ctx);
+    }
+};
+#endif
@@ -26,11 +26,21 @@
 #include <boost/program_options.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <optional>
 
 #include "driver.hpp"
+#include "interpreter/bytecode/compiler.hpp"
+#include "interpreter/bytecode/vm.hpp"
+#include "interpreter/emit/c_emitter.hpp"
 #include "interpreter/exceptions.hpp"
+#include "interpreter/instrumented_interpreter.hpp"
 #include "interpreter/interpreter.hpp"
+#include "interpreter/optimizer.hpp"
+#include "interpreter/profiler.hpp"
 #include "libs/utils/format.hpp"  // NOLINT(clang-diagnostic-unused-header)
 #include "pretty_printer/pretty_printer.hpp"
 
@@ -71,6 +81,22 @@ int main(int argc, char* argv[]) {
     opt.add_options()("help,h", "show this help")("trace-parsing,p", "enable debug output for parsing")(
         "trace-scanning,s", "enable debug output for scanning")(
         "backtrace,b", "show backtrace of interpreter on error")("debug,d", "show debug output")(
+        "engine", bpo::value<std::string>()->default_value("tree"), "execution engine (tree or vm)")(
+        "emit", bpo::value<std::string>(),
+        "write the program as source code in the given language (c) instead of running it")(
+        "no-optimize", "disable constant folding and propagation")(
+        "memoize", "cache results of calls to pure functions (tree engine)")(
+        "memoize-size", bpo::value<std::size_t>()->default_value(4096), "number of cached results per function")(
+        "jit", "compile hot numeric functions to x86-64 machine code (tree engine)")(
+        "jit-threshold", bpo::value<std::size_t>()->default_value(100),
+        "number of calls before a function is compiled")(
+        "profile", bpo::value<std::string>(),
+        "sample the call stacks of Garnet functions and write them as folded stacks to the given file (tree engine)")(
+        "profile-interval", bpo::value<std::size_t>()->default_value(1000),
+        "CPU time between samples in microseconds")(
+        "stats", "count executions and time of operators, calls and blocks, and report the hottest (tree engine)")(
+        "stats-top", bpo::value<std::size_t>()->default_value(20), "number of nodes in the report of --stats")(
+        "stats-json", bpo::value<std::string>(), "also write all counts of --stats as JSON to the given file")(
         "input-file", bpo::value<std::vector<std::string>>()->required(), "input file (positional)");
     bpo::variables_map varmap;
     bpo::store(bpo::command_line_parser(argc, argv).options(opt).positional(pos).run(), varmap);
@@ -80,6 +106,16 @@ int main(int argc, char* argv[]) {
         std::exit(0);
     }
     bpo::notify(varmap);
+    const auto& engine = varmap["engine"].as<std::string>();
+    if (engine != "tree" and engine != "vm") {
+        fmt::println(std::cerr, "unknown engine: {}", engine);
+        std::exit(1);
+    }
+    bool is_emitting = varmap.contains("emit");
+    if (is_emitting and varmap["emit"].as<std::string>() != "c") {
+        fmt::println(std::cerr, "unknown language to emit: {}", varmap["emit"].as<std::string>());
+        std::exit(1);
+    }
     int res = 0;
     Garnet::Driver drv;
     if (varmap.contains("trace-parsing")) {
@@ -92,17 +128,48 @@ int main(int argc, char* argv[]) {
     if (varmap.contains("backtrace")) {
         show_backtrace = true;
     }
-    for (const auto& infilename : varmap["input-file"].as<std::vector<std::string>>()) {
-        drv.parse(infilename);
-    }
+    drv.parse(varmap["input-file"].as<std::vector<std::string>>());
     auto ast = drv.result();
+    if (not varmap.contains("no-optimize")) {
+        ast = Garnet::interpreter::Optimizer().optimize(ast);
+    }
     if (varmap.contains("debug")) {
         Garnet::ast::PrettyPrinter printer;
         ast->accept(printer);
     }
-    Garnet::interpreter::Interpreter interpreter;
+    // 計測するときだけ、visitを上書きしたInterpreterを使う
+    bool is_instrumented = varmap.contains("stats") or varmap.contains("stats-json");
+    std::unique_ptr<Garnet::interpreter::Interpreter> interpreter =
+        is_instrumented ? std::make_unique<Garnet::interpreter::InstrumentedInterpreter>()
+                        : std::make_unique<Garnet::interpreter::Interpreter>();
+    if (varmap.contains("memoize")) {
+        interpreter->enable_memoization(varmap["memoize-size"].as<std::size_t>());
+    }
+    if (varmap.contains("jit")) {
+        interpreter->enable_jit(varmap["jit-threshold"].as<std::size_t>());
+    }
+    std::optional<Garnet::interpreter::Profiler> profiler;
+    if (varmap.contains("profile")) {
+        if (not Garnet::interpreter::Profiler::is_supported()) {
+            fmt::println(std::cerr, "profiling is not supported on this platform");
+            std::exit(1);
+        }
+        profiler.emplace(std::chrono::microseconds(varmap["profile-interval"].as<std::size_t>()));
+        interpreter->enable_profiling(&*profiler);
+    }
+    Garnet::interpreter::bytecode::VirtualMachine vm;
     try {
-        ast->accept(interpreter);
+        if (is_emitting) {
+            fmt::print("{}", Garnet::interpreter::emit::CEmitter().emit(*ast));
+        } else if (engine == "vm") {
+            auto program = Garnet::interpreter::bytecode::Compiler().compile(*ast);
+            if (varmap.contains("debug")) {
+                fmt::print("{}", program);
+            }
+            vm.run(program);
+        } else {
+            ast->accept(*interpreter);
+        }
     } catch (Garnet::interpreter::InterpreterError& e) {
         fmt::println(std::cerr, "interpreter error: {}", typeid(e));
         auto loc = e.location();
@@ -115,8 +182,30 @@ int main(int argc, char* argv[]) {
             fmt::println(std::cerr, "{}", fmt::streamed(e.trace()));
         }
     }
-    if (varmap.contains("debug")) {
-        interpreter.debug_print();
+    if (profiler.has_value()) {
+        profiler->stop();
+        std::ofstream out(varmap["profile"].as<std::string>());
+        profiler->write_folded(out);
+        if (profiler->dropped_count() > 0) {
+            fmt::println(std::cerr, "profiler: {} samples were dropped", profiler->dropped_count());
+        }
+    }
+    if (is_instrumented and engine == "tree" and not is_emitting) {
+        const auto& instrumented = static_cast<const Garnet::interpreter::InstrumentedInterpreter&>(*interpreter);
+        if (varmap.contains("stats")) {
+            instrumented.write_report(std::cerr, varmap["stats-top"].as<std::size_t>());
+        }
+        if (varmap.contains("stats-json")) {
+            std::ofstream out(varmap["stats-json"].as<std::string>());
+            instrumented.write_json(out);
+        }
+    }
+    if (varmap.contains("debug") and not is_emitting) {
+        if (engine == "vm") {
+            vm.debug_print();
+        } else {
+            interpreter->debug_print();
+        }
     }
     return res;
 }
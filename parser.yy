@@ -185,6 +185,8 @@ Garnet::location::SourceRegion conv_loc(const location& l){
 %nterm <std::shared_ptr<GN::ast::Block>> block
 %nterm <std::vector<std::shared_ptr<GN::ast::Sentence>>> sentences
 %nterm <std::shared_ptr<GN::ast::BinaryOperator>> binary_operator
+%nterm <std::shared_ptr<GN::ast::CompoundAssign>> compound_assign
+%nterm <std::shared_ptr<GN::ast::LogicalOperator>> logical_operator
 %nterm <std::shared_ptr<GN::ast::UnaryOperator>> unary_operator
 %nterm <std::shared_ptr<GN::ast::FloatingPointLiteral>> floating_point_literal
 %nterm <std::shared_ptr<GN::ast::SignedIntegerLiteral>> signed_integer_literal
@@ -219,7 +221,7 @@ Garnet::location::SourceRegion conv_loc(const location& l){
 
 
 
-%printer { fmt::print(yyo,"{}",fmt::ptr($$)); } variable_reference unit sentence decl exp stmt variable_decl variable_init binary_operator unary_operator floating_point_literal signed_integer_literal variable_decl_statement decl_or_def function_def function_call return_statement block loop_statement if_statement alone_if_statement break_statement assert_statement callable_exp uncallable_exp string_literal boolean_literal nil_literal for_statement while_statement do_while_statement
+%printer { fmt::print(yyo,"{}",fmt::ptr($$)); } variable_reference unit sentence decl exp stmt variable_decl variable_init binary_operator compound_assign logical_operator unary_operator floating_point_literal signed_integer_literal variable_decl_statement decl_or_def function_def function_call return_statement block loop_statement if_statement alone_if_statement break_statement assert_statement callable_exp uncallable_exp string_literal boolean_literal nil_literal for_statement while_statement do_while_statement
 %printer { 
     std::vector<const void*> ptrs;
     std::ranges::transform($$,std::back_inserter(ptrs),[](auto p){return fmt::ptr(p);});
@@ -326,12 +328,12 @@ const:
 
 variable_decl:
   var_decl {
-      $$ = std::make_shared<GN::ast::VariableDecl>($1.name(), $1.type().name(),std::nullopt,conv_loc(@$));
+      $$ = std::make_shared<GN::ast::VariableDecl>($1.name(), $1.type().name(),std::nullopt,conv_loc(@$),$1.is_const());
     };
 
 variable_init:
   var_decl "=" exp {
-      $$ = std::make_shared<GN::ast::VariableDecl>($1.name(), $1.type().name(),$3,conv_loc(@$));
+      $$ = std::make_shared<GN::ast::VariableDecl>($1.name(), $1.type().name(),$3,conv_loc(@$),$1.is_const());
   }
 
 omittable_ref:
@@ -363,42 +365,28 @@ binary_operator:
 | exp ">=" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::GREATER_EQUAL,$1,$3,conv_loc(@$)); }
 | exp "==" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::EQUAL,$1,$3,conv_loc(@$)); }
 | exp "!=" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::NOT_EQUAL,$1,$3,conv_loc(@$)); }
-| exp "&&" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BOOL_AND,$1,$3,conv_loc(@$)); }
-| exp "and" exp      { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BOOL_AND,$1,$3,conv_loc(@$)); }
 | exp "&" exp        { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BIT_AND,$1,$3,conv_loc(@$)); }
 | exp "bit_and" exp  { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BIT_AND,$1,$3,conv_loc(@$)); }
-| exp "||" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BOOL_OR,$1,$3,conv_loc(@$)); }
-| exp "or" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BOOL_OR,$1,$3,conv_loc(@$)); }
 | exp "|" exp        { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BIT_OR,$1,$3,conv_loc(@$)); }
 | exp "bit_or" exp   { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BIT_OR,$1,$3,conv_loc(@$)); }
 | exp "xor" exp      { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::BIT_XOR,$1,$3,conv_loc(@$)); }
 | exp "<<" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::LEFT_SHIFT,$1,$3,conv_loc(@$)); }
 | exp ">>" exp       { $$ = std::make_shared<GN::ast::BinaryOperator>(GN::ast::BinaryOperator::OperatorType::RIGHT_SHIFT,$1,$3,conv_loc(@$)); }
-| exp "+=" exp       { 
-                        using GN::ast::BinaryOperator; using enum BinaryOperator::OperatorType;
-                        auto right = std::make_shared<BinaryOperator>(ADD,$1,$3,conv_loc(@$));
-                        $$ = std::make_shared<BinaryOperator>(ASSIGN,$1,right,conv_loc(@$)); 
-                     }
-| exp "-=" exp       { 
-                        using GN::ast::BinaryOperator; using enum BinaryOperator::OperatorType;
-                        auto right = std::make_shared<BinaryOperator>(SUB,$1,$3,conv_loc(@$));
-                        $$ = std::make_shared<BinaryOperator>(ASSIGN,$1,right,conv_loc(@$)); 
-                     }
-| exp "*=" exp       { 
-                        using GN::ast::BinaryOperator; using enum BinaryOperator::OperatorType;
-                        auto right = std::make_shared<BinaryOperator>(MUL,$1,$3,conv_loc(@$));
-                        $$ = std::make_shared<BinaryOperator>(ASSIGN,$1,right,conv_loc(@$)); 
-                     }
-| exp "/=" exp       { 
-                        using GN::ast::BinaryOperator; using enum BinaryOperator::OperatorType;
-                        auto right = std::make_shared<BinaryOperator>(DIV,$1,$3,conv_loc(@$));
-                        $$ = std::make_shared<BinaryOperator>(ASSIGN,$1,right,conv_loc(@$)); 
-                     }
-| exp "%=" exp       { 
-                        using GN::ast::BinaryOperator; using enum BinaryOperator::OperatorType;
-                        auto right = std::make_shared<BinaryOperator>(MOD,$1,$3,conv_loc(@$));
-                        $$ = std::make_shared<BinaryOperator>(ASSIGN,$1,right,conv_loc(@$)); 
-                     }
+;
+
+compound_assign:
+  exp "+=" exp       { $$ = std::make_shared<GN::ast::CompoundAssign>(GN::ast::BinaryOperator::OperatorType::ADD,$1,$3,conv_loc(@$)); }
+| exp "-=" exp       { $$ = std::make_shared<GN::ast::CompoundAssign>(GN::ast::BinaryOperator::OperatorType::SUB,$1,$3,conv_loc(@$)); }
+| exp "*=" exp       { $$ = std::make_shared<GN::ast::CompoundAssign>(GN::ast::BinaryOperator::OperatorType::MUL,$1,$3,conv_loc(@$)); }
+| exp "/=" exp       { $$ = std::make_shared<GN::ast::CompoundAssign>(GN::ast::BinaryOperator::OperatorType::DIV,$1,$3,conv_loc(@$)); }
+| exp "%=" exp       { $$ = std::make_shared<GN::ast::CompoundAssign>(GN::ast::BinaryOperator::OperatorType::MOD,$1,$3,conv_loc(@$)); }
+;
+
+logical_operator:
+  exp "&&" exp       { $$ = std::make_shared<GN::ast::LogicalOperator>(GN::ast::LogicalOperator::OperatorType::AND,$1,$3,conv_loc(@$)); }
+| exp "and" exp      { $$ = std::make_shared<GN::ast::LogicalOperator>(GN::ast::LogicalOperator::OperatorType::AND,$1,$3,conv_loc(@$)); }
+| exp "||" exp       { $$ = std::make_shared<GN::ast::LogicalOperator>(GN::ast::LogicalOperator::OperatorType::OR,$1,$3,conv_loc(@$)); }
+| exp "or" exp       { $$ = std::make_shared<GN::ast::LogicalOperator>(GN::ast::LogicalOperator::OperatorType::OR,$1,$3,conv_loc(@$)); }
 ;
 
 unary_operator:
@@ -452,6 +440,8 @@ uncallable_exp:
 | signed_integer_literal { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
 | string_literal         { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
 | binary_operator        { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
+| compound_assign        { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
+| logical_operator       { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
 | unary_operator         { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
 | boolean_literal        { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
 | nil_literal            { $$ = std::dynamic_pointer_cast<GN::ast::Expression>($1); }
@@ -531,82 +521,21 @@ omittable_exp:
 for_statement:
   "for" "(" omittable_variable_init ";" omittable_exp ";" omittable_exp ")" block {
      using namespace GN::ast;
-     auto result = std::make_shared<Block>(conv_loc(@$));
-
-     auto counter_init = $3;
-
-     auto loop_block = std::make_shared<Block>(conv_loc(@$));
-
-     auto break_stmt = std::make_shared<BreakStatement>(conv_loc(@5));
-     auto if_block = std::make_shared<Block>(std::vector<std::shared_ptr<Sentence>>{break_stmt}, conv_loc(@5));
-     std::shared_ptr<Expression> cond;
-     if($5.has_value()){
-        cond = std::make_shared<UnaryOperator>(UnaryOperator::OperatorType::BOOL_NOT, $5.value(), conv_loc(@5));
-     }else{
-        cond = std::make_shared<BooleanLiteral>(true, conv_loc(@5));
-     }
-     auto if_stmt = std::make_shared<IfStatement>(std::vector{IfStatement::CondBlock{.cond=cond,.block=if_block}},conv_loc(@5));
-
-     auto update_counter = $7;
-
-     auto block = $9;
-
-     loop_block->add_sentences({if_stmt,block});
-     if(update_counter.has_value()){
-        loop_block->add_sentence(update_counter.value());
-     }
-     auto loop_stmt = std::make_shared<LoopStatement>(loop_block,conv_loc(@$));
-
-     if(counter_init.has_value()){
-        auto counter_init_stmt = std::make_shared<VariableDeclStatement>(counter_init.value(), conv_loc(@3));
-        result->add_sentence(counter_init_stmt);
+     std::optional<std::shared_ptr<VariableDeclStatement>> init;
+     if($3.has_value()){
+        init = std::make_shared<VariableDeclStatement>($3.value(), conv_loc(@3));
      }
-     result->add_sentence(loop_stmt);
-     $$ = result;
+     $$ = std::make_shared<ForStatement>(init,$5,$7,$9,conv_loc(@$));
   }
 
 while_statement:
   "while" "("exp ")" block {
-     using namespace GN::ast;
-     auto result = std::make_shared<Block>(conv_loc(@$));
-
-     auto loop_block = std::make_shared<Block>(conv_loc(@$));
-
-     auto break_stmt = std::make_shared<BreakStatement>(conv_loc(@3));
-     auto if_block = std::make_shared<Block>(std::vector<std::shared_ptr<Sentence>>{break_stmt}, conv_loc(@3));
-     std::shared_ptr<Expression> cond;
-     cond = std::make_shared<UnaryOperator>(UnaryOperator::OperatorType::BOOL_NOT, $3, conv_loc(@3));
-     auto if_stmt = std::make_shared<IfStatement>(std::vector{IfStatement::CondBlock{.cond=cond,.block=if_block}},conv_loc(@3));
-
-     auto block = $5;
-
-     loop_block->add_sentences({if_stmt,block});
-     auto loop_stmt = std::make_shared<LoopStatement>(loop_block,conv_loc(@$));
-
-     result->add_sentence(loop_stmt);
-     $$ = result;
+     $$ = std::make_shared<GN::ast::WhileStatement>($3,$5,conv_loc(@$));
   }
 
 do_while_statement:
   "do" block "while" "(" exp ")" {
-     using namespace GN::ast;
-     auto result = std::make_shared<Block>(conv_loc(@$));
-
-     auto loop_block = std::make_shared<Block>(conv_loc(@$));
-
-     auto break_stmt = std::make_shared<BreakStatement>(conv_loc(@5));
-     auto if_block = std::make_shared<Block>(std::vector<std::shared_ptr<Sentence>>{break_stmt}, conv_loc(@5));
-     std::shared_ptr<Expression> cond;
-     cond = std::make_shared<UnaryOperator>(UnaryOperator::OperatorType::BOOL_NOT, $5, conv_loc(@5));
-     auto if_stmt = std::make_shared<IfStatement>(std::vector{IfStatement::CondBlock{.cond=cond,.block=if_block}},conv_loc(@5));
-
-     auto block = $2;
-
-     loop_block->add_sentences({block,if_stmt});
-     auto loop_stmt = std::make_shared<LoopStatement>(loop_block,conv_loc(@$));
-
-     result->add_sentence(loop_stmt);
-     $$ = result;
+     $$ = std::make_shared<GN::ast::DoWhileStatement>($2,$5,conv_loc(@$));
   }
 
 %%
@@ -37,10 +37,15 @@
 # include <climits>
 # include <cstdlib>
 # include <cstring> // strerror
+# include <charconv>
+# include <memory>
 # include <string>
+# include <string_view>
+# include <system_error>
 # include <fmt/format.h>
 # include <algorithm>
 # include "driver.hpp"
+# include "mapped_file.hpp"
 # include "parser.hpp"
 # include "mudig_converter.hpp"
 # include "enums.hpp"
@@ -121,12 +126,13 @@
 
 %{
   // A number symbol corresponding to the value in S.
+  // S is a view of the matched text, so no temporary string is built.
     Garnet::yy::Parser::symbol_type
-  make_INTEGER (const std::string &s, const Garnet::yy::Parser::location_type& loc);
+  make_INTEGER (std::string_view s, const Garnet::yy::Parser::location_type& loc);
     Garnet::yy::Parser::symbol_type
-  make_FLOAT (const std::string &s, const Garnet::yy::Parser::location_type& loc);
+  make_FLOAT (std::string_view s, const Garnet::yy::Parser::location_type& loc);
     Garnet::yy::Parser::symbol_type
-  make_STRING (const std::string &s, const Garnet::yy::Parser::location_type& loc);
+  make_STRING (std::string_view s, const Garnet::yy::Parser::location_type& loc);
     Garnet::yy::Parser::symbol_type
   make_VALREF (const std::string &s, const Garnet::yy::Parser::location_type& loc);
 %}
@@ -227,11 +233,11 @@ string    \"([^\"]|\\\")*\"
 "nil"        return Garnet::yy::Parser::make_NIL                      (loc);
 "do"         return Garnet::yy::Parser::make_DO                       (loc);
 
-{float}      return make_FLOAT (yytext, loc);
-{int}        return make_INTEGER (yytext, loc);
-{id}         return Garnet::yy::Parser::make_IDENTIFIER (yytext, loc);
+{float}      return make_FLOAT (std::string_view (yytext, yyleng), loc);
+{int}        return make_INTEGER (std::string_view (yytext, yyleng), loc);
+{id}         return Garnet::yy::Parser::make_IDENTIFIER (std::string (yytext, yyleng), loc);
 {refval}     return make_VALREF (yytext, loc);
-{string}     return make_STRING(yytext, loc);
+{string}     return make_STRING (std::string_view (yytext, yyleng), loc);
 .            {
                  throw Garnet::yy::Parser::syntax_error
                  (loc, "invalid character: " + std::string(yytext));
@@ -240,21 +246,31 @@ string    \"([^\"]|\\\")*\"
 %%
 
 Garnet::yy::Parser::symbol_type
-make_INTEGER (const std::string &s, const Garnet::yy::Parser::location_type& loc)
+make_INTEGER (std::string_view s, const Garnet::yy::Parser::location_type& loc)
 {
-  return Garnet::yy::Parser::make_INTEGER (static_cast<int64_t>(std::stoll(s)), loc);
+  int64_t value = 0;
+  auto [end, ec] = std::from_chars (s.data (), s.data () + s.size (), value);
+  if (ec != std::errc () || end != s.data () + s.size ())
+    throw Garnet::yy::Parser::syntax_error (loc, fmt::format ("integer literal out of range: {}", s));
+  return Garnet::yy::Parser::make_INTEGER (value, loc);
 }
 
 Garnet::yy::Parser::symbol_type
-make_FLOAT (const std::string &s, const Garnet::yy::Parser::location_type& loc)
+make_FLOAT (std::string_view s, const Garnet::yy::Parser::location_type& loc)
 {
-    return Garnet::yy::Parser::make_FLOAT (static_cast<double>(std::stod(s)), loc);
+    double value = 0;
+    auto [end, ec] = std::from_chars (s.data (), s.data () + s.size (), value);
+    if (ec != std::errc () || end != s.data () + s.size ())
+      throw Garnet::yy::Parser::syntax_error (loc, fmt::format ("floating point literal out of range: {}", s));
+    return Garnet::yy::Parser::make_FLOAT (value, loc);
 }
 
+// The value of the token outlives the source buffer, so the contents
+// between the quotes are copied exactly once.
 Garnet::yy::Parser::symbol_type
-make_STRING (const std::string &s, const Garnet::yy::Parser::location_type& loc)
+make_STRING (std::string_view s, const Garnet::yy::Parser::location_type& loc)
 {
-    return Garnet::yy::Parser::make_STRING (s.substr(1,s.size()-2), loc);
+    return Garnet::yy::Parser::make_STRING (std::string (s.substr (1, s.size () - 2)), loc);
 }
 
 Garnet::yy::Parser::symbol_type
@@ -275,16 +291,37 @@ Garnet::Driver::scan_begin ()
 {
   lexer_->set_debug(trace_scanning);
   if (file_.empty () || file_ == "-")
-    lexer_->in() = stdin;
-  else if (!(lexer_->in()= fopen (file_.c_str (), "r")))
     {
-      std::cerr << "cannot open " << file_ << ": " << strerror (errno) << '\n';
+      lexer_->in() = stdin;
+      return;
+    }
+  try
+    {
+      source_ = std::make_unique<Garnet::MappedFile> (file_);
+    }
+  catch (const std::system_error& e)
+    {
+      report_ ("cannot open " + file_ + ": " + e.code ().message () + '\n');
+      // When buffering, the caller writes the diagnostics in order and exits.
+      if (is_buffering_)
+        throw;
       exit (EXIT_FAILURE);
     }
+  // Scan the mapped contents directly instead of reading through stdio.
+  // in(input) also resets the matcher, which otherwise keeps reading the
+  // input it was created with (a file already unmapped if the driver is reused).
+  lexer_->in (reflex::Input (source_->data (), source_->size ()));
 }
 
 void
 Garnet::Driver::scan_end ()
 {
-    fclose(lexer_->in());
+    if (source_ == nullptr)
+      {
+        fclose(lexer_->in());
+        return;
+      }
+    // Detach the matcher from the mapping before unmapping it.
+    lexer_->in (reflex::Input ());
+    source_.reset ();
 }